@@ -82,10 +82,11 @@ private:
 
 /**
  * Class constructor.
+ * @param  cache   The project's scan cache
  * @param  parent  Parent widget
  */
-AddFilesDialog::AddFilesDialog(QWidget* parent) : QDialog(parent),
-                                                  Ui::AddFilesDialog()
+AddFilesDialog::AddFilesDialog(const Core::ScanCache& cache, QWidget* parent)
+	: QDialog(parent), Ui::AddFilesDialog(), cache_(cache)
 {
 	setupUi(this);
 }
@@ -244,6 +245,10 @@ void AddFilesDialog::addTree(bool recursive)
 	Core::FileScanner scanner(this);
 	scanner.setProgressMessage(tr("Found %2 of %1 files"));
 
+	// Use the scan cache, so that directories that were not modified since
+	// the last scan are skipped.
+	scanner.setCache(&cache_);
+
 	// Create a modal progress dialogue.
 	// This will be used to display progress information, as well as allow the
 	// user to cancel scanning.
@@ -257,8 +262,11 @@ void AddFilesDialog::addTree(bool recursive)
 	QString filter = filterEdit_->text();
 
 	// Scan for files.
-	if (scanner.scan(list.first(), Core::FileFilter(filter), recursive))
-		fileList_->addItems(scanner.matchedFiles());
+	if (!scanner.scan(list.first(), Core::FileFilter(filter), recursive))
+		return;
+
+	fileList_->addItems(scanner.matchedFiles());
+	removedList_ += scanner.removedFiles();
 }
 
 }
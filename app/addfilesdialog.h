@@ -23,6 +23,7 @@
 
 #include <QDialog>
 #include <QFileDialog>
+#include <core/scancache.h>
 #include "ui_addfilesdialog.h"
 
 namespace KScope
@@ -40,11 +41,23 @@ class AddFilesDialog : public QDialog, public Ui::AddFilesDialog
 	Q_OBJECT
 
 public:
-	AddFilesDialog(QWidget* parent = NULL);
+	AddFilesDialog(const Core::ScanCache&, QWidget* parent = NULL);
 	~AddFilesDialog();
 
 	void fileList(QStringList&) const;
 
+	/**
+	 * @return The scan cache, updated with the results of the scans made by
+	 *         this dialogue
+	 */
+	const Core::ScanCache& cache() const { return cache_; }
+
+	/**
+	 * @return Files found by re-scanning directories to no longer exist (or
+	 *         to no longer match the filter)
+	 */
+	const QStringList& removedFileList() const { return removedList_; }
+
 protected slots:
 	void addFiles();
 	void addDir();
@@ -54,6 +67,17 @@ protected slots:
 	void deleteSelectedFiles();
 
 private:
+	/**
+	 * Files found to be removed since the last scan of the same directory.
+	 */
+	QStringList removedList_;
+
+	/**
+	 * A copy of the project's scan cache, so that scans made by a dialogue
+	 * that is later cancelled are not recorded.
+	 */
+	Core::ScanCache cache_;
+
 	bool getFiles(QFileDialog::FileMode, QStringList&);
 	void addTree(bool);
 };
@@ -1,7 +1,7 @@
 include(../config)
 TEMPLATE = app
 TARGET = kscopeapp
-DEPENDPATH += ". ../core ../cscope ../editor"
+DEPENDPATH += ". ../core ../cscope ../native ../editor"
 
 # Input
 SOURCES += openprojectdialog.cpp \
@@ -57,6 +57,8 @@ LIBS += -L../core \
     -lkscope_core \
     -L../cscope \
     -lkscope_cscope \
+    -L../native \
+    -lkscope_native \
     -L../editor \
     -lkscope_editor \
     -L$${QSCI_ROOT_PATH}/lib64 \
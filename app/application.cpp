@@ -20,6 +20,7 @@
 
 #include <QMessageBox>
 #include <cscope/managedproject.h>
+#include <native/index.h>
 #include "application.h"
 #include "mainwindow.h"
 #include "projectmanager.h"
@@ -131,7 +132,7 @@ void Application::init()
 
 			case 'p':
 				path = args.takeFirst();
-				ProjectManager::load<Cscope::ManagedProject>(path);
+				ProjectManager::loadManaged(path);
 				return;
 			}
 		}
@@ -143,11 +144,24 @@ void Application::init()
 	mainWnd_->openProject();
 }
 
+/**
+ * Applies the stored configuration to all engines.
+ */
 void Application::setupEngines()
 {
 	// TODO: We'd like a list of engines that can be iterated over in compile
 	// time to generate multi-engine code.
-	typedef Core::EngineConfig<Cscope::Crossref> Config;
+	setupEngine<Cscope::Crossref>();
+	setupEngine<Native::Index>();
+}
+
+/**
+ * Applies the stored configuration to an engine.
+ */
+template<class EngineT>
+void Application::setupEngine()
+{
+	typedef Core::EngineConfig<EngineT> Config;
 
 	// Prefix group with "Engine_" so that engines do not overrun application
 	// groups by accident.
@@ -68,6 +68,9 @@ private:
 
 	void init();
 	void setupEngines();
+
+	template<class EngineT>
+	void setupEngine();
 };
 
 inline Application* theApp() { return static_cast<Application*>(qApp); }
@@ -79,11 +79,16 @@ public:
 		return dlg_;
 	}
 
+	/**
+	 * @return true if a build is in progress, false otherwise
+	 */
+	bool isActive() const { return dlg_ != NULL || bar_ != NULL; }
+
 	/**
 	 * Does nothing, as no data is expected from a build process.
 	 * @param  locList  ignored
 	 */
-	void onDataReady(const Core::LocationList& locList) {
+	void onDataReady(const Core::CompactLocationList& locList) {
 		(void)locList;
 	}
 
@@ -99,6 +104,7 @@ public:
 
 		dlg_ = NULL;
 		bar_ = NULL;
+		emit finished();
 	}
 
 	/**
@@ -134,6 +140,12 @@ public:
 		}
 	}
 
+signals:
+	/**
+	 * Emitted when a build completes successfully.
+	 */
+	void finished();
+
 private:
 	/**
 	 * A progress dialogue.
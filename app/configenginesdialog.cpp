@@ -20,6 +20,7 @@
 
 #include <QLabel>
 #include <cscope/crossref.h>
+#include <native/index.h>
 #include "application.h"
 #include "configenginesdialog.h"
 
@@ -40,7 +41,37 @@ ConfigEnginesDialog::ConfigEnginesDialog(QWidget* parent)
 
 	// TODO: We'd like a list of engines that can be iterated over in compile
 	// time to generate multi-engine code.
-	typedef Core::EngineConfig<Cscope::Crossref> Config;
+	addEngine<Cscope::Crossref>();
+	addEngine<Native::Index>();
+}
+
+/**
+ * Class destructor.
+ */
+ConfigEnginesDialog::~ConfigEnginesDialog()
+{
+}
+
+/**
+ * Called when the user clicks the "OK" button.
+ * Applies the configuration to the engines, and exits the dialogue.
+ */
+void ConfigEnginesDialog::accept()
+{
+	// The order must match the one used in the constructor.
+	applyConfig<Cscope::Crossref>(tabWidget_->widget(0));
+	applyConfig<Native::Index>(tabWidget_->widget(1));
+
+	QDialog::accept();
+}
+
+/**
+ * Adds a configuration page for an engine.
+ */
+template<class EngineT>
+void ConfigEnginesDialog::addEngine()
+{
+	typedef Core::EngineConfig<EngineT> Config;
 
 	QWidget* widget = Config::createConfigWidget(this);
 	QString title;
@@ -56,24 +87,16 @@ ConfigEnginesDialog::ConfigEnginesDialog(QWidget* parent)
 }
 
 /**
- * Class destructor.
- */
-ConfigEnginesDialog::~ConfigEnginesDialog()
-{
-}
-
-/**
- * Called when the user clicks the "OK" button.
- * Applies the configuration to the engines, and exits the dialogue.
+ * Applies the configuration on an engine's page, and stores it.
+ * @param  widget  The configuration page for the engine
  */
-void ConfigEnginesDialog::accept()
+template<class EngineT>
+void ConfigEnginesDialog::applyConfig(QWidget* widget)
 {
-	// TODO: We'd like a list of engines that can be iterated over in compile
-	// time to generate multi-engine code.
-	typedef Core::EngineConfig<Cscope::Crossref> Config;
+	typedef Core::EngineConfig<EngineT> Config;
 
 	// Apply configuration to the engine.
-	Config::configFromWidget(tabWidget_->widget(0));
+	Config::configFromWidget(widget);
 
 	// Get the new set of parameters.
 	Core::KeyValuePairs params;
@@ -91,8 +114,6 @@ void ConfigEnginesDialog::accept()
 		settings.setValue(itr.key(), itr.value());
 
 	settings.endGroup();
-
-	QDialog::accept();
 }
 
 } // namespace App
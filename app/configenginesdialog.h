@@ -45,6 +45,13 @@ public:
 
 public slots:
 	void accept();
+
+private:
+	template<class EngineT>
+	void addEngine();
+
+	template<class EngineT>
+	void applyConfig(QWidget*);
 };
 
 } // namespace App
@@ -311,7 +311,7 @@ void EditorContainer::browseHistory()
 	// Add location history entries to the model.
 	Core::QueryView* view = dlg.view();
 	Core::LocationModel* model = view->locationModel();
-	model->add(history_.list(), QModelIndex());
+	model->add(Core::CompactLocationList(history_.list()), QModelIndex());
 
 	// Setup the model's displayed columns.
 	QList<Core::Location::Fields> columns;
@@ -45,7 +45,8 @@ namespace App
 /**
  * Class constructor.
  */
-MainWindow::MainWindow() : QMainWindow(), actions_(this)
+MainWindow::MainWindow() : QMainWindow(), actions_(this),
+	rebuildPending_(false)
 {
 	// Set the window title.
 	// This changes whenever a project is opened/closed.
@@ -85,6 +86,16 @@ MainWindow::MainWindow() : QMainWindow(), actions_(this)
 	// Rebuild the project when signalled by the project manager.
 	connect(ProjectManager::signalProxy(), SIGNAL(buildProject()), this,
 	        SLOT(buildProject()));
+
+	// Update the project in the background when source files change.
+	connect(ProjectManager::signalProxy(), SIGNAL(filesModified()), this,
+	        SLOT(autoRebuild()));
+
+	// Files modified during a build require another one once it completes.
+	// The connection is queued, as the engine may only update its status after
+	// notifying the build's connection object.
+	connect(&buildProgress_, SIGNAL(finished()), this, SLOT(buildFinished()),
+	        Qt::QueuedConnection);
 }
 
 /**
@@ -280,7 +291,7 @@ void MainWindow::newProject()
 		proj.create(params);
 
 		// Load the new project.
-		ProjectManager::load<Cscope::ManagedProject>(params.projPath_);
+		ProjectManager::loadManaged(params.projPath_);
 	}
 	catch (Core::Exception* e) {
 		e->showMessage();
@@ -312,7 +323,7 @@ void MainWindow::openProject()
 	switch (dlg.exec()) {
 	case OpenProjectDialog::Open:
 		try {
-			ProjectManager::load<Cscope::ManagedProject>(dlg.path());
+			ProjectManager::loadManaged(dlg.path());
 		}
 		catch (Core::Exception* e) {
 			e->showMessage();
@@ -381,15 +392,16 @@ void MainWindow::projectFiles()
 void MainWindow::projectProperties()
 {
 	// Get the active project.
-	const Cscope::ManagedProject* project
-		= dynamic_cast<const Cscope::ManagedProject*>
-			(ProjectManager::project());
-	if (project == NULL)
+	// Managed projects share the same parameters, regardless of the engine
+	// in use.
+	if (!ProjectManager::hasProject())
 		return;
 
+	const Core::ProjectBase* project = ProjectManager::project();
+
 	// Create the project properties dialogue.
 	ProjectDialog dlg(this);
-	dlg.setParamsForProject(project);
+	dlg.setParamsForProject<Cscope::ManagedProject>(project);
 	if (dlg.exec() == QDialog::Rejected)
 		return;
 
@@ -524,6 +536,43 @@ void MainWindow::projectOpenedClosed(bool opened)
 	}
 }
 
+/**
+ * Starts a background rebuild after source files were modified.
+ * If a build is already in progress, the rebuild is deferred until it
+ * completes.
+ */
+void MainWindow::autoRebuild()
+{
+	if (buildProgress_.isActive()) {
+		rebuildPending_ = true;
+		return;
+	}
+
+	rebuildPending_ = false;
+
+	try {
+		if (ProjectManager::engine().status() != Core::Engine::Rebuild)
+			return;
+	}
+	catch (Core::Exception* e) {
+		delete e;
+		return;
+	}
+
+	buildProject();
+}
+
+/**
+ * Called when a build completes.
+ * Rebuilds the project if source files were modified while the build was
+ * running, and the engine still reports the database as out of date.
+ */
+void MainWindow::buildFinished()
+{
+	if (rebuildPending_)
+		autoRebuild();
+}
+
 } // namespace App
 
 } // namespace KScope
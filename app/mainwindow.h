@@ -100,12 +100,19 @@ private:
 	 */
 	BuildProgress buildProgress_;
 
+	/**
+	 * Whether source files were modified while a build was in progress.
+	 */
+	bool rebuildPending_;
+
 	void readSettings();
 	void writeSettings();
 	void setWindowTitle(bool);
 
 private slots:
 	void projectOpenedClosed(bool);
+	void autoRebuild();
+	void buildFinished();
 };
 
 } // namespace App
@@ -50,7 +50,7 @@ public:
 	 *               project
 	 */
 	template <class ProjectT>
-	void setParamsForProject(const ProjectT* proj) {
+	void setParamsForProject(const Core::ProjectBase* proj) {
 		if (proj) {
 			// Display properties for an existing project.
 			setWindowTitle(tr("Project Properties"));
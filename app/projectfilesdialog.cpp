@@ -18,6 +18,7 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
+#include <QDir>
 #include <core/codebasemodel.h>
 #include "application.h"
 #include "projectfilesdialog.h"
@@ -30,8 +31,13 @@ namespace KScope
 namespace App
 {
 
+/**
+ * The name of the scan cache file in the project directory.
+ */
+static const char* ScanCacheName = "kscope.scancache";
+
 ProjectFilesDialog::ProjectFilesDialog(QWidget* parent)
-	: QDialog(parent), Ui::ProjectFilesDialog()
+	: QDialog(parent), Ui::ProjectFilesDialog(), cacheModified_(false)
 {
 	setupUi(this);
 
@@ -42,6 +48,11 @@ ProjectFilesDialog::ProjectFilesDialog(QWidget* parent)
 		Core::CodebaseModel* model
 			= new Core::CodebaseModel(codebase, proj->rootPath(), this);
 		view_->setModel(model);
+
+		// Use the project's scan cache, so that directories that were not
+		// modified since the last scan are skipped.
+		cachePath_ = QDir(proj->path()).filePath(ScanCacheName);
+		cache_.load(cachePath_);
 	}
 	catch (Core::Exception* e) {
 		e->showMessage();
@@ -62,8 +73,12 @@ void ProjectFilesDialog::accept()
 	model->getFiles(fileList);
 
 	// Update the code base.
+	// The scan cache is only stored once the results of the scans have been
+	// applied, as these serve as the baseline for reporting removed files.
 	try {
 		ProjectManager::codebase().setFiles(fileList);
+		if (cacheModified_ && !cachePath_.isEmpty())
+			cache_.save(cachePath_);
 	}
 	catch (Core::Exception* e) {
 		e->showMessage();
@@ -75,14 +90,19 @@ void ProjectFilesDialog::accept()
 
 void ProjectFilesDialog::addFiles()
 {
-	AddFilesDialog dlg(this);
+	AddFilesDialog dlg(cache_, this);
 	if (dlg.exec() == QDialog::Accepted) {
 		QStringList fileList;
 		dlg.fileList(fileList);
 
 		Core::CodebaseModel* model
 			= static_cast<Core::CodebaseModel*>(view_->model());
+		if (!dlg.removedFileList().isEmpty())
+			model->removeFiles(dlg.removedFileList());
 		model->addFiles(fileList);
+
+		cache_ = dlg.cache();
+		cacheModified_ = true;
 	}
 }
 
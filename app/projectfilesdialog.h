@@ -22,6 +22,7 @@
 #define __KSCOPE_PROJECTFILESDIALOG_H__
 
 #include <QDialog>
+#include <core/scancache.h>
 #include "ui_projectfilesdialog.h"
 
 namespace KScope
@@ -44,6 +45,22 @@ public slots:
 protected slots:
 	void addFiles();
 	void removeFiles();
+
+private:
+	/**
+	 * The project's scan cache.
+	 */
+	Core::ScanCache cache_;
+
+	/**
+	 * The path of the scan cache file, empty if there is no project.
+	 */
+	QString cachePath_;
+
+	/**
+	 * Whether files were added using a scan since the dialogue was opened.
+	 */
+	bool cacheModified_;
 };
 
 }
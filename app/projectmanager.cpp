@@ -18,7 +18,10 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
+#include <QDebug>
 #include <core/exception.h>
+#include <cscope/managedproject.h>
+#include <native/managedproject.h>
 #include "projectmanager.h"
 
 namespace KScope
@@ -29,6 +32,24 @@ namespace App
 
 Core::ProjectBase* ProjectManager::proj_ = NULL;
 ProjectManagerSignals ProjectManager::signals_;
+Core::CodebaseWatcher* ProjectManager::watcher_ = NULL;
+
+/**
+ * Forwards change notifications from the code base watcher.
+ * @param  files  The changed files
+ */
+void ProjectManagerSignals::filesChanged(const QStringList& files)
+{
+	ProjectManager::filesChanged(files);
+}
+
+/**
+ * Updates the watched files when the code base changes.
+ */
+void ProjectManagerSignals::codebaseModified()
+{
+	ProjectManager::watchCodebase();
+}
 
 const Core::ProjectBase* ProjectManager::project()
 {
@@ -67,6 +88,21 @@ const ProjectManagerSignals* ProjectManager::signalProxy()
 	return &signals_;
 }
 
+/**
+ * Loads a managed project.
+ * The project is indexed either by Cscope or by the native engine, according
+ * to the engine configuration.
+ * @param  projPath  The project directory
+ * @throw  Exception
+ */
+void ProjectManager::loadManaged(const QString& projPath)
+{
+	if (Native::Index::enabled_)
+		load<Native::ManagedProject>(projPath);
+	else
+		load<Cscope::ManagedProject>(projPath);
+}
+
 void ProjectManager::updateConfig(Core::ProjectBase::Params& params)
 {
 	// Make sure a project is loaded.
@@ -91,6 +127,10 @@ void ProjectManager::close()
 	if (proj_ == NULL)
 		return;
 
+	// Stop monitoring source files.
+	delete watcher_;
+	watcher_ = NULL;
+
 	// Close the project.
 	proj_->close();
 	delete proj_;
@@ -113,6 +153,48 @@ void ProjectManager::finishLoad()
 			signals_.emitBuildProject();
 		}
 	}
+
+	// Monitor source files for changes.
+	Core::Codebase* cbase = proj_->codebase();
+	if (cbase) {
+		QObject::connect(cbase, SIGNAL(modified()), &signals_,
+		                 SLOT(codebaseModified()));
+		watchCodebase();
+	}
+}
+
+/**
+ * Watches the files of the current project's code base for changes.
+ */
+void ProjectManager::watchCodebase()
+{
+	Core::Codebase* cbase = proj_ ? proj_->codebase() : NULL;
+	if (cbase == NULL)
+		return;
+
+	if (watcher_ == NULL) {
+		watcher_ = new Core::CodebaseWatcher();
+		QObject::connect(watcher_, SIGNAL(changed(const QStringList&)),
+		                 &signals_, SLOT(filesChanged(const QStringList&)));
+	}
+
+	watcher_->watch(*cbase, proj_->path());
+}
+
+/**
+ * Called when files in the code base are modified.
+ * Marks the database as out of date, and requests a rebuild.
+ * @param  files  The changed files
+ */
+void ProjectManager::filesChanged(const QStringList& files)
+{
+	Core::Engine* engine = proj_ ? proj_->engine() : NULL;
+	if (engine == NULL)
+		return;
+
+	qDebug() << files.size() << "source files changed";
+	engine->invalidate();
+	signals_.emitFilesModified();
 }
 
 } // namespace App
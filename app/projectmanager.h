@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include <core/project.h>
+#include <core/codebasewatcher.h>
 #include "application.h"
 
 namespace KScope
@@ -44,6 +45,7 @@ class ProjectManagerSignals : public QObject
 signals:
 	void hasProject(bool has);
 	void buildProject();
+	void filesModified();
 
 private:
 	ProjectManagerSignals() : QObject() {}
@@ -56,7 +58,15 @@ private:
 		emit buildProject();
 	}
 
+	void emitFilesModified() {
+		emit filesModified();
+	}
+
 	friend class ProjectManager;
+
+private slots:
+	void filesChanged(const QStringList&);
+	void codebaseModified();
 };
 
 /**
@@ -94,6 +104,7 @@ public:
 		Application::settings().addRecentProject(projPath, proj_->name());
 	}
 
+	static void loadManaged(const QString&);
 	static void updateConfig(Core::ProjectBase::Params&);
 	static void close();
 
@@ -101,7 +112,14 @@ private:
 	static Core::ProjectBase* proj_;
 	static ProjectManagerSignals signals_;
 
+	/**
+	 * Monitors the project's source files for changes.
+	 */
+	static Core::CodebaseWatcher* watcher_;
+
 	static void finishLoad();
+	static void watchCodebase();
+	static void filesChanged(const QStringList&);
 
 	struct OpenCallback : public Core::Callback<>
 	{
@@ -110,6 +128,8 @@ private:
 			delete this;
 		}
 	};
+
+	friend class ProjectManagerSignals;
 };
 
 } // namespace App
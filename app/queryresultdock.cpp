@@ -21,6 +21,7 @@
 #include "queryresultdock.h"
 #include "projectmanager.h"
 #include "strings.h"
+#include "application.h"
 
 namespace KScope
 {
@@ -156,6 +157,9 @@ QueryView* QueryResultDock::addView(const QString& title,
 	if (type == Core::QueryView::List)
 		view->setAutoSelectSingleResult(true);
 
+	// Set the number of call-tree levels queried in the background.
+	view->setPrefetchDepth(Application::settings().prefetchDepth());
+
 	// Add to the tab widget.
 	tabWidget()->addWidget(view);
 	return view;
@@ -19,7 +19,9 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QBuffer>
 #include <core/exception.h>
+#include <core/locationstream.h>
 #include "session.h"
 #include "projectmanager.h"
 
@@ -29,20 +31,35 @@ namespace KScope
 namespace App
 {
 
+/**
+ * Identifies binary query view files.
+ */
+static const quint32 QueryViewMagic = 0x4b535156;
+
+/**
+ * Incremented whenever the binary query view file format changes.
+ */
+static const quint32 QueryViewVersion = 1;
+
 /**
  * Class constructor.
  * @param  path  The path of the configuration directory
  */
 Session::Session(const QString& path)
-	: path_(path), queryViewDoc_("QueryViews")
+	: path_(path), queryViewDoc_("QueryViews"), viewFile_(NULL),
+	  viewSaveFile_(NULL)
 {
+	viewStrm_.setVersion(QDataStream::Qt_4_5);
 }
 
 /**
  * Class destructor.
+ * Query views added to a session that was not saved are discarded.
  */
 Session::~Session()
 {
+	delete viewFile_;
+	delete viewSaveFile_;
 }
 
 /**
@@ -71,8 +88,27 @@ void Session::load()
 	activeEditor_ = settings.value("ActiveEditor").toString();
 	maxActiveEditor_ = settings.value("MaxActiveEditor", false).toBool();
 
-	// Load the query XML file.
-	QFile xmlFile(queryViewFile());
+	// Open the binary query view file.
+	// The views are read by a QueryViewIterator object.
+	viewFile_ = new QFile(queryViewFile());
+	if (viewFile_->open(QIODevice::ReadOnly)) {
+		viewStrm_.setDevice(viewFile_);
+
+		quint32 magic, version;
+		viewStrm_ >> magic >> version;
+		if ((viewStrm_.status() == QDataStream::Ok)
+		    && (magic == QueryViewMagic) && (version == QueryViewVersion)) {
+			return;
+		}
+
+		viewStrm_.setDevice(NULL);
+	}
+
+	delete viewFile_;
+	viewFile_ = NULL;
+
+	// Load a query XML file stored by an older version.
+	QFile xmlFile(xmlQueryViewFile());
 	if (xmlFile.open(QIODevice::ReadOnly))
 		queryViewDoc_.setContent(xmlFile.readAll());
 }
@@ -101,38 +137,75 @@ void Session::save()
 	settings.setValue("ActiveEditor", activeEditor_);
 	settings.setValue("MaxActiveEditor", maxActiveEditor_);
 
-	// Save the query view XML document.
-	QFile xmlFile(queryViewFile());
-	if (xmlFile.open(QIODevice::WriteOnly))
-		xmlFile.write(queryViewDoc_.toByteArray());
+	// Complete the query view file.
+	if (!openViewSaveFile())
+		return;
+
+	QDataStream strm(viewSaveFile_);
+	strm.setVersion(QDataStream::Qt_4_5);
+	strm << (quint8)0;
+	if ((strm.status() == QDataStream::Ok) && viewSaveFile_->commit()) {
+		// The XML file stored by older versions is no longer needed.
+		QFile::remove(xmlQueryViewFile());
+	}
+
+	delete viewSaveFile_;
+	viewSaveFile_ = NULL;
 }
 
 /**
- * Creates an XML representation of a query view.
- * The representation is rooted at a "QueryView" element, which holds a
- * "Query" element for query information, and "Location" elements for query
- * results.
+ * Writes a binary representation of a query view to the query view file.
+ * Each view is written as a separate block, holding the title and type of the
+ * view, followed by the representation created by QueryView::toStream().
+ * Strings are interned per block.
  * @param view
  */
 void Session::addQueryView(const QueryView* view)
 {
-	// Get the root element.
-	// Create one if it does not exists.
-	QDomElement root = queryViewDoc_.documentElement();
-	if (root.isNull()) {
-		root = 	queryViewDoc_.createElement("Queries");
-		queryViewDoc_.appendChild(root);
+	if (!openViewSaveFile())
+		return;
+
+	// Create the block.
+	QByteArray block;
+	QBuffer buf(&block);
+	buf.open(QIODevice::WriteOnly);
+	Core::LocationStream viewStrm(&buf);
+	viewStrm.stream() << view->windowTitle() << (quint32)view->type();
+	view->toStream(viewStrm);
+	buf.close();
+
+	// Write it to the file.
+	QDataStream strm(viewSaveFile_);
+	strm.setVersion(QDataStream::Qt_4_5);
+	strm << (quint8)1 << block;
+}
+
+/**
+ * Creates the query view file for storing the session, if not already
+ * created.
+ * @return true if successful, false otherwise
+ */
+bool Session::openViewSaveFile()
+{
+	if (viewSaveFile_ != NULL)
+		return true;
+
+	viewSaveFile_ = new QSaveFile(queryViewFile());
+	if (!viewSaveFile_->open(QIODevice::WriteOnly)) {
+		delete viewSaveFile_;
+		viewSaveFile_ = NULL;
+		return false;
 	}
 
-	// Put location information under the element.
-	QDomElement viewElem = queryViewDoc_.createElement("QueryView");
-	root.appendChild(viewElem);
-	view->toXML(queryViewDoc_, viewElem);
+	QDataStream strm(viewSaveFile_);
+	strm.setVersion(QDataStream::Qt_4_5);
+	strm << QueryViewMagic << QueryViewVersion;
+	return true;
 }
 
 /**
- * Creates an iterator that is used for loading query views from an XML
- * representation.
+ * Creates an iterator that is used for loading query views from the binary
+ * query view file, or from an XML representation stored by older versions.
  * Once an iterator has been created, a view object can use its load() method
  * to get the query information and locations.
  * @return
@@ -141,6 +214,13 @@ Session::QueryViewIterator Session::beginQueryIteration() const
 {
 	QueryViewIterator itr;
 
+	// Read views from the binary file, if it was loaded.
+	if (viewFile_ != NULL) {
+		itr.strm_ = &viewStrm_;
+		++itr;
+		return itr;
+	}
+
 	QDomElement root = queryViewDoc_.documentElement();
 	itr.queryNodeList_ = root.elementsByTagName("QueryView");
 	itr.listPos_ = -1;
@@ -149,8 +229,66 @@ Session::QueryViewIterator Session::beginQueryIteration() const
 	return itr;
 }
 
+/**
+ * Advances to the next query view.
+ * @return A reference to this object
+ */
+Session::QueryViewIterator& Session::QueryViewIterator::operator++()
+{
+	if (strm_ != NULL) {
+		// Read the next block, and the title and type of the view.
+		quint8 more = 0;
+		*strm_ >> more;
+		if (more)
+			*strm_ >> block_;
+
+		if (!more || (strm_->status() != QDataStream::Ok)) {
+			atEnd_ = true;
+			return *this;
+		}
+
+		QDataStream blockStrm(block_);
+		blockStrm.setVersion(QDataStream::Qt_4_5);
+		quint32 type;
+		blockStrm >> title_ >> type;
+		type_ = static_cast<Core::QueryView::Type>(type);
+		if (blockStrm.status() != QDataStream::Ok)
+			atEnd_ = true;
+
+		return *this;
+	}
+
+	for (++listPos_; listPos_ < queryNodeList_.size(); listPos_++) {
+		elem_ = queryNodeList_.at(listPos_).toElement();
+		if (!elem_.isNull())
+			break;
+	}
+
+	title_ = elem_.attribute("name");
+	type_ = static_cast<Core::QueryView::Type>
+	        (elem_.attribute("type").toUInt());
+	return *this;
+}
+
+/**
+ * Loads the current query view.
+ * @param  view  The view object to load into
+ */
 void Session::QueryViewIterator::load(QueryView* view)
 {
+	if (strm_ != NULL) {
+		QBuffer buf(&block_);
+		buf.open(QIODevice::ReadOnly);
+		Core::LocationStream viewStrm(&buf);
+
+		// Skip the title and type, read by operator++().
+		QString title;
+		quint32 type;
+		viewStrm.stream() >> title >> type;
+		view->fromStream(viewStrm);
+		return;
+	}
+
 	// Ensure the iterator's XML element is valid.
 	if (!elem_.isNull())
 		view->fromXML(elem_);
@@ -22,6 +22,9 @@
 #define __APP_SESSION_H__
 
 #include <QDomDocument>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
 #include <core/globals.h>
 #include "queryview.h"
 
@@ -35,6 +38,9 @@ namespace App
  * Manages a KScope session.
  * Responsible for storing a session when a project is closed, and for restoring
  * it when the project is opened again.
+ * Query views are stored in a binary file, one view at a time, as these can
+ * hold a large number of locations. Sessions stored by older versions in an
+ * XML file can still be loaded.
  * @author Elad Lahav
  */
 class Session
@@ -47,25 +53,36 @@ public:
 	{
 		void load(QueryView*);
 
-		bool isAtEnd() { return listPos_ == queryNodeList_.size(); }
+		bool isAtEnd() {
+			if (strm_ != NULL)
+				return atEnd_;
 
-		QueryViewIterator& operator++() {
-			for (++listPos_; listPos_ < queryNodeList_.size(); listPos_++) {
-				elem_ = queryNodeList_.at(listPos_).toElement();
-				if (!elem_.isNull())
-					break;
-			}
-
-			title_ = elem_.attribute("name");
-			type_ = static_cast<Core::QueryView::Type>
-			        (elem_.attribute("type").toUInt());
-			return *this;
+			return listPos_ == queryNodeList_.size();
 		}
 
+		QueryViewIterator& operator++();
+
 		const QString& title() const { return title_; }
 		Core::QueryView::Type type() const { return type_; }
 
 	private:
+		QueryViewIterator() : strm_(NULL), atEnd_(false), listPos_(0) {}
+
+		/**
+		 * The binary query view file, NULL if views are loaded from XML.
+		 */
+		QDataStream* strm_;
+
+		/**
+		 * The binary representation of the current view.
+		 */
+		QByteArray block_;
+
+		/**
+		 * Whether all views were read from the binary file.
+		 */
+		bool atEnd_;
+
 		QDomNodeList queryNodeList_;
 		int listPos_;
 		QDomElement elem_;
@@ -108,13 +125,34 @@ private:
 	QString path_;
 
 	/**
-	 * An XML document used to manage open query views.
+	 * An XML document holding query views stored by older versions.
 	 */
 	QDomDocument queryViewDoc_;
 
+	/**
+	 * The binary query view file, when loading a session.
+	 */
+	QFile* viewFile_;
+
+	/**
+	 * Reads query views from the binary file.
+	 */
+	mutable QDataStream viewStrm_;
+
+	/**
+	 * The binary query view file, when storing a session.
+	 * Views are written as these are added, and the file replaces the
+	 * previous one when the session is saved.
+	 */
+	QSaveFile* viewSaveFile_;
+
+	bool openViewSaveFile();
+
 	inline QString configFile() { return path_ + "/session.conf"; }
 
-	inline QString queryViewFile() { return path_ + "/queries.xml"; }
+	inline QString queryViewFile() { return path_ + "/queries.dat"; }
+
+	inline QString xmlQueryViewFile() { return path_ + "/queries.xml"; }
 };
 
 } // namespace App
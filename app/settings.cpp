@@ -27,7 +27,7 @@ namespace KScope
 namespace App
 {
 
-Settings::Settings() : QSettings()
+Settings::Settings() : QSettings(), prefetchDepth_(1)
 {
 }
 
@@ -50,6 +50,10 @@ void Settings::load()
 	endArray();
 
 	endGroup();
+
+	beginGroup("QueryView");
+	prefetchDepth_ = value("PrefetchDepth", prefetchDepth_).toInt();
+	endGroup();
 }
 
 void Settings::store()
@@ -68,6 +72,10 @@ void Settings::store()
 	endArray();
 
 	endGroup();
+
+	beginGroup("QueryView");
+	setValue("PrefetchDepth", prefetchDepth_);
+	endGroup();
 }
 
 void Settings::addRecentProject(const QString& path, const QString& name)
@@ -55,8 +55,21 @@ public:
 		return recentProjects_;
 	}
 
+	/**
+	 * @return The number of call-tree levels queried in the background below
+	 *         the displayed items
+	 */
+	int prefetchDepth() const { return prefetchDepth_; }
+
+	/**
+	 * @param  depth  The number of call-tree levels queried in the background,
+	 *                0 to disable
+	 */
+	void setPrefetchDepth(int depth) { prefetchDepth_ = depth; }
+
 private:
 	QLinkedList<RecentProject> recentProjects_;
+	int prefetchDepth_;
 };
 
 } // namespace App
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+# Benchmarks
+SUBDIRS += index \
+    parser \
+    filefilter \
+    locationmodel \
+    codebasemodel
@@ -0,0 +1,323 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <core/codebasemodel.h>
+#include <core/treeitem.h>
+
+/**
+ * Compares the lazy CodebaseModel with a tree that is built eagerly, one path
+ * component at a time. The model is constructed from a code base holding a
+ * list of paths (one per line, e.g., the output of find(1)), after which a
+ * single large directory is expanded, followed by the entire tree. Without a
+ * path list, 200,000 paths are generated, a tenth of which are in a single
+ * flat directory.
+ *
+ * Usage: bench_codebasemodel [PATH_LIST] [ROOT_PATH] [DIRECTORY]
+ */
+
+using namespace KScope;
+
+/**
+ * A code base that provides a fixed list of files.
+ */
+class ListCodebase : public Core::Codebase
+{
+public:
+	ListCodebase(const QStringList& fileList) : fileList_(fileList) {}
+
+	void open(const QString&, Core::Callback<>*) {}
+	void save(const QString&) {}
+
+	void getFiles(Core::Callback<const QString&>& cb) const {
+		QStringList::ConstIterator itr;
+		for (itr = fileList_.begin(); itr != fileList_.end(); ++itr)
+			cb.call(*itr);
+	}
+
+	void setFiles(const QStringList&) {}
+	bool canModify() { return false; }
+
+private:
+	QStringList fileList_;
+};
+
+/**
+ * Builds the complete tree as files are reported, by splitting each path and
+ * scanning the children of every node on the way for a matching component.
+ * Mirrors the way CodebaseModel used to work.
+ */
+class SequentialTree : public Core::Callback<const QString&>
+{
+public:
+	typedef Core::TreeItem<QString> ItemT;
+
+	SequentialTree(const Core::Codebase* cbase, const QString& rootPath)
+		: root_(rootPath) {
+		cbase->getFiles(*this);
+	}
+
+	void call(const QString& path) {
+		// Remove the root path prefix.
+		QString actPath;
+		if (path.startsWith(root_.data()))
+			actPath = path.mid(root_.data().length());
+		else
+			actPath = path;
+
+		// Descend down the tree, following the path components.
+		QStringList pathParts = actPath.split('/', QString::SkipEmptyParts);
+		ItemT* item = &root_;
+		QStringList::iterator itr;
+		for (itr = pathParts.begin(); itr != pathParts.end(); ++itr) {
+			ItemT* child;
+			if ((child = item->findChild(*itr)) != NULL)
+				item = child;
+			else
+				item = item->addChild(*itr);
+		}
+	}
+
+	const ItemT* find(const QStringList& pathParts) {
+		ItemT* item = &root_;
+		QStringList::ConstIterator itr;
+		for (itr = pathParts.begin(); itr != pathParts.end(); ++itr) {
+			if ((item = item->findChild(*itr)) == NULL)
+				return NULL;
+		}
+
+		return item;
+	}
+
+	int fileCount() const {
+		int count = 0;
+		for (int i = 0; i < root_.childCount(); i++)
+			count += fileCount(root_.child(i));
+
+		return count;
+	}
+
+private:
+	ItemT root_;
+
+	static int fileCount(const ItemT* item) {
+		if (item->childCount() == 0)
+			return 1;
+
+		int count = 0;
+		for (int i = 0; i < item->childCount(); i++)
+			count += fileCount(item->child(i));
+
+		return count;
+	}
+};
+
+/**
+ * Generates paths in a source tree.
+ * Every tenth path is in a single flat directory, while the rest are spread
+ * over directories three levels deep, about 175 files in each.
+ * @param  count  The number of paths
+ * @return The list of paths
+ */
+static QStringList generate(int count)
+{
+	static const char* const exts[] = { "c", "h", "cpp", "S", "txt" };
+	static const int extCount = sizeof(exts) / sizeof(exts[0]);
+
+	QStringList pathList;
+	pathList.reserve(count);
+	for (int i = 0; i < count; i++) {
+		if ((i % 10) == 0) {
+			pathList << QString("/home/user/project/flat/file%1.%2")
+			            .arg(i).arg(exts[i % extCount]);
+		}
+		else {
+			pathList << QString("/home/user/project/module%1/sub%2/dir%3/"
+			                    "file%4.%5")
+			            .arg(i % 16).arg((i / 16) % 8).arg((i / 128) % 8)
+			            .arg(i).arg(exts[i % extCount]);
+		}
+	}
+
+	return pathList;
+}
+
+static QTextStream out(stdout);
+
+/**
+ * Reports the time taken by a step.
+ * @param  elapsed  The time taken, in milliseconds
+ * @param  name     The name of the step
+ * @param  count    The result of the step
+ * @param  unit     Describes the count
+ */
+static void report(qint64 elapsed, const char* name, int count,
+                   const char* unit)
+{
+	out << name << ": " << elapsed << " ms, " << count << " " << unit
+	    << endl;
+}
+
+/**
+ * Finds a child of a directory in the model by its name.
+ * The directory's children are fetched, if needed.
+ * @param  model   The model to search
+ * @param  parent  The directory's index
+ * @param  name    The name of the child
+ * @return The child's index, an invalid index if not found
+ */
+static QModelIndex findChild(Core::CodebaseModel& model,
+                             const QModelIndex& parent, const QString& name)
+{
+	if (model.canFetchMore(parent))
+		model.fetchMore(parent);
+
+	for (int i = 0; i < model.rowCount(parent); i++) {
+		QModelIndex child = model.index(i, 0, parent);
+		if (model.data(child).toString() == name)
+			return child;
+	}
+
+	return QModelIndex();
+}
+
+/**
+ * Fetches all nodes under a directory in the model.
+ * @param  model   The model to expand
+ * @param  parent  The directory's index
+ * @return The number of files under the directory
+ */
+static int expand(Core::CodebaseModel& model, const QModelIndex& parent)
+{
+	if (!model.hasChildren(parent))
+		return 1;
+
+	if (model.canFetchMore(parent))
+		model.fetchMore(parent);
+
+	int count = 0;
+	for (int i = 0; i < model.rowCount(parent); i++)
+		count += expand(model, model.index(i, 0, parent));
+
+	return count;
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	QStringList args = app.arguments();
+	QStringList pathList;
+	QString rootPath = "/";
+	QString dir;
+	if (args.size() > 1 && args[1] != "-") {
+		QFile file(args[1]);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			out << "Cannot read " << args[1] << endl;
+			return 1;
+		}
+
+		QTextStream strm(&file);
+		while (!strm.atEnd())
+			pathList << strm.readLine();
+	}
+	else {
+		pathList = generate(200000);
+		rootPath = "/home/user/project/";
+		dir = "flat";
+	}
+
+	if (args.size() > 2)
+		rootPath = args[2];
+	if (args.size() > 3)
+		dir = args[3];
+
+	out << pathList.size() << " paths, root " << rootPath << endl;
+
+	ListCodebase cbase(pathList);
+	Core::CodebaseModel* model;
+	SequentialTree* tree;
+
+	// Construction.
+	QElapsedTimer timer;
+	qint64 elapsed;
+	timer.start();
+	model = new Core::CodebaseModel(&cbase, rootPath);
+	elapsed = timer.elapsed();
+	report(elapsed, "Lazy construction", model->rowCount(), "top-level rows");
+
+	timer.start();
+	tree = new SequentialTree(&cbase, rootPath);
+	elapsed = timer.elapsed();
+	report(elapsed, "Sequential construction", tree->fileCount(), "files");
+
+	// Expansion of a single directory.
+	QStringList dirParts = dir.split('/', QString::SkipEmptyParts);
+	QModelIndex dirIndex;
+	for (int i = 0; i < dirParts.size(); i++) {
+		dirIndex = findChild(*model, dirIndex, dirParts[i]);
+		if (!dirIndex.isValid())
+			break;
+	}
+
+	int mismatches = 0;
+	if (!dirParts.isEmpty()) {
+		if (!dirIndex.isValid() || !model->hasChildren(dirIndex)) {
+			out << "No directory " << dir << endl;
+			return 1;
+		}
+
+		timer.start();
+		model->fetchMore(dirIndex);
+		elapsed = timer.elapsed();
+		int rows = model->rowCount(dirIndex);
+		report(elapsed, "Directory fetch", rows, "rows");
+
+		const SequentialTree::ItemT* item = tree->find(dirParts);
+		if (item == NULL || item->childCount() != rows) {
+			out << "Mismatch: " << (item ? item->childCount() : 0)
+			    << " rows in " << dir << endl;
+			mismatches++;
+		}
+	}
+
+	// Expansion of the entire tree.
+	timer.start();
+	int files = expand(*model, QModelIndex());
+	report(timer.elapsed(), "Full expansion", files, "files");
+
+	if (files != tree->fileCount()) {
+		out << "Mismatch: " << tree->fileCount() << " files" << endl;
+		mismatches++;
+	}
+
+	delete tree;
+	delete model;
+
+	if (mismatches > 0) {
+		out << mismatches << " mismatches" << endl;
+		return 1;
+	}
+
+	return 0;
+}
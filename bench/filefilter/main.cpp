@@ -0,0 +1,186 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <core/filefilter.h>
+
+/**
+ * Compares the compiled FileFilter matcher with sequential wildcard matching.
+ * A list of paths (one per line, e.g., the output of find(1)) is matched
+ * against a filter with both implementations, and the results are checked
+ * for consistency. Without a path list, a million paths are generated.
+ *
+ * Usage: bench_filefilter [PATH_LIST] [FILTER]
+ */
+
+using namespace KScope;
+
+/**
+ * The default filter: a mix of exclusions, extensions, prefixes and
+ * complex patterns, 30 rules in all.
+ */
+static const char* DefaultFilter =
+	"-*/.git/*;-*/build/*;-*/CVS/*;-*~;-*.o;-*.a;-*.so;-*.orig;-*.rej;"
+	"*.c;*.h;*.cc;*.cpp;*.cxx;*.hpp;*.hxx;*.y;*.l;*.s;*.S;*.inl;*.ipp;"
+	"*.tcc;*.def;/usr/include/*;*/Makefile;*/Kconfig;*/include/*.inc;"
+	"*/test?/*.t;*/doc/[a-m]*.txt";
+
+/**
+ * Matches paths by trying every rule's wildcard expression in order.
+ * Mirrors the way FileFilter used to work.
+ */
+class SequentialFilter
+{
+public:
+	SequentialFilter(const QString& filter) {
+		QStringList patterns = filter.split(';', QString::SkipEmptyParts);
+		foreach (QString pattern, patterns) {
+			bool include = !pattern.startsWith("-");
+			if (!include)
+				pattern = pattern.mid(1);
+
+			ruleList_.append(qMakePair(QRegExp(pattern, Qt::CaseSensitive,
+			                                   QRegExp::Wildcard),
+			                           include));
+		}
+	}
+
+	bool match(const QString& path, bool noMatchResult) const {
+		QList< QPair<QRegExp, bool> >::ConstIterator itr;
+		for (itr = ruleList_.begin(); itr != ruleList_.end(); ++itr) {
+			if ((*itr).first.exactMatch(path))
+				return (*itr).second;
+		}
+
+		return noMatchResult;
+	}
+
+private:
+	QList< QPair<QRegExp, bool> > ruleList_;
+};
+
+/**
+ * Generates paths in a source tree.
+ * @param  count  The number of paths
+ * @return The list of paths
+ */
+static QStringList generate(int count)
+{
+	static const char* const exts[] = {
+		"c", "h", "cpp", "o", "txt", "py", "hpp", "inc", "t", "orig", "S",
+		"mk", "so", "def"
+	};
+	static const char* const dirs[] = {
+		"src", "include", "build", "doc", ".git", "test1", "lib", "tools"
+	};
+	static const int extCount = sizeof(exts) / sizeof(exts[0]);
+	static const int dirCount = sizeof(dirs) / sizeof(dirs[0]);
+
+	QStringList pathList;
+	pathList.reserve(count);
+	for (int i = 0; i < count; i++) {
+		pathList << QString("/home/user/project/module%1/%2/sub%3/%4%5.%6")
+		            .arg(i % 53).arg(dirs[i % dirCount]).arg(i % 17)
+		            .arg((i % 5) ? "file" : "alpha").arg(i)
+		            .arg(exts[i % extCount]);
+	}
+
+	return pathList;
+}
+
+static QTextStream out(stdout);
+
+/**
+ * Matches all paths, and reports the time taken.
+ * @param  filter    The filter to use
+ * @param  pathList  The paths to match
+ * @param  results   Holds the match result of each path, upon return
+ * @param  name      The implementation name, for reporting
+ */
+template<class FilterT>
+static void measure(const FilterT& filter, const QStringList& pathList,
+                    QVector<bool>& results, const char* name)
+{
+	results.resize(pathList.size());
+
+	QElapsedTimer timer;
+	timer.start();
+
+	int matched = 0;
+	for (int i = 0; i < pathList.size(); i++) {
+		results[i] = filter.match(pathList[i], false);
+		if (results[i])
+			matched++;
+	}
+
+	qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+	out << name << ": " << elapsed << " ms, "
+	    << (qint64(pathList.size()) * 1000 / elapsed) << " paths/s, "
+	    << matched << " matched" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	QStringList args = app.arguments();
+	QStringList pathList;
+	if (args.size() > 1 && args[1] != "-") {
+		QFile file(args[1]);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			out << "Cannot read " << args[1] << endl;
+			return 1;
+		}
+
+		QTextStream strm(&file);
+		while (!strm.atEnd())
+			pathList << strm.readLine();
+	}
+	else {
+		pathList = generate(1000000);
+	}
+
+	QString filter = (args.size() > 2) ? args[2] : QString(DefaultFilter);
+	out << pathList.size() << " paths, "
+	    << filter.split(';', QString::SkipEmptyParts).size() << " rules"
+	    << endl;
+
+	QVector<bool> compiled, sequential;
+	measure(Core::FileFilter(filter), pathList, compiled, "Compiled");
+	measure(SequentialFilter(filter), pathList, sequential, "Sequential");
+
+	int mismatches = 0;
+	for (int i = 0; i < pathList.size(); i++) {
+		if (compiled[i] != sequential[i]) {
+			if (mismatches++ < 10)
+				out << "Mismatch: " << pathList[i] << endl;
+		}
+	}
+
+	if (mismatches > 0) {
+		out << mismatches << " mismatches" << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,20 @@
+include(../../config)
+TEMPLATE = app
+TARGET = bench_index
+CONFIG += console
+CONFIG -= app_bundle
+DEPENDPATH += ". ../../core ../../cscope ../../native"
+
+# Input
+SOURCES += main.cpp
+INCLUDEPATH += ../.. \
+    ../../cscope \
+    ../../native \
+    .
+LIBS += -L../../core \
+    -lkscope_core \
+    -L../../cscope \
+    -lkscope_cscope \
+    -L../../native \
+    -lkscope_native
+QT += widgets xml
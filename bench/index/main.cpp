@@ -0,0 +1,221 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <core/exception.h>
+#include <cscope/crossref.h>
+#include <native/index.h>
+#include <native/symbolindex.h>
+
+/**
+ * Compares the native index with the Cscope engine.
+ * Both engines build their databases from the cscope.files file in the given
+ * project directory, after which the same set of symbols (sampled from the
+ * native index) is queried on each. The databases are written to the project
+ * directory, so the benchmark should be run on a scratch copy of a project.
+ *
+ * Usage: bench_index PROJECT_DIR [SYMBOLS]
+ */
+
+using namespace KScope;
+
+/**
+ * Runs engine operations synchronously.
+ * @author Elad Lahav
+ */
+class Waiter : public Core::Engine::Connection
+{
+public:
+	Waiter() : done_(false), success_(false), results_(0) {}
+
+	/**
+	 * Runs the event loop until the current operation terminates.
+	 * @return true if the operation finished, false if it was aborted
+	 */
+	bool wait() {
+		if (!done_)
+			loop_.exec();
+
+		done_ = false;
+		return success_;
+	}
+
+	/**
+	 * @return The number of locations delivered since the object was created
+	 */
+	int results() const { return results_; }
+
+	void onDataReady(const Core::CompactLocationList& locList) {
+		results_ += locList.size();
+	}
+
+	void onFinished() { finish(true); }
+	void onAborted() { finish(false); }
+
+	void onProgress(const QString& text, uint cur, uint total) {
+		(void)text;
+		(void)cur;
+		(void)total;
+	}
+
+private:
+	QEventLoop loop_;
+	bool done_;
+	bool success_;
+	int results_;
+
+	void finish(bool success) {
+		done_ = true;
+		success_ = success;
+		loop_.quit();
+	}
+};
+
+static QTextStream out(stdout);
+
+/**
+ * Opens an engine on the project directory, and builds its database.
+ * @param  engine  The engine to build
+ * @param  path    The project directory
+ * @param  name    The engine name, for reporting
+ * @return true if successful, false otherwise
+ */
+static bool build(Core::Engine& engine, const QString& path,
+                  const char* name)
+{
+	Waiter waiter;
+	QElapsedTimer timer;
+
+	try {
+		engine.open(path, NULL);
+		timer.start();
+		engine.build(&waiter);
+	}
+	catch (Core::Exception* e) {
+		out << name << ": " << e->reason() << endl;
+		delete e;
+		return false;
+	}
+
+	if (!waiter.wait()) {
+		out << name << ": build failed" << endl;
+		return false;
+	}
+
+	out << name << " build: " << timer.elapsed() << " ms" << endl;
+	return true;
+}
+
+/**
+ * Runs a query for each of the given symbols, and reports the average
+ * latency.
+ * @param  engine   The engine to query
+ * @param  name     The engine name, for reporting
+ * @param  type     The query type
+ * @param  symbols  The symbols to look for
+ */
+static void query(const Core::Engine& engine, const char* name,
+                  Core::Query::Type type, const QStringList& symbols)
+{
+	Waiter waiter;
+	QElapsedTimer timer;
+	timer.start();
+
+	foreach (const QString& symbol, symbols) {
+		try {
+			engine.query(&waiter, Core::Query(type, symbol));
+		}
+		catch (Core::Exception* e) {
+			out << name << ": " << e->reason() << endl;
+			delete e;
+			return;
+		}
+
+		waiter.wait();
+	}
+
+	qint64 elapsed = timer.nsecsElapsed();
+	out << name << " query type " << type << ": "
+	    << (elapsed / 1000 / qMax(symbols.size(), 1)) << " us/query, "
+	    << waiter.results() << " results" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	QStringList args = app.arguments();
+	if (args.size() < 2) {
+		out << "Usage: " << args.first() << " PROJECT_DIR [SYMBOLS]" << endl;
+		return 1;
+	}
+
+	QString path = args[1];
+	int count = (args.size() > 2) ? args[2].toInt() : 200;
+
+	// Time full builds.
+	Cscope::Crossref::incrementalBuild_ = false;
+
+	Native::Index index;
+	Cscope::Crossref crossref;
+	if (!build(index, path, "Native") || !build(crossref, path, "Cscope"))
+		return 1;
+
+	// Sample symbols evenly from the native index.
+	Native::SymbolIndex symIndex;
+	if (!symIndex.load(QDir(path).filePath("kscope.idx"))) {
+		out << "Failed to load the native index" << endl;
+		return 1;
+	}
+
+	QStringList symbols;
+	quint32 step = qMax<quint32>(symIndex.symbolCount() / qMax(count, 1), 1);
+	for (quint32 i = 0; i < symIndex.symbolCount(); i += step) {
+		if (symbols.size() == count)
+			break;
+
+		symbols << QString::fromUtf8(symIndex.name(i));
+	}
+
+	out << symIndex.files().size() << " files, " << symIndex.symbolCount()
+	    << " symbols, " << symbols.size() << " queries per type" << endl;
+
+	// Start the line-mode Cscope workers before measuring.
+	query(crossref, "Cscope (warm-up)", Core::Query::Definition,
+	      symbols.mid(0, 1));
+
+	static const Core::Query::Type types[] = {
+		Core::Query::Definition,
+		Core::Query::References,
+		Core::Query::CalledFunctions,
+		Core::Query::CallingFunctions
+	};
+
+	for (uint i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+		query(index, "Native", types[i], symbols);
+		query(crossref, "Cscope", types[i], symbols);
+	}
+
+	return 0;
+}
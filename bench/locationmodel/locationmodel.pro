@@ -0,0 +1,13 @@
+include(../../config)
+TEMPLATE = app
+TARGET = bench_locationmodel
+CONFIG -= app_bundle
+DEPENDPATH += ". ../../core"
+
+# Input
+SOURCES += main.cpp
+INCLUDEPATH += ../.. \
+    .
+LIBS += -L../../core \
+    -lkscope_core
+QT += widgets xml
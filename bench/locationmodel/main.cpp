@@ -0,0 +1,173 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QPixmap>
+#include <QScrollBar>
+#include <QTextStream>
+#include <core/locationview.h>
+#include <core/locationmodel.h>
+
+/**
+ * Measures the cost of displaying a large query result.
+ * A list and a tree view are filled with the same locations, after which the
+ * benchmark measures:
+ * 1. Retrieving the display text of every cell through data(), first with an
+ *    empty display path cache, and then with a full one.
+ * 2. Sizing the columns with LocationView::resizeColumns().
+ * 3. Scrolling through the view a page at a time, painting each page.
+ * Run with QT_QPA_PLATFORM=offscreen on a system without a display.
+ *
+ * Usage: bench_locationmodel [ROWS]
+ */
+
+using namespace KScope;
+
+/**
+ * The root path of the generated locations.
+ */
+static const char* RootPath = "/home/user/project/";
+
+/**
+ * Generates query results spread over a few thousand files, some of which
+ * are outside the root path.
+ * @param  count  The number of locations
+ * @return The list of locations
+ */
+static Core::CompactLocationList generate(int count)
+{
+	Core::LocationList locList;
+	locList.reserve(count);
+	for (int i = 0; i < count; i++) {
+		Core::Location loc;
+		int file = i % 3001;
+		if (file % 10)
+			loc.file_ = QString("%1module%2/file%3.c").arg(RootPath)
+			            .arg(file % 41).arg(file);
+		else
+			loc.file_ = QString("/usr/include/sys/header%1.h").arg(file);
+
+		loc.line_ = i % 5000 + 1;
+		loc.tag_.scope_ = QString("function_%1").arg(i % 977);
+		loc.text_ = QString("result = lookup_%1(table, key, flags);")
+		            .arg(i % 311);
+		locList.append(loc);
+	}
+
+	return Core::CompactLocationList(locList);
+}
+
+static QTextStream out(stdout);
+
+/**
+ * Retrieves the display text of every cell in the model.
+ * @param  model  The model
+ * @param  name   The pass name, for reporting
+ */
+static void readAll(const Core::LocationModel& model, const char* name)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	int rows = model.rowCount(), cols = model.columnCount();
+	int chars = 0;
+	for (int row = 0; row < rows; row++) {
+		for (int col = 0; col < cols; col++) {
+			QModelIndex index = model.index(row, col);
+			chars += model.data(index, Qt::DisplayRole).toString().size();
+		}
+	}
+
+	out << "  data(), " << name << ": " << timer.elapsed() << " ms ("
+	    << chars << " characters)" << endl;
+}
+
+/**
+ * Runs the benchmark on one type of view.
+ * @param  type  The type of the view
+ * @param  list  The locations to show
+ * @param  name  The view type name, for reporting
+ */
+static void run(Core::LocationView::Type type,
+                const Core::CompactLocationList& list, const char* name)
+{
+	out << name << ":" << endl;
+
+	Core::LocationView view(NULL, type);
+	view.resize(1000, 800);
+	view.show();
+
+	QList<Core::Location::Fields> colList;
+	colList << Core::Location::File << Core::Location::Line
+	        << Core::Location::Scope << Core::Location::Text;
+
+	Core::LocationModel* model = view.locationModel();
+	model->setRootPath(RootPath);
+	model->setColumns(colList);
+
+	QElapsedTimer timer;
+	timer.start();
+	model->add(list, QModelIndex());
+	out << "  add(): " << timer.elapsed() << " ms" << endl;
+
+	// Changing the root path empties the display path cache, which the first
+	// pass then fills.
+	model->setRootPath("/");
+	model->setRootPath(RootPath);
+	readAll(*model, "cold");
+	readAll(*model, "warm");
+
+	timer.start();
+	view.resizeColumns();
+	out << "  resizeColumns(): " << timer.elapsed() << " ms" << endl;
+
+	// Scroll through the view a page at a time, painting each page.
+	QScrollBar* bar = view.verticalScrollBar();
+	QPixmap pixmap(view.viewport()->size());
+	int pages = 0;
+
+	timer.start();
+	for (int pos = 0; pos <= bar->maximum(); pos += bar->pageStep()) {
+		bar->setValue(pos);
+		view.viewport()->render(&pixmap);
+		pages++;
+	}
+
+	qint64 elapsed = timer.elapsed();
+	out << "  scroll and paint: " << pages << " pages in " << elapsed
+	    << " ms (" << (double(elapsed) / qMax(pages, 1)) << " ms/page)"
+	    << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	QApplication app(argc, argv);
+
+	QStringList args = app.arguments();
+	int rows = (args.size() > 1) ? qMax(args[1].toInt(), 1) : 100000;
+	out << rows << " rows" << endl;
+
+	Core::CompactLocationList list = generate(rows);
+	run(Core::LocationView::List, list, "List");
+	run(Core::LocationView::Tree, list, "Tree");
+
+	return 0;
+}
@@ -0,0 +1,276 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <core/statemachine.h>
+
+/**
+ * Measures the cost of parsing Cscope query output with the state machine.
+ * The input is either a file holding the recorded output of a line-mode
+ * query (progress lines, followed by the "cscope: N lines" header and the
+ * result lines), or a generated equivalent. The output is parsed with the
+ * rules used by Cscope::Cscope, in three configurations:
+ * 1. Transitions dispatched on the first input character (the default).
+ * 2. All transitions of a state tried in order, as before the dispatch table.
+ * 3. As (2), with literals compared through a copy of the input.
+ *
+ * Usage: bench_parser [OUTPUT_FILE] [REPEAT]
+ */
+
+using namespace KScope;
+
+/**
+ * Matches a fixed string by comparing it with a copy of the input.
+ * Mirrors the way Parser::Literal used to work.
+ */
+struct CopyLiteral : public Parser::Operators<CopyLiteral>
+{
+	CopyLiteral(const char* str) : str_(str) {}
+
+	Parser::ParseResult match(const QByteArray& input, int& pos,
+	                          Parser::CapList& caps) const {
+		(void)caps;
+
+		int avail = input.size() - pos;
+		if (avail < str_.size()) {
+			return str_.startsWith(input.mid(pos)) ? Parser::PartialMatch
+			                                       : Parser::NoMatch;
+		}
+
+		if (input.mid(pos, str_.size()) == str_) {
+			pos += str_.size();
+			return Parser::FullMatch;
+		}
+
+		return Parser::NoMatch;
+	}
+
+	bool firstChars(bool* chars) const {
+		(void)chars;
+		return true;
+	}
+
+	static const int capCount_ = 0;
+
+private:
+	const QByteArray str_;
+};
+
+/**
+ * Hides the first characters of a parser from the state machine, so that
+ * its transition is tried for every input character.
+ */
+template<class ParserT>
+struct AnyFirst : public ParserT
+{
+	AnyFirst(const ParserT& parser) : ParserT(parser) {}
+
+	bool firstChars(bool* chars) const {
+		(void)chars;
+		return true;
+	}
+};
+
+/**
+ * Counts matched lines.
+ */
+struct CountAction
+{
+	CountAction(int* count) : count_(count) {}
+
+	void operator()(const Parser::CapList& caps) const {
+		(void)caps;
+		(*count_)++;
+	}
+
+	int* count_;
+};
+
+/**
+ * A state machine with the query rules of the Cscope class.
+ * @author Elad Lahav
+ */
+template<class LiteralT>
+class QueryMachine : public Parser::StateMachine
+{
+public:
+	QueryMachine(bool dispatch, int* count)
+		: progState_("QueryProgress"), resultState_("QueryResults"),
+		  dispatch_(dispatch) {
+		CountAction action(count);
+
+		rule(progState_, LiteralT("> Symbols matched ")
+		                 << Parser::Number()
+		                 << LiteralT(" of ")
+		                 << Parser::Number()
+		                 << LiteralT("\n"),
+		     progState_, action);
+		rule(progState_, LiteralT("> Possible references retrieved ")
+		                 << Parser::Number()
+		                 << LiteralT(" of ")
+		                 << Parser::Number()
+		                 << LiteralT("\n"),
+		     progState_, action);
+		rule(progState_, LiteralT("> Search ")
+		                 << Parser::Number()
+		                 << LiteralT(" of ")
+		                 << Parser::Number()
+		                 << LiteralT("\n"),
+		     progState_, action);
+		rule(progState_, LiteralT("cscope: ")
+		                 << Parser::Number()
+		                 << LiteralT(" lines\n"),
+		     resultState_, action);
+		rule(resultState_, Parser::String<>(' ')
+		                   << Parser::Whitespace()
+		                   << Parser::String<>(' ')
+		                   << Parser::Whitespace()
+		                   << Parser::Number()
+		                   << Parser::Whitespace()
+		                   << Parser::String<>('\n')
+		                   << LiteralT("\n"),
+		     resultState_, action);
+	}
+
+	/**
+	 * Parses a complete query output.
+	 * @param  input  The output to parse
+	 * @return true if successful, false on a parse error
+	 */
+	bool run(const QByteArray& input) {
+		setState(progState_);
+		int pos = 0;
+		return parse(input, pos) && pos == input.size();
+	}
+
+private:
+	State progState_;
+	State resultState_;
+	bool dispatch_;
+
+	template<class ParserT>
+	void rule(State& from, const ParserT& parser, const State& to,
+	          const CountAction& action) {
+		if (dispatch_)
+			addRule(from, parser, to, action);
+		else
+			addRule(from, AnyFirst<ParserT>(parser), to, action);
+	}
+};
+
+/**
+ * Generates query output with a progress line per searched file, similar to
+ * a References query over a large code base.
+ * @param  files    The number of progress lines
+ * @param  results  The number of result lines
+ * @return The output
+ */
+static QByteArray generate(int files, int results)
+{
+	static const char* const progress[] = {
+		"> Symbols matched %1 of %2\n",
+		"> Possible references retrieved %1 of %2\n",
+		"> Search %1 of %2\n"
+	};
+
+	QByteArray output;
+	for (int i = 0; i < files; i++)
+		output += QString(progress[i % 3]).arg(i + 1).arg(files).toLatin1();
+
+	output += QString("cscope: %1 lines\n").arg(results).toLatin1();
+	for (int i = 0; i < results; i++) {
+		output += QString("src/dir%1/file%2.c function_%3 %4 "
+		                  "x = function_%3(y, z);\n")
+		          .arg(i % 97).arg(i % 1013).arg(i % 211).arg(i + 1)
+		          .toLatin1();
+	}
+
+	return output;
+}
+
+static QTextStream out(stdout);
+
+/**
+ * Parses the input repeatedly, and reports the throughput.
+ * @param  machine  The state machine to use
+ * @param  input    The query output
+ * @param  repeat   The number of times to parse the input
+ * @param  count    The matched line counter of the machine
+ * @param  name     The configuration name, for reporting
+ */
+template<class MachineT>
+static void measure(MachineT& machine, const QByteArray& input, int repeat,
+                    int& count, const char* name)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	count = 0;
+	for (int i = 0; i < repeat; i++) {
+		if (!machine.run(input)) {
+			out << name << ": parse error" << endl;
+			return;
+		}
+	}
+
+	qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+	double mb = double(input.size()) * repeat / (1024 * 1024);
+	out << name << ": " << elapsed << " ms, " << (mb * 1000 / elapsed)
+	    << " MB/s, " << count / repeat << " lines" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	QStringList args = app.arguments();
+	QByteArray input;
+	if (args.size() > 1) {
+		QFile file(args[1]);
+		if (!file.open(QIODevice::ReadOnly)) {
+			out << "Cannot read " << args[1] << endl;
+			return 1;
+		}
+
+		input = file.readAll();
+	}
+	else {
+		input = generate(50000, 50000);
+	}
+
+	int repeat = (args.size() > 2) ? qMax(args[2].toInt(), 1) : 10;
+	out << input.size() / 1024 << " KB of output, " << repeat
+	    << " iterations" << endl;
+
+	int count;
+	QueryMachine<Parser::Literal> dispatched(true, &count);
+	measure(dispatched, input, repeat, count, "Dispatch table");
+
+	QueryMachine<Parser::Literal> sequential(false, &count);
+	measure(sequential, input, repeat, count, "Sequential");
+
+	QueryMachine<CopyLiteral> copying(false, &count);
+	measure(copying, input, repeat, count, "Sequential, copying literals");
+
+	return 0;
+}
@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QSet>
 #include "codebasemodel.h"
 
 namespace KScope
@@ -27,17 +28,27 @@ namespace KScope
 namespace Core
 {
 
+/**
+ * Class constructor.
+ * Reads the list of files from the code base. No tree nodes are created at
+ * this stage.
+ * @param  cbase     The code base to present
+ * @param  rootPath  Used to shorten paths
+ * @param  parent    Parent object
+ */
 CodebaseModel::CodebaseModel(const Codebase* cbase, const QString& rootPath,
                              QObject* parent) :
 	QAbstractItemModel(parent),
-	root_(rootPath)
+	rootPath_(rootPath)
 {
-	// TODO: rootPath may be invalid.
-	// Need to set root_ to "/", and ignore rootPath.
+	if (!rootPath_.endsWith("/"))
+		rootPath_ += "/";
 
-	// Add all files in the code base.
+	// Read all files in the code base.
 	AddFilesCallback cb(this);
 	cbase->getFiles(cb);
+	sortFiles();
+	resetTree();
 }
 
 CodebaseModel::~CodebaseModel()
@@ -46,41 +57,77 @@ CodebaseModel::~CodebaseModel()
 
 void CodebaseModel::addFiles(const QStringList& fileList)
 {
-	// Add each of the files in the list to the tree structure.
+	// Add each of the files in the list to the sorted array.
+	// It's much easier to just reset the model than to insert individual
+	// rows, since files are added all over the tree.
+	beginResetModel();
+
 	QStringList::ConstIterator itr;
-        beginResetModel();
 	for (itr = fileList.begin(); itr != fileList.end(); ++itr)
 		addFile(*itr);
 
-	// It's much easier to just reset the model than to emit individual
-	// dataChanged() signals, since files are added all over the tree.
-        endResetModel();
+	sortFiles();
+	resetTree();
+	endResetModel();
 }
 
 /**
- * Converts the model's tree-structured data into a list of file paths.
+ * Removes files from the model.
+ * @param  fileList  The files to remove
+ */
+void CodebaseModel::removeFiles(const QStringList& fileList)
+{
+	// Convert the paths to the form stored in the array.
+	QStringList keys;
+	QStringList::ConstIterator itr;
+	for (itr = fileList.begin(); itr != fileList.end(); ++itr) {
+		if ((*itr).startsWith(rootPath_))
+			keys.append((*itr).mid(rootPath_.length()));
+		else
+			keys.append(*itr);
+	}
+
+	QSet<QString> keySet = keys.toSet();
+
+	beginResetModel();
+
+	QStringList newList;
+	newList.reserve(fileList_.size());
+	for (itr = fileList_.begin(); itr != fileList_.end(); ++itr) {
+		if (!keySet.contains(*itr))
+			newList.append(*itr);
+	}
+
+	fileList_ = newList;
+	resetTree();
+	endResetModel();
+}
+
+/**
+ * Provides the list of files in the model.
  * @param  fileList  The list object to fill
  */
 void CodebaseModel::getFiles(QStringList& fileList) const
 {
-	getFiles(&root_, "", fileList);
+	fileList.reserve(fileList.size() + fileList_.size());
+
+	QStringList::ConstIterator itr;
+	for (itr = fileList_.begin(); itr != fileList_.end(); ++itr) {
+		if ((*itr).startsWith("/"))
+			fileList.append(*itr);
+		else
+			fileList.append(rootPath_ + *itr);
+	}
 }
 
 QModelIndex CodebaseModel::index(int row, int column,
                                  const QModelIndex& parent) const
 {
-	const ItemT* item;
-
-	if (!parent.isValid()) {
-		item = &root_;
-	}
-	else {
-		item = indexData(parent);
-		if (item == NULL)
-			return QModelIndex();
-	}
+	int child = tree_.child(indexData(parent), row);
+	if (child == -1)
+		return QModelIndex();
 
-	return createIndex(row, column, (void*)item->child(row));
+	return createIndex(row, column, (quintptr)child);
 }
 
 QModelIndex CodebaseModel::parent(const QModelIndex& index) const
@@ -88,11 +135,11 @@ QModelIndex CodebaseModel::parent(const QModelIndex& index) const
 	if (!index.isValid())
 		return QModelIndex();
 
-	ItemT* item = indexData(index);
-	if (item == NULL || item->parent() == &root_)
+	int parent = tree_.parent(indexData(index));
+	if (parent == -1 || parent == TreeT::Root)
 		return QModelIndex();
 
-	return createIndex(item->parent()->index(), 0, (void*)item->parent());
+	return createIndex(tree_.row(parent), 0, (quintptr)parent);
 }
 
 QVariant CodebaseModel::headerData(int section, Qt::Orientation orient,
@@ -107,18 +154,7 @@ QVariant CodebaseModel::headerData(int section, Qt::Orientation orient,
 
 int CodebaseModel::rowCount(const QModelIndex& parent) const
 {
-	const TreeItem<QString>* item;
-
-	if (!parent.isValid()) {
-		item = &root_;
-	}
-	else {
-		item = static_cast<TreeItem<QString>*>(parent.internalPointer());
-		if (item == NULL)
-			return 0;
-	}
-
-	return item->childCount();
+	return tree_.childCount(indexData(parent));
 }
 
 int CodebaseModel::columnCount(const QModelIndex& parent) const
@@ -127,74 +163,160 @@ int CodebaseModel::columnCount(const QModelIndex& parent) const
 	return 1;
 }
 
-QVariant CodebaseModel::data(const QModelIndex& index, int role) const
+/**
+ * Directories are always reported as having children, so that the view can
+ * show them as expandable before their contents are fetched.
+ * @param  parent  The parent index
+ * @return true if the index represents a directory, false otherwise
+ */
+bool CodebaseModel::hasChildren(const QModelIndex& parent) const
 {
-	QString file;
+	return tree_.data(indexData(parent)).dir_;
+}
 
+/**
+ * @param  parent  The parent index
+ * @return true if the index represents a directory for which child nodes were
+ *         not created yet, false otherwise
+ */
+bool CodebaseModel::canFetchMore(const QModelIndex& parent) const
+{
+	const Item& item = tree_.data(indexData(parent));
+	return item.dir_ && !item.fetched_;
+}
+
+/**
+ * Creates the child nodes of a directory.
+ * Children are found by scanning the directory's range in the sorted file
+ * array. The range of each sub-directory is skipped with a binary search, so
+ * the cost depends on the number of children, rather than on the number of
+ * files under the directory.
+ * @param  parent  The directory's index
+ */
+void CodebaseModel::fetchMore(const QModelIndex& parent)
+{
+	int node = indexData(parent);
+	Item item = tree_.data(node);
+	if (!item.dir_ || item.fetched_)
+		return;
+
+	tree_.data(node).fetched_ = true;
+
+	// Collect the children first, as rows must be announced before they are
+	// added.
+	QList<Item> children;
+	int pos = item.first_;
+	while (pos < item.last_) {
+		const QString& file = fileList_[pos];
+		Item child;
+		int slash = file.indexOf('/', item.prefixLen_);
+		if (slash == -1) {
+			// A file.
+			child.name_ = file.mid(item.prefixLen_);
+			child.first_ = pos;
+			child.last_ = pos + 1;
+			child.prefixLen_ = file.length();
+		}
+		else {
+			// A directory, covering all files that share its prefix.
+			// Absolute paths outside the root path begin with an empty
+			// component, which is presented as "/".
+			child.name_ = file.mid(item.prefixLen_, slash - item.prefixLen_);
+			if (child.name_.isEmpty())
+				child.name_ = "/";
+
+			child.first_ = pos;
+			child.last_ = prefixEnd(pos, item.last_, file.left(slash + 1));
+			child.prefixLen_ = slash + 1;
+			child.dir_ = true;
+		}
+
+		children.append(child);
+		pos = child.last_;
+	}
+
+	if (children.isEmpty())
+		return;
+
+	beginInsertRows(parent, 0, children.size() - 1);
+	tree_.reserveChildren(node, children.size());
+	QList<Item>::ConstIterator itr;
+	for (itr = children.begin(); itr != children.end(); ++itr)
+		tree_.addChild(node, *itr);
+	endInsertRows();
+}
+
+QVariant CodebaseModel::data(const QModelIndex& index, int role) const
+{
 	if (!index.isValid())
 		return QVariant();
 
 	if (role != Qt::DisplayRole)
 		return QVariant();
 
-	TreeItem<QString>* item
-		= static_cast<TreeItem<QString>*>(index.internalPointer());
-	if (item == NULL)
-		return QVariant();
-
-	return item->data();
+	return tree_.data(indexData(index)).name_;
 }
 
+/**
+ * Adds a file to the array of files.
+ * The array needs to be sorted afterwards.
+ * @param  path  The path of the file
+ */
 void CodebaseModel::addFile(const QString& path)
 {
 	// Remove the root path prefix.
-	QString actPath;
-	if (path.startsWith(root_.data()))
-		actPath = path.mid(root_.data().length());
+	if (path.startsWith(rootPath_))
+		fileList_.append(path.mid(rootPath_.length()));
 	else
-		actPath = path;
-
-	// Dissect the file path into its directory and file components.
-	QStringList pathParts = actPath.split('/', QString::SkipEmptyParts);
-
-	// Descend down the tree, following the path components.
-	ItemT* item = &root_;
-	QStringList::iterator itr;
-	for (itr = pathParts.begin(); itr != pathParts.end(); ++itr) {
-		// Find a child of the current item corresponding to the component.
-		// Create a new one if the child could not be found.
-		ItemT* child;
-		if ((child = item->findChild(*itr)) != NULL)
-			item = child;
-		else
-			item = item->addChild(*itr);
-	}
+		fileList_.append(path);
 }
 
 /**
- * An internal, recursive version of getFiles().
- * @param  item      The current item in a DFS
- * @param  path      The path of the item's parent
- * @param  fileList  The list to fill
+ * Sorts the array of files, and removes duplicate entries.
  */
-void CodebaseModel::getFiles(const ItemT* item, const QString& path,
-                             QStringList& fileList) const
+void CodebaseModel::sortFiles()
 {
-	QString name = path + item->data();
+	fileList_.sort();
+	fileList_.removeDuplicates();
+}
 
-	if (item->childCount()) {
-		// Add directory separator, if required.
-		if (!name.endsWith("/"))
-			name += "/";
+/**
+ * Discards all tree nodes, leaving an unfetched root node covering all files.
+ */
+void CodebaseModel::resetTree()
+{
+	tree_.clear(TreeT::Root);
+
+	Item& root = tree_.data(TreeT::Root);
+	root = Item();
+	root.name_ = rootPath_;
+	root.first_ = 0;
+	root.last_ = fileList_.size();
+	root.dir_ = true;
+}
 
-		// Descend to sub-directories.
-		for (int i = 0; i < item->childCount(); i++)
-			getFiles(item->child(i), name, fileList);
-	}
-	else {
-		// Found a file, add to the list.
-		fileList.append(name);
+/**
+ * Finds the end of the range of files sharing a prefix.
+ * Since the array is sorted, these files are consecutive.
+ * @param  first   The first file in the range, which has the prefix
+ * @param  last    The end of the range in which to search
+ * @param  prefix  The common prefix
+ * @return The position of the first file after first without the prefix, or
+ *         last if there is none
+ */
+int CodebaseModel::prefixEnd(int first, int last, const QString& prefix) const
+{
+	int low = first + 1;
+	int high = last;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (fileList_[mid].startsWith(prefix))
+			low = mid + 1;
+		else
+			high = mid;
 	}
+
+	return low;
 }
 
 #ifndef QT_NO_DEBUG
@@ -22,7 +22,7 @@
 #define __CORE_CODEBASEMODEL_H
 
 #include <QAbstractItemModel>
-#include "treeitem.h"
+#include "tree.h"
 #include "codebase.h"
 
 namespace KScope
@@ -32,6 +32,13 @@ namespace Core
 {
 
 /**
+ * A tree model for the files in a code base.
+ * The list of files is read once into a sorted array, in which the files of
+ * every directory occupy a contiguous range. Tree nodes are only created
+ * when the view asks for the contents of a directory (through fetchMore()),
+ * so that the model is ready immediately, regardless of the number of files.
+ * Paths under the root path are presented relative to it. Other paths are
+ * presented under a "/" node.
  * @author Elad Lahav
  */
 class CodebaseModel : public QAbstractItemModel
@@ -44,6 +51,7 @@ public:
 	~CodebaseModel();
 
 	void addFiles(const QStringList&);
+	void removeFiles(const QStringList&);
 	void getFiles(QStringList&) const;
 
 	virtual QModelIndex index(int row, int column,
@@ -51,20 +59,91 @@ public:
 	virtual QModelIndex parent(const QModelIndex& index) const;
 	virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
 	virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+	virtual bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+	virtual bool canFetchMore(const QModelIndex& parent) const;
+	virtual void fetchMore(const QModelIndex& parent);
 	virtual QVariant data(const QModelIndex&,
 	                      int role = Qt::DisplayRole) const;
 	virtual QVariant headerData(int, Qt::Orientation,
 	                            int role = Qt::DisplayRole) const;
 
 private:
-	typedef TreeItem<QString> ItemT;
-	ItemT root_;
+	/**
+	 * Data stored in a single node in the tree.
+	 */
+	struct Item
+	{
+		/**
+		 * The path component represented by the node.
+		 */
+		QString name_;
+
+		/**
+		 * The range of entries in the sorted file array covered by the node.
+		 */
+		int first_;
+		int last_;
+
+		/**
+		 * The length of the common prefix of all entries in the range,
+		 * including the node's own component (and the trailing '/' for a
+		 * directory).
+		 */
+		int prefixLen_;
+
+		/**
+		 * Whether the node represents a directory.
+		 */
+		bool dir_;
+
+		/**
+		 * Whether child nodes were created for the directory.
+		 */
+		bool fetched_;
+
+		Item() : first_(0), last_(0), prefixLen_(0), dir_(false),
+			fetched_(false) {}
+	};
+
+	typedef Tree<Item> TreeT;
+
+	/**
+	 * The root path of the code base.
+	 */
+	QString rootPath_;
+
+	/**
+	 * A sorted array of file paths, relative to the root path.
+	 * Paths outside the root path are kept as absolute paths.
+	 */
+	QStringList fileList_;
+
+	/**
+	 * The materialised part of the tree.
+	 * Model indices hold the positions of nodes in the tree as their internal
+	 * IDs.
+	 */
+	TreeT tree_;
 
 	void addFile(const QString&);
-	void getFiles(const ItemT*, const QString&, QStringList&) const;
+	void sortFiles();
+	void resetTree();
+	int prefixEnd(int, int, const QString&) const;
 
-	static inline ItemT* indexData(QModelIndex index) {
-		return static_cast<ItemT*>(index.internalPointer());
+#ifndef QT_NO_DEBUG
+	void verify(const QModelIndex&);
+#endif
+
+	/**
+	 * @param  index  A model index
+	 * @return The position of the index's node in the tree, the root's
+	 *         position for an invalid index
+	 */
+	static inline int indexData(const QModelIndex& index) {
+		if (!index.isValid())
+			return TreeT::Root;
+
+		return (int)index.internalId();
 	}
 
 	struct AddFilesCallback : public Core::Callback<const QString&>
@@ -79,10 +158,6 @@ private:
 	};
 
 	friend struct AddFilesCallback;
-
-#ifndef QT_NO_DEBUG
-	void verify(const QModelIndex&);
-#endif
 };
 
 }
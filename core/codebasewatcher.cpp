@@ -0,0 +1,323 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QDebug>
+#include "codebasewatcher.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The default time to wait for more events, in milliseconds.
+ */
+static const int DefaultDebounceInterval = 1000;
+
+/**
+ * The time between attempts to watch lost directories, in milliseconds.
+ */
+static const int RetryInterval = 5000;
+
+#ifdef Q_OS_LINUX
+/**
+ * Directory events that indicate a change to one of its files.
+ * Files saved in place generate IN_CLOSE_WRITE, while files saved through a
+ * temporary file generate IN_MOVED_TO. IN_MOVE_SELF is used to drop the watch
+ * of a directory that was moved away (deleted directories lose their watches
+ * automatically).
+ */
+static const uint32_t WatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+                                  | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF
+                                  | IN_ONLYDIR;
+#endif
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+CodebaseWatcher::CodebaseWatcher(QObject* parent) : QObject(parent), fd_(-1),
+	notifier_(NULL)
+{
+	timer_.setSingleShot(true);
+	timer_.setInterval(DefaultDebounceInterval);
+	connect(&timer_, SIGNAL(timeout()), this, SLOT(report()));
+
+	retryTimer_.setInterval(RetryInterval);
+	connect(&retryTimer_, SIGNAL(timeout()), this, SLOT(retryWatches()));
+}
+
+/**
+ * Class destructor.
+ */
+CodebaseWatcher::~CodebaseWatcher()
+{
+	unwatch();
+}
+
+/**
+ * Starts watching the files of a code base.
+ * Any previous watches are removed.
+ * @param  cbase     The code base
+ * @param  basePath  Used to resolve relative file paths
+ */
+void CodebaseWatcher::watch(const Codebase& cbase, const QString& basePath)
+{
+	unwatch();
+
+#ifdef Q_OS_LINUX
+	fd_ = inotify_init();
+	if (fd_ == -1) {
+		qDebug() << "inotify_init() failed:" << errno;
+		return;
+	}
+
+	fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+	fcntl(fd_, F_SETFD, FD_CLOEXEC);
+
+	// Add a watch for the directory of each file.
+	AddFileCallback cb(this, basePath);
+	cbase.getFiles(cb);
+
+	notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+	connect(notifier_, SIGNAL(activated(int)), this, SLOT(readEvents()));
+
+	if (!lostDirSet_.isEmpty())
+		retryTimer_.start();
+
+	qDebug() << "Watching" << fileSet_.size() << "files in"
+	         << dirMap_.size() << "directories";
+#else
+	(void)cbase;
+	(void)basePath;
+#endif
+}
+
+/**
+ * Removes all watches.
+ * Changes that were not reported yet are discarded.
+ */
+void CodebaseWatcher::unwatch()
+{
+	timer_.stop();
+	retryTimer_.stop();
+
+	delete notifier_;
+	notifier_ = NULL;
+
+#ifdef Q_OS_LINUX
+	// Closing the descriptor removes all watches.
+	if (fd_ != -1)
+		close(fd_);
+#endif
+
+	fd_ = -1;
+	dirMap_.clear();
+	fileSet_.clear();
+	changedSet_.clear();
+	lostDirSet_.clear();
+}
+
+/**
+ * Handles a file in the code base.
+ * A watch is added for the file's directory, the first time it is seen.
+ * @param  file  The path of the file
+ */
+void CodebaseWatcher::AddFileCallback::call(const QString& file)
+{
+	QString path = QDir::cleanPath(QDir(basePath_).absoluteFilePath(file));
+	watcher_->fileSet_.insert(path);
+
+	QString dir = path.left(path.lastIndexOf('/') + 1);
+	if (dirSet_.contains(dir))
+		return;
+
+	dirSet_.insert(dir);
+
+#ifdef Q_OS_LINUX
+	if (limitReached_)
+		return;
+
+	QByteArray encDir = QFile::encodeName(dir);
+	int wd = inotify_add_watch(watcher_->fd_, encDir.constData(), WatchMask);
+	if (wd == -1) {
+		// Stop once the system limit on watches is reached. Changes in the
+		// remaining directories are not reported.
+		if (errno == ENOSPC) {
+			qDebug() << "inotify watch limit reached after"
+			         << watcher_->dirMap_.size() << "directories";
+			limitReached_ = true;
+		}
+		// Watch directories that do not exist yet once they are created.
+		else if (errno == ENOENT) {
+			watcher_->lostDirSet_.insert(dir);
+		}
+		return;
+	}
+
+	watcher_->dirMap_.insert(wd, dir);
+#endif
+}
+
+/**
+ * Reads pending events from the inotify descriptor.
+ * Changed files are accumulated, and the report is postponed until events
+ * stop arriving.
+ */
+void CodebaseWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+	char buf[4096]
+		__attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	for (;;) {
+		ssize_t len = read(fd_, buf, sizeof(buf));
+		if (len <= 0)
+			break;
+
+		const char* pos = buf;
+		while (pos < buf + len) {
+			const struct inotify_event* event
+				= reinterpret_cast<const struct inotify_event*>(pos);
+			pos += sizeof(struct inotify_event) + event->len;
+
+			// A directory moved away keeps its watch, which now refers to
+			// the wrong path. Removing the watch generates IN_IGNORED.
+			if (event->mask & IN_MOVE_SELF) {
+				inotify_rm_watch(fd_, event->wd);
+				continue;
+			}
+
+			// The watch was removed, as the directory was deleted or moved.
+			if (event->mask & IN_IGNORED) {
+				dirLost(event->wd);
+				continue;
+			}
+
+			if (event->len == 0)
+				continue;
+
+			QHash<int, QString>::ConstIterator itr = dirMap_.find(event->wd);
+			if (itr == dirMap_.end())
+				continue;
+
+			// Only report files in the code base.
+			QString path = *itr + QFile::decodeName(event->name);
+			if (fileSet_.contains(path))
+				changedSet_.insert(path);
+		}
+	}
+
+	if (!changedSet_.isEmpty())
+		timer_.start();
+#endif
+}
+
+/**
+ * Handles the removal of a directory's watch.
+ * The files in the directory are reported as changed, and the watch is re-added
+ * once the directory is recreated.
+ * @param  wd  The watch descriptor of the directory
+ */
+void CodebaseWatcher::dirLost(int wd)
+{
+	QHash<int, QString>::Iterator itr = dirMap_.find(wd);
+	if (itr == dirMap_.end())
+		return;
+
+	QString dir = *itr;
+	dirMap_.erase(itr);
+
+	lostDirSet_.insert(dir);
+	markDir(dir);
+	if (!retryTimer_.isActive())
+		retryTimer_.start();
+}
+
+/**
+ * Marks all code base files in a directory as changed.
+ * @param  dir  The directory path, with a trailing '/'
+ */
+void CodebaseWatcher::markDir(const QString& dir)
+{
+	QSet<QString>::ConstIterator itr;
+	for (itr = fileSet_.begin(); itr != fileSet_.end(); ++itr) {
+		if ((*itr).startsWith(dir) && ((*itr).indexOf('/', dir.length()) == -1))
+			changedSet_.insert(*itr);
+	}
+}
+
+/**
+ * Attempts to re-add the watches of lost directories.
+ * The files of a directory that is watched again are reported as changed, as
+ * they may have been recreated with different contents.
+ */
+void CodebaseWatcher::retryWatches()
+{
+#ifdef Q_OS_LINUX
+	QSet<QString>::Iterator itr = lostDirSet_.begin();
+	while (itr != lostDirSet_.end()) {
+		QByteArray encDir = QFile::encodeName(*itr);
+		int wd = inotify_add_watch(fd_, encDir.constData(), WatchMask);
+		if (wd == -1) {
+			++itr;
+			continue;
+		}
+
+		dirMap_.insert(wd, *itr);
+		markDir(*itr);
+		itr = lostDirSet_.erase(itr);
+	}
+
+	if (!changedSet_.isEmpty())
+		timer_.start();
+#endif
+
+	if (lostDirSet_.isEmpty())
+		retryTimer_.stop();
+}
+
+/**
+ * Reports the accumulated changes.
+ */
+void CodebaseWatcher::report()
+{
+	if (changedSet_.isEmpty())
+		return;
+
+	QStringList files = changedSet_.toList();
+	changedSet_.clear();
+	emit changed(files);
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_CODEBASEWATCHER_H__
+#define __CORE_CODEBASEWATCHER_H__
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include "codebase.h"
+
+class QSocketNotifier;
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Monitors the files of a code base for changes.
+ * Watches are placed on the directories holding the files, rather than on the
+ * files themselves, so that the number of watch descriptors is proportional
+ * to the number of directories. Events for files outside the code base (e.g.,
+ * editor backup files) are ignored.
+ * Changes usually arrive in bursts (e.g., a version control update, or an
+ * editor saving a file through a temporary one), so changed files are
+ * accumulated until no event is received for a while, and then reported
+ * in a single signal.
+ * A directory that is deleted or moved away loses its watch. Its files are
+ * reported as changed, and the watch is periodically re-added, so that the
+ * directory is watched again once it is recreated.
+ * The watcher uses inotify, and is only functional on Linux.
+ * @author Elad Lahav
+ */
+class CodebaseWatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	CodebaseWatcher(QObject* parent = NULL);
+	~CodebaseWatcher();
+
+	void watch(const Codebase&, const QString&);
+	void unwatch();
+
+	/**
+	 * @param  msec  The time to wait for more events before reporting
+	 *               changes, in milliseconds
+	 */
+	void setDebounceInterval(int msec) { timer_.setInterval(msec); }
+
+	/**
+	 * @return The number of watched directories
+	 */
+	int watchCount() const { return dirMap_.size(); }
+
+signals:
+	/**
+	 * Emitted when files in the code base were modified, created or
+	 * removed.
+	 * @param  files  The changed files
+	 */
+	void changed(const QStringList& files);
+
+private:
+	/**
+	 * The inotify file descriptor, -1 if not open.
+	 */
+	int fd_;
+
+	/**
+	 * Monitors the inotify descriptor for events.
+	 */
+	QSocketNotifier* notifier_;
+
+	/**
+	 * Maps watch descriptors to directory paths (with a trailing '/').
+	 */
+	QHash<int, QString> dirMap_;
+
+	/**
+	 * The absolute paths of all files in the code base.
+	 */
+	QSet<QString> fileSet_;
+
+	/**
+	 * Changed files not reported yet.
+	 */
+	QSet<QString> changedSet_;
+
+	/**
+	 * Fires once events stop arriving.
+	 */
+	QTimer timer_;
+
+	/**
+	 * Directories (with a trailing '/') whose watches were lost, as they were
+	 * deleted or moved.
+	 */
+	QSet<QString> lostDirSet_;
+
+	/**
+	 * Periodically attempts to re-add the watches of lost directories.
+	 */
+	QTimer retryTimer_;
+
+	void addFile(const QString&);
+	void dirLost(int);
+	void markDir(const QString&);
+
+	struct AddFileCallback : public Callback<const QString&>
+	{
+		CodebaseWatcher* watcher_;
+		QString basePath_;
+		QSet<QString> dirSet_;
+		bool limitReached_;
+
+		AddFileCallback(CodebaseWatcher* watcher, const QString& basePath)
+			: watcher_(watcher), basePath_(basePath), limitReached_(false) {}
+
+		void call(const QString& file);
+	};
+
+	friend struct AddFileCallback;
+
+private slots:
+	void readEvents();
+	void report();
+	void retryWatches();
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_CODEBASEWATCHER_H__
@@ -8,6 +8,8 @@ HEADERS += locationtreemodel.h \
     locationmodel.h \
     projectconfig.h \
     filescanner.h \
+    dirwalker.h \
+    scancache.h \
     filefilter.h \
     queryview.h \
     locationlistmodel.h \
@@ -16,25 +18,39 @@ HEADERS += locationtreemodel.h \
     project.h \
     codebase.h \
     codebasemodel.h \
+    codebasewatcher.h \
     globals.h \
     process.h \
     statemachine.h \
     treeitem.h \
+    tree.h \
     progressbar.h \
     engine.h \
+    querycache.h \
     locationview.h \
+    locationfilter.h \
+    locationsorter.h \
+    locationstream.h \
     textfilterdialog.h
 FORMS += progressbar.ui \
     textfilterdialog.ui
 SOURCES += locationtreemodel.cpp \
     locationmodel.cpp \
     filescanner.cpp \
+    filefilter.cpp \
+    dirwalker.cpp \
+    scancache.cpp \
     queryview.cpp \
     locationlistmodel.cpp \
     codebasemodel.cpp \
+    codebasewatcher.cpp \
     process.cpp \
+    querycache.cpp \
     progressbar.cpp \
     locationview.cpp \
+    locationfilter.cpp \
+    locationsorter.cpp \
+    locationstream.cpp \
     textfilterdialog.cpp
 RESOURCES = core.qrc
 target.path = $${INSTALL_PATH}/lib64
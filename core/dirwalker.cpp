@@ -0,0 +1,371 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include "dirwalker.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Marks a directory as visited.
+ * @param  path  The path of the directory
+ * @return true if the directory was not visited before, false otherwise
+ */
+bool DirWalker::Pool::visit(const QString& path)
+{
+	QString canonPath = QFileInfo(path).canonicalFilePath();
+	if (canonPath.isEmpty())
+		return false;
+
+	QMutexLocker locker(&visitedLock_);
+	if (visitedDirs_.contains(canonPath))
+		return false;
+
+	visitedDirs_.insert(canonPath);
+	return true;
+}
+
+/**
+ * Class constructor.
+ * @param  pool    State shared by all walkers in the scan
+ * @param  filter  The filter to match files against
+ * @param  parent  Parent object
+ */
+DirWalker::DirWalker(Pool* pool, const FileFilter& filter, QObject* parent)
+	: QThread(parent), pool_(pool), filter_(filter.toString())
+{
+}
+
+/**
+ * Class destructor.
+ */
+DirWalker::~DirWalker()
+{
+}
+
+/**
+ * Queues a directory for scanning.
+ * @param  path      The path of the directory, with a trailing '/'
+ * @param  addFiles  Whether files in the directory should be matched against
+ *                   the filter
+ */
+void DirWalker::push(const QString& path, bool addFiles)
+{
+	Dir dir;
+	dir.path_ = path;
+	dir.addFiles_ = addFiles;
+
+	pool_->pending_.ref();
+	queueLock_.lock();
+	queue_.append(dir);
+	queueLock_.unlock();
+
+	// Let an idle walker steal the directory.
+	pool_->idleCond_.wakeOne();
+}
+
+/**
+ * Thread function.
+ * Scans directories from the walker's own queue, or stolen from other
+ * walkers, until no directory is pending in the pool.
+ */
+void DirWalker::run()
+{
+	while (!pool_->stop_.load()) {
+		Dir dir;
+		if (pop(dir) || steal(dir)) {
+			scan(dir);
+			if (!pool_->pending_.deref()) {
+				// The scan is complete, wake up all idle walkers.
+				QMutexLocker locker(&pool_->idleLock_);
+				pool_->idleCond_.wakeAll();
+			}
+
+			continue;
+		}
+
+		// Nothing to do, wait for new directories.
+		// The wait is bounded, as a directory may be pushed between the check
+		// and the wait.
+		QMutexLocker locker(&pool_->idleLock_);
+		if (pool_->pending_.load() == 0)
+			break;
+
+		pool_->idleCond_.wait(&pool_->idleLock_, 10);
+	}
+}
+
+/**
+ * Takes a directory from the back of the walker's own queue.
+ * @param  dir  Holds the directory, upon successful return
+ * @return true if successful, false if the queue is empty
+ */
+bool DirWalker::pop(Dir& dir)
+{
+	QMutexLocker locker(&queueLock_);
+	if (queue_.isEmpty())
+		return false;
+
+	dir = queue_.takeLast();
+	return true;
+}
+
+/**
+ * Takes a directory from the front of another walker's queue.
+ * @param  dir  Holds the directory, upon successful return
+ * @return true if successful, false if all queues are empty
+ */
+bool DirWalker::steal(Dir& dir)
+{
+	QList<DirWalker*>::ConstIterator itr;
+	for (itr = pool_->walkers_.begin(); itr != pool_->walkers_.end(); ++itr) {
+		DirWalker* victim = *itr;
+		if (victim == this)
+			continue;
+
+		QMutexLocker locker(&victim->queueLock_);
+		if (!victim->queue_.isEmpty()) {
+			dir = victim->queue_.takeFirst();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Scans a single directory.
+ * Files are matched against the filter, and sub-directories are queued (in a
+ * recursive scan).
+ * @param  dir  The directory to scan
+ */
+void DirWalker::scan(const Dir& dir)
+{
+	// When following symbolic links, make sure that no directory is scanned
+	// twice.
+	if (pool_->followSymLinks_ && !pool_->visit(dir.path_))
+		return;
+
+	// Use the cached contents of the directory, if it was not modified since
+	// these were recorded.
+	ScanCache::Dir record;
+	if (pool_->cache_) {
+		record.mtime_ = QFileInfo(dir.path_).lastModified()
+		                                    .toMSecsSinceEpoch();
+		const ScanCache::Dir* cached = pool_->cache_->find(dir.path_,
+		                                                   record.mtime_);
+		if (cached) {
+			dirs_.insert(dir.path_, *cached);
+			replay(dir, *cached);
+			return;
+		}
+	}
+
+#ifdef Q_OS_UNIX
+	DIR* dirp = opendir(QFile::encodeName(dir.path_).constData());
+	if (dirp == NULL)
+		return;
+
+	struct dirent* ent;
+	while ((ent = readdir(dirp)) != NULL) {
+		if (pool_->stop_.load())
+			break;
+
+		// Skip hidden entries (including "." and ".."), as does
+		// QDir::entryInfoList() without QDir::Hidden.
+		const char* name = ent->d_name;
+		if (name[0] == '.')
+			continue;
+
+		QString entryName = QFile::decodeName(name);
+		QString path = dir.path_ + entryName;
+		QByteArray encPath;
+		struct stat st;
+		bool isDir = false, isLink = false;
+
+#ifdef DT_UNKNOWN
+		if (ent->d_type == DT_DIR) {
+			isDir = true;
+		}
+		else if (ent->d_type == DT_LNK) {
+			isLink = true;
+		}
+		else if (ent->d_type != DT_UNKNOWN && ent->d_type != DT_REG) {
+			// Skip special files (devices, pipes and sockets).
+			continue;
+		}
+		else if (ent->d_type == DT_UNKNOWN) {
+#endif
+			// The file system does not report entry types, fall back to
+			// lstat(). Skip entries removed since the directory was read.
+			encPath = QFile::encodeName(path);
+			if (lstat(encPath.constData(), &st) != 0)
+				continue;
+
+			isDir = S_ISDIR(st.st_mode);
+			isLink = S_ISLNK(st.st_mode);
+			if (!isDir && !isLink && !S_ISREG(st.st_mode))
+				continue;
+#ifdef DT_UNKNOWN
+		}
+#endif
+
+		// Symbolic links require a stat() to determine whether they point to
+		// a directory. Dangling links are skipped, as they are by
+		// QDir::entryInfoList() without QDir::System.
+		if (isLink) {
+			if (encPath.isEmpty())
+				encPath = QFile::encodeName(path);
+
+			if (stat(encPath.constData(), &st) != 0)
+				continue;
+
+			isDir = S_ISDIR(st.st_mode);
+			if (!isDir && !S_ISREG(st.st_mode))
+				continue;
+		}
+
+		addEntry(dir, path, isDir, isLink);
+		if (pool_->cache_)
+			recordEntry(record, entryName, isDir, isLink);
+	}
+
+	closedir(dirp);
+#else
+	QFileInfoList infos = QDir(dir.path_).entryInfoList(QDir::Files
+	                                                   | QDir::Dirs
+	                                                   | QDir::NoDotAndDotDot);
+
+	QFileInfoList::ConstIterator itr;
+	for (itr = infos.begin(); itr != infos.end(); ++itr) {
+		if (pool_->stop_.load())
+			break;
+
+		addEntry(dir, dir.path_ + (*itr).fileName(), (*itr).isDir(),
+		         (*itr).isSymLink());
+		if (pool_->cache_) {
+			recordEntry(record, (*itr).fileName(), (*itr).isDir(),
+			            (*itr).isSymLink());
+		}
+	}
+#endif
+
+	if (pool_->cache_)
+		dirs_.insert(dir.path_, record);
+}
+
+/**
+ * Handles the entries of a directory, as recorded in the scan cache.
+ * @param  dir     The directory
+ * @param  cached  The recorded contents of the directory
+ */
+void DirWalker::replay(const Dir& dir, const ScanCache::Dir& cached)
+{
+	QStringList::ConstIterator itr;
+	for (itr = cached.files_.begin(); itr != cached.files_.end(); ++itr)
+		addEntry(dir, dir.path_ + *itr, false, false);
+
+	for (itr = cached.dirs_.begin(); itr != cached.dirs_.end(); ++itr)
+		addEntry(dir, dir.path_ + *itr, true, false);
+
+	for (itr = cached.links_.begin(); itr != cached.links_.end(); ++itr)
+		addEntry(dir, dir.path_ + *itr, true, true);
+}
+
+/**
+ * Adds a directory entry to the record stored in the scan cache.
+ * @param  record  The record of the directory
+ * @param  name    The name of the entry
+ * @param  isDir   Whether the entry is a directory (or a symbolic link to a
+ *                 directory)
+ * @param  isLink  Whether the entry is a symbolic link
+ */
+void DirWalker::recordEntry(ScanCache::Dir& record, const QString& name,
+                            bool isDir, bool isLink)
+{
+	if (!isDir)
+		record.files_.append(name);
+	else if (isLink)
+		record.links_.append(name);
+	else
+		record.dirs_.append(name);
+}
+
+/**
+ * Handles a single directory entry.
+ * @param  dir     The directory holding the entry
+ * @param  path    The path of the entry
+ * @param  isDir   Whether the entry is a directory (or a symbolic link to a
+ *                 directory)
+ * @param  isLink  Whether the entry is a symbolic link
+ */
+void DirWalker::addEntry(const Dir& dir, const QString& path, bool isDir,
+                         bool isLink)
+{
+	// Update progress information.
+	if ((pool_->scanned_.fetchAndAddRelaxed(1) & 0xff) == 0xff)
+		emit progress();
+
+	if (isDir) {
+		// Directory: scan recursively, if needed.
+		if (!pool_->recursive_)
+			return;
+
+		// Symbolic links are only followed if requested.
+		if (isLink && !pool_->followSymLinks_)
+			return;
+
+		// Add a trailing "/" to directory names, so that the filter can
+		// distinguish those from regular files.
+		// Filter behaviour for sub-directories:
+		// 1. If an inclusion rule is matched, add files.
+		// 2. If an exclusion rule is matched, do not add files.
+		// 3. If no rule is matched, inherit the behaviour of the
+		//    current directory.
+		QString dirPath = path + "/";
+		push(dirPath, filter_.match(dirPath, dir.addFiles_));
+	}
+	else if (dir.addFiles_) {
+		// File: add to the file list if the path matches the filter.
+		// The default match is set to false, so that files not matched by
+		// any rule will not be added.
+		if (filter_.match(path, false)) {
+			files_.append(path);
+			pool_->matched_.fetchAndAddRelaxed(1);
+		}
+	}
+}
+
+} // namespace Core
+
+} // namespace KScope
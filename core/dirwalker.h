@@ -0,0 +1,215 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_DIRWALKER_H__
+#define __CORE_DIRWALKER_H__
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QSet>
+#include "filefilter.h"
+#include "scancache.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * A thread that scans directories for a FileScanner.
+ * A scan is carried out by a pool of walkers. Each walker keeps its own queue
+ * of directories: sub-directories it finds are pushed to the back of its
+ * queue, and taken from there, so that a walker follows a depth-first order
+ * on its own part of the tree. A walker whose queue is empty steals a
+ * directory from the front of another walker's queue, i.e., the one closest to
+ * the root, which is likely to hold the largest amount of work.
+ * On Unix systems directories are read with readdir(), using the entry type
+ * it reports, so that there is no need to stat() each entry.
+ * If the pool has a scan cache, directories that were not modified since they
+ * were cached are not read at all.
+ * @author Elad Lahav
+ */
+class DirWalker : public QThread
+{
+	Q_OBJECT
+
+public:
+	/**
+	 * State shared by all walkers in a scan.
+	 */
+	struct Pool
+	{
+		Pool(bool recursive, bool followSymLinks,
+		     const ScanCache* cache = NULL)
+			: recursive_(recursive), followSymLinks_(followSymLinks),
+			  cache_(cache), pending_(0), scanned_(0), matched_(0),
+			  stop_(0) {}
+
+		bool visit(const QString&);
+
+		/**
+		 * Whether sub-directories are scanned.
+		 */
+		bool recursive_;
+
+		/**
+		 * Whether symbolic links to directories are followed.
+		 */
+		bool followSymLinks_;
+
+		/**
+		 * Previously recorded directory contents, NULL if not used.
+		 */
+		const ScanCache* cache_;
+
+		/**
+		 * The walkers in the pool.
+		 */
+		QList<DirWalker*> walkers_;
+
+		/**
+		 * The number of directories queued or being scanned.
+		 * The scan is complete when this number drops to 0.
+		 */
+		QAtomicInt pending_;
+
+		/**
+		 * The number of entries scanned so far.
+		 */
+		QAtomicInt scanned_;
+
+		/**
+		 * The number of files matched so far.
+		 */
+		QAtomicInt matched_;
+
+		/**
+		 * Set to non-zero to abort the scan.
+		 */
+		QAtomicInt stop_;
+
+		/**
+		 * Used by walkers to wait for work.
+		 */
+		QMutex idleLock_;
+		QWaitCondition idleCond_;
+
+		/**
+		 * The canonical paths of scanned directories, used to avoid loops
+		 * when following symbolic links.
+		 */
+		QSet<QString> visitedDirs_;
+		QMutex visitedLock_;
+	};
+
+	DirWalker(Pool*, const FileFilter&, QObject* parent = NULL);
+	~DirWalker();
+
+	void push(const QString&, bool);
+
+	/**
+	 * @return The files matched by this walker (only valid once the thread
+	 *         has finished)
+	 */
+	const QStringList& files() const { return files_; }
+
+	/**
+	 * @return The contents of directories scanned by this walker, if the
+	 *         pool has a scan cache (only valid once the thread has finished)
+	 */
+	const ScanCache::DirMap& dirs() const { return dirs_; }
+
+signals:
+	/**
+	 * Emitted after every 256 scanned entries.
+	 * The counters are available in the pool.
+	 */
+	void progress();
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * A directory waiting to be scanned.
+	 */
+	struct Dir
+	{
+		/**
+		 * The path of the directory, with a trailing '/'.
+		 */
+		QString path_;
+
+		/**
+		 * Whether files in the directory should be matched against the
+		 * filter.
+		 */
+		bool addFiles_;
+	};
+
+	/**
+	 * State shared with the other walkers.
+	 */
+	Pool* pool_;
+
+	/**
+	 * A private copy of the filter, as regular expressions cannot be
+	 * matched concurrently.
+	 */
+	FileFilter filter_;
+
+	/**
+	 * Directories queued for this walker.
+	 */
+	QList<Dir> queue_;
+
+	/**
+	 * Protects the queue.
+	 */
+	QMutex queueLock_;
+
+	/**
+	 * Files matched by this walker.
+	 */
+	QStringList files_;
+
+	/**
+	 * The contents of directories scanned by this walker, to be stored in
+	 * the scan cache.
+	 */
+	ScanCache::DirMap dirs_;
+
+	bool pop(Dir&);
+	bool steal(Dir&);
+	void scan(const Dir&);
+	void addEntry(const Dir&, const QString&, bool, bool);
+	void replay(const Dir&, const ScanCache::Dir&);
+	void recordEntry(ScanCache::Dir&, const QString&, bool, bool);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_DIRWALKER_H__
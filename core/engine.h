@@ -95,6 +95,13 @@ public:
 	 */
 	virtual Status status() const = 0;
 
+	/**
+	 * Notifies the engine that source files were modified.
+	 * An up-to-date database should then require rebuilding. The default
+	 * implementation does nothing.
+	 */
+	virtual void invalidate() {}
+
 	/**
 	 * Returns a list of Location structure fields that are filled by the given
 	 * query type.
@@ -148,7 +155,8 @@ public:
 		 * Called when query data is produced by the engine.
 		 * @param  locList  A location list, holding query results
 		 */
-		virtual void onDataReady(const Core::LocationList& locList) = 0;
+		virtual void onDataReady(const Core::CompactLocationList& locList)
+			= 0;
 
 		/**
 		 * Called when an engine operation terminates successfully.
@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "filefilter.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Determines whether a pattern has no wildcard characters.
+ * @param  pattern  The pattern to check
+ * @return true if the pattern only matches itself, false otherwise
+ */
+static inline bool isLiteral(const QString& pattern)
+{
+	return !pattern.contains('*') && !pattern.contains('?')
+	       && !pattern.contains('[') && !pattern.contains('\\');
+}
+
+/**
+ * Determines whether the given path is matched by the filter.
+ * The first rule whose pattern matches the path name is used to determine
+ * whether the path is accepted (including rule) or rejected (excluding rule).
+ * Each of the compiled structures yields its first matching rule, and
+ * regular expressions are only evaluated for rules preceding the best match
+ * found so far.
+ * @param  path           The path name to check
+ * @param  noMatchResult  The value to return in case no rule matches the
+ *                        path
+ * @return true if the path is accepted by the filter, false otherwise
+ */
+bool FileFilter::match(const QString& path, bool noMatchResult) const
+{
+	int best = ruleList_.size();
+	QHash<QString, int>::ConstIterator itr;
+
+	// Look for a literal match.
+	if (!exactMap_.isEmpty()) {
+		itr = exactMap_.find(path);
+		if (itr != exactMap_.end() && *itr < best)
+			best = *itr;
+	}
+
+	// Look up the extension.
+	if (!extMap_.isEmpty()) {
+		int dot = path.lastIndexOf('.');
+		if (dot != -1) {
+			itr = extMap_.find(path.mid(dot + 1));
+			if (itr != extMap_.end() && *itr < best)
+				best = *itr;
+		}
+	}
+
+	// Walk the prefix trie along the path.
+	if (!prefixTrie_.isEmpty()) {
+		int node = 0;
+		for (int i = 0; ; i++) {
+			const TrieNode& trieNode = prefixTrie_[node];
+			if (trieNode.rule_ != -1 && trieNode.rule_ < best)
+				best = trieNode.rule_;
+
+			if (i == path.size())
+				break;
+
+			QHash<QChar, int>::ConstIterator child
+				= trieNode.children_.find(path[i]);
+			if (child == trieNode.children_.end())
+				break;
+
+			node = *child;
+		}
+	}
+
+	// Check other suffixes.
+	QList< QPair<QString, int> >::ConstIterator suffix;
+	for (suffix = suffixList_.begin(); suffix != suffixList_.end();
+	     ++suffix) {
+		if ((*suffix).second >= best)
+			break;
+
+		if (path.endsWith((*suffix).first)) {
+			best = (*suffix).second;
+			break;
+		}
+	}
+
+	// Match regular expressions preceding the best rule so far.
+	QList<int>::ConstIterator rule;
+	for (rule = complexList_.begin(); rule != complexList_.end(); ++rule) {
+		if (*rule >= best)
+			break;
+
+		if (ruleList_[*rule].exp_.exactMatch(path)) {
+			best = *rule;
+			break;
+		}
+	}
+
+	if (best == ruleList_.size())
+		return noMatchResult;
+
+	return ruleList_[best].type_ == Rule::Include;
+}
+
+/**
+ * Converts a semicolon-delimited string into a list of rules.
+ * @param  filter  The filter string to parse
+ */
+void FileFilter::parse(const QString& filter)
+{
+	// Split the filter string to get a list of patterns.
+	QStringList patterns = filter.split(';', QString::SkipEmptyParts);
+
+	// Create a rule for each pattern.
+	QStringList::Iterator itr;
+	for (itr = patterns.begin(); itr != patterns.end(); ++itr) {
+		ruleList_.append(Rule(*itr));
+		compile(ruleList_.last().exp_.pattern(), ruleList_.size() - 1);
+	}
+}
+
+/**
+ * Adds a rule to the structure matching its pattern.
+ * Rules are compiled in order, so that a rule is only recorded for a key if no
+ * earlier rule was recorded for the same key.
+ * @param  pattern  The rule's pattern
+ * @param  index    The rule's position in the list
+ */
+void FileFilter::compile(const QString& pattern, int index)
+{
+	if (isLiteral(pattern)) {
+		// A literal path.
+		if (!exactMap_.contains(pattern))
+			exactMap_.insert(pattern, index);
+	}
+	else if (pattern.startsWith('*') && isLiteral(pattern.mid(1))) {
+		// A suffix.
+		// Extensions without a dot get a hash lookup: the suffix of the path
+		// following its last dot is then the same as the rule's.
+		QString suffix = pattern.mid(1);
+		if (suffix.startsWith('.') && suffix.indexOf('.', 1) == -1) {
+			QString ext = suffix.mid(1);
+			if (!extMap_.contains(ext))
+				extMap_.insert(ext, index);
+		}
+		else {
+			suffixList_.append(qMakePair(suffix, index));
+		}
+	}
+	else if (pattern.endsWith('*') && isLiteral(pattern.left(pattern.size()
+	                                                          - 1))) {
+		// A prefix.
+		if (prefixTrie_.isEmpty())
+			prefixTrie_.append(TrieNode());
+
+		int node = 0;
+		for (int i = 0; i < pattern.size() - 1; i++) {
+			QHash<QChar, int>::ConstIterator child
+				= prefixTrie_[node].children_.find(pattern[i]);
+			if (child != prefixTrie_[node].children_.end()) {
+				node = *child;
+				continue;
+			}
+
+			prefixTrie_.append(TrieNode());
+			prefixTrie_[node].children_.insert(pattern[i],
+			                                   prefixTrie_.size() - 1);
+			node = prefixTrie_.size() - 1;
+		}
+
+		if (prefixTrie_[node].rule_ == -1)
+			prefixTrie_[node].rule_ = index;
+	}
+	else {
+		complexList_.append(index);
+	}
+}
+
+}
+
+}
@@ -22,6 +22,11 @@
 #define __CORE_FILEFILTER_H__
 
 #include <QList>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+#include <QRegExp>
+#include <QStringList>
 
 namespace KScope
 {
@@ -40,6 +45,10 @@ namespace Core
  * - Each rule is given as a simplified (shell-style) regular expression
  * - By default a rule is classified as an inclusion one
  * - To create an exclusion rule, prefix the expression with a minus sign (-)
+ * Rules are compiled when the filter is created. Literal paths, suffixes
+ * (e.g., "*.c") and prefixes (e.g., "test_*") are looked up in hash
+ * tables and a trie, so that regular expressions are only evaluated for the
+ * remaining rules, and only if these precede any matching simple rule.
  * @author Elad Lahav
  */
 class FileFilter
@@ -60,26 +69,7 @@ public:
 		parse(filter);
 	}
 
-	/**
-	 * Determines whether the given path is matched by the filter.
-	 * Iterates over the list of rules. The first rule whose pattern matches
-	 * the path name is used to determine whether the path is accepted
-	 * (including rule) or rejected (excluding rule).
-	 * @param  path           The path name to check
-	 * @param  noMatchResult  The value to return in case no rule matches the
-	 *                        path
-	 * @return true if the path is accepted by the filter, false otherwise
-	 */
-	bool match(const QString& path, bool noMatchResult) const {
-		QList<Rule>::ConstIterator itr;
-
-		for (itr = ruleList_.begin(); itr != ruleList_.end(); ++itr) {
-			if ((*itr).exp_.exactMatch(path))
-				return (((*itr).type_ == Rule::Include) ? true : false);
-		}
-
-		return noMatchResult;
-	}
+	bool match(const QString&, bool) const;
 
 	/**
 	 * Creates a semicolon delimited representation of the filter.
@@ -135,24 +125,58 @@ private:
 		Type type_;
 	};
 
+	/**
+	 * A node in the prefix trie.
+	 */
+	struct TrieNode {
+		TrieNode() : rule_(-1) {}
+
+		/**
+		 * Maps characters to the positions of child nodes.
+		 */
+		QHash<QChar, int> children_;
+
+		/**
+		 * The first rule whose prefix ends at this node, -1 if none.
+		 */
+		int rule_;
+	};
+
 	/**
 	 * The filter, represented as an ordered list of rules.
 	 */
 	QList<Rule> ruleList_;
 
 	/**
-	 * Converts a semicolon-delimited string into a list of rules.
-	 * @param  filter  The filter string to parse
+	 * Maps literal paths to the first rule matching them exactly.
 	 */
-	void parse(const QString& filter) {
-		// Split the filter string to get a list of patterns.
-		QStringList patterns = filter.split(';', QString::SkipEmptyParts);
-
-		// Create a rule for each pattern.
-		QStringList::Iterator itr;
-		for (itr = patterns.begin(); itr != patterns.end(); ++itr)
-			ruleList_.append(Rule(*itr));
-	}
+	QHash<QString, int> exactMap_;
+
+	/**
+	 * Maps file extensions to the first "*.ext" rule for each.
+	 */
+	QHash<QString, int> extMap_;
+
+	/**
+	 * Other "*suffix" rules, as pairs of a suffix and a rule index, in rule
+	 * order.
+	 */
+	QList< QPair<QString, int> > suffixList_;
+
+	/**
+	 * A trie of the literal parts of "prefix*" rules.
+	 * The root node, if any, is the first element.
+	 */
+	QVector<TrieNode> prefixTrie_;
+
+	/**
+	 * Indices of rules that need to be matched as regular expressions, in
+	 * rule order.
+	 */
+	QList<int> complexList_;
+
+	void parse(const QString&);
+	void compile(const QString&, int);
 };
 
 }
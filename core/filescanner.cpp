@@ -18,7 +18,7 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
-#include <QApplication>
+#include <QThread>
 #include <QDebug>
 #include "filescanner.h"
 
@@ -33,7 +33,11 @@ namespace Core
  * @param  parent  Owner object
  */
 FileScanner::FileScanner(QObject* parent) : QObject(parent),
-                                            followSymLinks_(false)
+                                            followSymLinks_(false),
+                                            stop_(false),
+                                            pool_(NULL),
+                                            cache_(NULL),
+                                            running_(0)
 {
 }
 
@@ -46,6 +50,8 @@ FileScanner::~FileScanner()
 
 /**
  * Starts a scan on a directory, using the given filter.
+ * The method returns once the scan is complete, but events are processed
+ * while waiting.
  * @param  dir        The directory to scan
  * @param  filter     The filter to use
  * @param  recursive  true for recursive scan, false otherwise
@@ -54,9 +60,9 @@ FileScanner::~FileScanner()
 bool FileScanner::scan(const QDir& dir, const FileFilter& filter,
 	                   bool recursive)
 {
-	scanned_ = 0;
 	fileList_.clear();
-	filter_ = filter;
+	addedList_.clear();
+	removedList_.clear();
 	stop_ = false;
 
 	// In a recursive scan, add only files under directories matching the filter
@@ -65,95 +71,104 @@ bool FileScanner::scan(const QDir& dir, const FileFilter& filter,
 	if (!path.endsWith("/"))
 		path += "/";
 
-	bool addFiles = recursive ? filter_.match(path, true) : true;
+	bool addFiles = recursive ? filter.match(path, true) : true;
 	qDebug() << "Scanning" << path << recursive << addFiles;
-	return scan(dir, recursive, addFiles);
+
+	// Create the walkers.
+	// A single directory does not benefit from more than one.
+	if (cache_)
+		cache_->startScan();
+
+	DirWalker::Pool pool(recursive, followSymLinks_, cache_);
+	int count = recursive ? qMax(QThread::idealThreadCount(), 1) : 1;
+	for (int i = 0; i < count; i++) {
+		DirWalker* walker = new DirWalker(&pool, filter, this);
+		connect(walker, SIGNAL(progress()), this, SLOT(walkerProgress()),
+		        Qt::QueuedConnection);
+		connect(walker, SIGNAL(finished()), this, SLOT(walkerFinished()),
+		        Qt::QueuedConnection);
+		pool.walkers_.append(walker);
+	}
+
+	// Start the scan, and wait for all walkers to finish.
+	pool_ = &pool;
+	running_ = count;
+	pool.walkers_.first()->push(path, addFiles);
+	foreach (DirWalker* walker, pool.walkers_)
+		walker->start();
+
+	loop_.exec();
+
+	// Collect the results.
+	ScanCache::DirMap dirMap;
+	foreach (DirWalker* walker, pool.walkers_) {
+		walker->wait();
+		fileList_ += walker->files();
+		if (cache_ && !stop_)
+			dirMap.unite(walker->dirs());
+		delete walker;
+	}
+
+	pool_ = NULL;
+	if (stop_) {
+		fileList_.clear();
+		return false;
+	}
+
+	// Walkers run concurrently, so results need to be sorted to be
+	// consistent between scans.
+	fileList_.sort();
+
+	// Update the cache, and compare the results with the previous scan.
+	if (cache_) {
+		cache_->update(dirMap, path, recursive);
+
+		QString key = QString("%1\n%2\n%3").arg(path)
+		                                   .arg(filter.toString())
+		                                   .arg(recursive);
+		cache_->updateResult(key, fileList_, addedList_, removedList_);
+	}
+	else {
+		addedList_ = fileList_;
+	}
+
+	return true;
 }
 
 /**
- * Implements a directory scan.
- * @param dir        The directory to scan
- * @param recursive  true for recursive scan, false otherwise
- * @return true if successful, false if the scan was aborted
+ * Signals the scan process to stop.
  */
-bool FileScanner::scan(const QDir& dir, bool recursive, bool addFiles)
+void FileScanner::stop()
 {
-	// Get a list of all entries in the directory.
-	QFileInfoList infos = dir.entryInfoList(QDir::Files | QDir::Dirs
-	                                        | QDir::NoDotAndDotDot);
-
-	// Mark this directory as visited (if following symbolic links).
-	if (followSymLinks_)
-		visitedDirs_.insert(dir.absolutePath());
-
-	// Iterate over the list.
-	QFileInfoList::Iterator itr;
-	for (itr = infos.begin(); itr != infos.end(); ++itr) {
-		// Make sure event processing continues during a long scan.
-		qApp->processEvents();
-		if (stop_)
-			return false;
-
-		// Update and emit progress information.
-		scanned_++;
-		if ((scanned_ & 0xff) == 0) {
-			if (!progressMessage_.isEmpty()) {
-				QString msg = progressMessage_.arg(scanned_)
-				                              .arg(fileList_.size());
-				emit progress(msg);
-			}
-			else {
-				emit progress(scanned_, fileList_.size());
-			}
-		}
-
-		// Get the file's path.
-		QString path = (*itr).filePath();
-		if ((*itr).isDir()) {
-			// Directory: scan recursively, if needed.
-			if (recursive) {
-				// Handle symbolic links.
-				if ((*itr).isSymLink()) {
-					qDebug() << __func__ << (*itr).absoluteFilePath();
-
-					// If symbolic links are followed, make sure we do not
-					// descend into an already-visited directory.
-					if (!followSymLinks_
-						|| visitedDirs_.contains((*itr).absoluteFilePath())) {
-							continue;
-					}
-				}
-
-				// Change directory.
-				QDir childDir(dir);
-				if (!childDir.cd((*itr).fileName()))
-					continue;
-
-				// Add a trailing "/" to directory names, so that the filter can
-				// distinguish those from regular files.
-				if (!path.endsWith('/'))
-					path += "/";
-
-				// Scan recursively.
-				// Filter behaviour for sub-directories:
-				// 1. If an inclusion rule is matched, add files.
-				// 2. If an exclusion rule is matched, do not add files.
-				// 3. If no rule is matched, inherit the behaviour of the
-				//    current directory.
-				if (!scan(childDir, true, filter_.match(path, addFiles)))
-					return false;
-			}
-		}
-		else if (addFiles) {
-			// File: add to the file list if the path matches the filter.
-			// The default match is set to false, so that files not matched by
-			// any rule will not be added.
-			if (filter_.match(path, false))
-				fileList_.append(path);
-		}
-	}
+	stop_ = true;
+	if (pool_)
+		pool_->stop_.store(1);
+}
 
-	return true;
+/**
+ * Emits progress information, when notified by a walker.
+ */
+void FileScanner::walkerProgress()
+{
+	if (!pool_)
+		return;
+
+	int scanned = pool_->scanned_.load();
+	int matched = pool_->matched_.load();
+	if (!progressMessage_.isEmpty())
+		emit progress(progressMessage_.arg(scanned).arg(matched));
+	else
+		emit progress(scanned, matched);
+}
+
+/**
+ * Called when a walker thread terminates.
+ * Ends the scan once all walkers are done.
+ */
+void FileScanner::walkerFinished()
+{
+	if (--running_ == 0)
+		loop_.quit();
 }
 
 }
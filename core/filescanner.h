@@ -23,8 +23,10 @@
 
 #include <QObject>
 #include <QDir>
-#include <QSet>
+#include <QEventLoop>
 #include "filefilter.h"
+#include "dirwalker.h"
+#include "scancache.h"
 
 namespace KScope
 {
@@ -39,6 +41,11 @@ namespace Core
  * is possible to set an option for following symbolic links, which somewhat
  * degrades performance (as the scanner needs to keep track of visited
  * directories to avoid loops).
+ * Recursive scans are carried out by a pool of DirWalker threads. The calling
+ * thread runs a local event loop until the scan is complete, during which
+ * progress is reported through queued signals from the walkers.
+ * An optional scan cache allows unmodified directories to be skipped, and
+ * provides the differences from the previous scan of the same directory.
  * @author Elad Lahav
  */
 class FileScanner : public QObject
@@ -70,17 +77,34 @@ public:
 		progressMessage_ = msg;
 	}
 
+	/**
+	 * Sets a cache to use for subsequent scans.
+	 * @param  cache  The cache object (owned by the caller), NULL to scan
+	 *                without a cache
+	 */
+	void setCache(ScanCache* cache) { cache_ = cache; }
+
 	/**
 	 * Returns the list of files matched during the last scan.
 	 * @return The matching file list
 	 */
 	const QStringList& matchedFiles() const { return fileList_; }
 
-public slots:
 	/**
-	 * Signals the scan process to stop.
+	 * @return Files matched by the last scan, but not by the previous scan
+	 *         of the same directory with the same filter (all matched files
+	 *         if there is no cache)
 	 */
-	void stop() { stop_ = true; }
+	const QStringList& addedFiles() const { return addedList_; }
+
+	/**
+	 * @return Files matched by the previous scan of the same directory with
+	 *         the same filter, but not by the last scan
+	 */
+	const QStringList& removedFiles() const { return removedList_; }
+
+public slots:
+	void stop();
 
 signals:
 	void progress(int scanned, int matched);
@@ -91,14 +115,36 @@ private:
 	 * true to follow symbolic links, false (default) to skip them.
 	 */
 	bool followSymLinks_;
-	int scanned_;
 	QStringList fileList_;
-	FileFilter filter_;
+	QStringList addedList_;
+	QStringList removedList_;
 	bool stop_;
 	QString progressMessage_;
-	QSet<QString> visitedDirs_;
 
-	bool scan(const QDir&, bool, bool);
+	/**
+	 * State shared by the walkers of the current scan, NULL if no scan is in
+	 * progress.
+	 */
+	DirWalker::Pool* pool_;
+
+	/**
+	 * Previously recorded directory contents, NULL if not used.
+	 */
+	ScanCache* cache_;
+
+	/**
+	 * The number of walkers that have not finished yet.
+	 */
+	int running_;
+
+	/**
+	 * Runs while waiting for the walkers.
+	 */
+	QEventLoop loop_;
+
+private slots:
+	void walkerProgress();
+	void walkerFinished();
 };
 
 }
@@ -23,6 +23,9 @@
 
 #include <QString>
 #include <QVariant>
+#include <QList>
+#include <QVector>
+#include <QHash>
 
 namespace KScope
 {
@@ -184,6 +187,251 @@ struct Location
  */
 typedef QList<Location> LocationList;
 
+/**
+ * A compact list of locations, used for query results.
+ * Instead of holding a Location object per entry, the list keeps a column per
+ * field. File paths, tag names and scopes are interned in a string pool, as
+ * these tend to repeat across many results, and each entry only stores the
+ * index of the string in the pool. Line texts are kept one after the other in
+ * a single string.
+ * Copying the list is cheap, as all members are implicitly shared.
+ * @author Elad Lahav
+ */
+class CompactLocationList
+{
+public:
+	/**
+	 * Class constructor.
+	 * Creates an empty list.
+	 */
+	CompactLocationList() { clear(); }
+
+	/**
+	 * Class constructor.
+	 * Creates a compact copy of a list of locations.
+	 * @param  locList  The list to copy
+	 */
+	explicit CompactLocationList(const LocationList& locList) {
+		clear();
+		reserve(locList.size());
+
+		LocationList::ConstIterator itr;
+		for (itr = locList.begin(); itr != locList.end(); ++itr)
+			append(*itr);
+	}
+
+	/**
+	 * @return The number of locations in the list
+	 */
+	int size() const { return line_.size(); }
+
+	/**
+	 * @return true if the list has no locations, false otherwise
+	 */
+	bool isEmpty() const { return line_.isEmpty(); }
+
+	/**
+	 * Removes all locations.
+	 */
+	void clear() {
+		*this = CompactLocationList(0);
+		intern(QString());
+	}
+
+	/**
+	 * Pre-allocates space for the given number of locations.
+	 * @param  size  The expected number of locations
+	 */
+	void reserve(int size) {
+		file_.reserve(size);
+		line_.reserve(size);
+		column_.reserve(size);
+		name_.reserve(size);
+		type_.reserve(size);
+		scope_.reserve(size);
+		textPos_.reserve(size);
+	}
+
+	/**
+	 * Adds a location at the end of the list.
+	 * @param  loc  The location to add
+	 */
+	void append(const Location& loc) {
+		file_.append(intern(loc.file_));
+		line_.append(loc.line_);
+		column_.append(loc.column_);
+		name_.append(intern(loc.tag_.name_));
+		type_.append(loc.tag_.type_);
+		scope_.append(intern(loc.tag_.scope_));
+		textPos_.append(text_.size());
+		text_.append(loc.text_);
+	}
+
+	/**
+	 * Adds all locations in another list at the end of this one.
+	 * Strings from the other list's pool are interned once each.
+	 * @param  other  The list to add
+	 * @return A reference to this object
+	 */
+	CompactLocationList& operator+=(const CompactLocationList& other) {
+		if (isEmpty()) {
+			*this = other;
+			return *this;
+		}
+
+		// Map the string pool of the other list to this one.
+		QVector<quint32> ids(other.strings_.size());
+		for (int i = 0; i < other.strings_.size(); i++)
+			ids[i] = intern(other.strings_[i]);
+
+		reserve(size() + other.size());
+		for (int i = 0; i < other.size(); i++) {
+			file_.append(ids[other.file_[i]]);
+			line_.append(other.line_[i]);
+			column_.append(other.column_[i]);
+			name_.append(ids[other.name_[i]]);
+			type_.append(other.type_[i]);
+			scope_.append(ids[other.scope_[i]]);
+			textPos_.append(text_.size() + other.textPos_[i]);
+		}
+
+		text_.append(other.text_);
+		return *this;
+	}
+
+	/**
+	 * Exchanges the contents of this list with another one.
+	 * @param  other  The list to swap with
+	 */
+	void swap(CompactLocationList& other) {
+		CompactLocationList tmp = other;
+		other = *this;
+		*this = tmp;
+	}
+
+	/**
+	 * Creates a Location object for an entry in the list.
+	 * @param  i  The position of the entry
+	 * @return The location
+	 */
+	Location at(int i) const {
+		Location loc(file(i), line(i), column(i));
+		loc.tag_.name_ = tagName(i);
+		loc.tag_.type_ = tagType(i);
+		loc.tag_.scope_ = scope(i);
+		loc.text_ = text(i);
+		return loc;
+	}
+
+	/**
+	 * @return A list of Location objects for all entries
+	 */
+	LocationList toList() const {
+		LocationList locList;
+		locList.reserve(size());
+		for (int i = 0; i < size(); i++)
+			locList.append(at(i));
+
+		return locList;
+	}
+
+	const QString& file(int i) const { return strings_[file_[i]]; }
+	uint line(int i) const { return line_[i]; }
+	uint column(int i) const { return column_[i]; }
+	const QString& tagName(int i) const { return strings_[name_[i]]; }
+	Tag::Type tagType(int i) const { return (Tag::Type)type_[i]; }
+	const QString& scope(int i) const { return strings_[scope_[i]]; }
+
+	/**
+	 * @param  i  The position of the entry
+	 * @return The line text of the entry
+	 */
+	QString text(int i) const {
+		int end = (i + 1 < textPos_.size()) ? textPos_[i + 1] : text_.size();
+		return text_.mid(textPos_[i], end - textPos_[i]);
+	}
+
+	/**
+	 * Changes the scope of an entry.
+	 * @param  i      The position of the entry
+	 * @param  scope  The new scope
+	 */
+	void setScope(int i, const QString& scope) { scope_[i] = intern(scope); }
+
+	/**
+	 * Estimates the amount of memory used by the list.
+	 * @return The approximate size of the list, in bytes
+	 */
+	int memorySize() const {
+		int total = sizeof(*this) + text_.size() * sizeof(QChar);
+		total += size() * (6 * sizeof(quint32) + sizeof(quint8));
+		for (int i = 0; i < strings_.size(); i++) {
+			// Each string is referenced by both the pool and the hash.
+			total += strings_[i].size() * sizeof(QChar) + 64;
+		}
+
+		return total;
+	}
+
+private:
+	/**
+	 * Creates an empty list, without a string pool.
+	 * Used by clear().
+	 */
+	explicit CompactLocationList(int) {}
+
+	/**
+	 * The string pool, for file paths, tag names and scopes.
+	 * The first entry is always the empty string.
+	 */
+	QVector<QString> strings_;
+
+	/**
+	 * Maps strings to their positions in the pool.
+	 */
+	QHash<QString, quint32> stringIds_;
+
+	/**
+	 * Columns holding the fields of each entry.
+	 */
+	QVector<quint32> file_;
+	QVector<quint32> line_;
+	QVector<quint32> column_;
+	QVector<quint32> name_;
+	QVector<quint8> type_;
+	QVector<quint32> scope_;
+
+	/**
+	 * The position in text_ of the line text of each entry.
+	 */
+	QVector<quint32> textPos_;
+
+	/**
+	 * The line texts of all entries.
+	 */
+	QString text_;
+
+	/**
+	 * Finds or adds a string in the pool.
+	 * @param  str  The string
+	 * @return The position of the string in the pool
+	 */
+	quint32 intern(const QString& str) {
+		if (str.isEmpty() && !strings_.isEmpty())
+			return 0;
+
+		QHash<QString, quint32>::ConstIterator itr
+			= stringIds_.constFind(str);
+		if (itr != stringIds_.constEnd())
+			return itr.value();
+
+		quint32 id = strings_.size();
+		strings_.append(str);
+		stringIds_.insert(str, id);
+		return id;
+	}
+};
+
 /**
  * Defines parameters for running queries on an engine.
  */
@@ -229,7 +477,12 @@ struct Query
 		/**
 		 * The pattern is a regular expression.
 		 */
-		RegExp = 0x2
+		RegExp = 0x2,
+		/**
+		 * A speculative query, which should not delay queries requested by
+		 * the user.
+		 */
+		Background = 0x4
 	};
 
 	/**
@@ -246,7 +499,7 @@ struct Query
 	 * Default constructor.
 	 * Creates an invalid query object.
 	 */
-	Query() : type_(Invalid) {}
+	Query() : type_(Invalid), flags_(0) {}
 
 	/**
 	 * Struct constructor.
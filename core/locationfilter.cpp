@@ -0,0 +1,235 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QElapsedTimer>
+#include "locationfilter.h"
+#include "locationmodel.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The number of rows examined between checks for cancellation.
+ */
+static const int ChunkSize = 4096;
+
+/**
+ * The time, in milliseconds, before the first partial results are published.
+ */
+static const int FirstPublishInterval = 50;
+
+/**
+ * The time, in milliseconds, between publishing partial results.
+ */
+static const int PublishInterval = 250;
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+LocationFilter::LocationFilter(QObject* parent)
+	: QThread(parent), field_(Location::File), id_(0),
+	  indexField_(Location::File), prevCs_(Qt::CaseSensitive), narrow_(false),
+	  stop_(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+LocationFilter::~LocationFilter()
+{
+	stop();
+}
+
+/**
+ * Starts matching a filter against a list of locations.
+ * A filter that is already running is stopped first.
+ * The list must either be the one used by previous filters, possibly with
+ * more locations at its end, or the filter needs to be reset() first.
+ * @param  locList   The list to filter
+ * @param  field     The field to match
+ * @param  rootPath  Root path, replaced by "$" in file paths
+ * @param  regExp    The filter
+ * @return An identifier for the filter, used by the matched() signal
+ */
+int LocationFilter::apply(const CompactLocationList& locList,
+                          Location::Fields field, const QString& rootPath,
+                          const QRegExp& regExp)
+{
+	stop();
+
+	// The index is only valid for the field and root path it was built for.
+	if ((field != indexField_) || (rootPath != indexRootPath_)
+	    || (locList.size() < index_.size())) {
+		reset();
+		indexField_ = field;
+		indexRootPath_ = rootPath;
+	}
+
+	locList_ = locList;
+	field_ = field;
+	rootPath_ = rootPath;
+	regExp_ = regExp;
+	literal_ = literal(regExp);
+	if (!literal_.isNull() && regExp.caseSensitivity() == Qt::CaseInsensitive)
+		literal_ = literal_.toLower();
+
+	// A plain string that contains the previous one can only match rows that
+	// were matched by the previous string.
+	narrow_ = !literal_.isNull() && !prevLiteral_.isNull()
+	          && (regExp.caseSensitivity() == prevCs_)
+	          && literal_.contains(prevLiteral_);
+
+	id_++;
+	stop_.store(0);
+	start();
+	return id_;
+}
+
+/**
+ * Aborts the current filter, if any, and waits for the thread to terminate.
+ */
+void LocationFilter::stop()
+{
+	stop_.store(1);
+	wait();
+}
+
+/**
+ * Discards the index and the results of previous filters.
+ * Must be called when the filtered list is replaced.
+ */
+void LocationFilter::reset()
+{
+	stop();
+
+	locList_.clear();
+	index_.clear();
+	lowerIndex_.clear();
+	prevMatches_.clear();
+	prevLiteral_ = QString();
+}
+
+/**
+ * The thread's main function.
+ * Examines the rows in order, extending the index as required.
+ */
+void LocationFilter::run()
+{
+	int rows = locList_.size();
+	QBitArray matches(rows);
+	bool lower = !literal_.isNull()
+	             && (regExp_.caseSensitivity() == Qt::CaseInsensitive);
+
+	QElapsedTimer timer;
+	timer.start();
+	qint64 nextPublish = FirstPublishInterval;
+
+	for (int row = 0; row < rows; row++) {
+		// Check for cancellation, and publish partial results, once per
+		// chunk.
+		if ((row > 0) && ((row % ChunkSize) == 0)) {
+			if (stop_.load())
+				return;
+
+			if (timer.elapsed() >= nextPublish) {
+				emit matched(id_, matches, row);
+				nextPublish = timer.elapsed() + PublishInterval;
+			}
+		}
+
+		if (row >= index_.size())
+			index_.append(LocationModel::fieldText(locList_, row, field_,
+			                                      rootPath_));
+
+		// Skip rows rejected by the previous filter.
+		if (narrow_ && (row < prevMatches_.size())
+		    && !prevMatches_.testBit(row)) {
+			continue;
+		}
+
+		bool match;
+		if (lower) {
+			while (lowerIndex_.size() <= row)
+				lowerIndex_.append(index_[lowerIndex_.size()].toLower());
+
+			match = lowerIndex_[row].contains(literal_);
+		}
+		else if (!literal_.isNull()) {
+			match = index_[row].contains(literal_);
+		}
+		else {
+			match = (regExp_.indexIn(index_[row]) >= 0);
+		}
+
+		if (match)
+			matches.setBit(row);
+	}
+
+	// Keep the results for narrowing the next filter.
+	prevMatches_ = matches;
+	prevLiteral_ = literal_;
+	prevCs_ = regExp_.caseSensitivity();
+
+	emit matched(id_, matches, rows);
+}
+
+/**
+ * Determines whether a filter matches a plain string.
+ * @param  regExp  The filter
+ * @return The string, or a null string if the filter uses special characters
+ */
+QString LocationFilter::literal(const QRegExp& regExp)
+{
+	QString special;
+	switch (regExp.patternSyntax()) {
+	case QRegExp::FixedString:
+		return regExp.pattern();
+
+	case QRegExp::Wildcard:
+	case QRegExp::WildcardUnix:
+		special = "\\*?[]";
+		break;
+
+	case QRegExp::RegExp:
+	case QRegExp::RegExp2:
+		special = "\\^$.|?*+()[]{}";
+		break;
+
+	default:
+		return QString();
+	}
+
+	QString pattern = regExp.pattern();
+	foreach (QChar c, pattern) {
+		if (special.contains(c))
+			return QString();
+	}
+
+	return pattern;
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_LOCATIONFILTER_H__
+#define __CORE_LOCATIONFILTER_H__
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QRegExp>
+#include <QVector>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * A thread that matches a text filter against one field of a list of
+ * locations.
+ * The text of the filtered field is computed once per row and kept as an
+ * index, which is reused by later filters on the same field. Filters that are
+ * plain strings are matched using a lower-case copy of the index when case is
+ * ignored. If such a filter extends the previous one, only rows matched by the
+ * previous filter are examined.
+ * Partial results are published periodically by the matched() signal, so that
+ * the view can display matching rows before the whole list is examined.
+ * @author Elad Lahav
+ */
+class LocationFilter : public QThread
+{
+	Q_OBJECT
+
+public:
+	LocationFilter(QObject* parent = NULL);
+	~LocationFilter();
+
+	int apply(const CompactLocationList&, Location::Fields, const QString&,
+	          const QRegExp&);
+	void stop();
+	void reset();
+
+signals:
+	/**
+	 * Publishes the results of a filter.
+	 * @param  id       Identifies the filter, as returned by apply()
+	 * @param  matches  A bit per row, set for matching rows
+	 * @param  rows     The number of rows examined so far
+	 */
+	void matched(int id, const QBitArray& matches, int rows);
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The list to filter.
+	 */
+	CompactLocationList locList_;
+
+	/**
+	 * The filtered field.
+	 */
+	Location::Fields field_;
+
+	/**
+	 * Root path, replaced by "$" in file paths.
+	 */
+	QString rootPath_;
+
+	/**
+	 * The filter.
+	 */
+	QRegExp regExp_;
+
+	/**
+	 * The filter as a plain string (lower-case if case is ignored), or a null
+	 * string if the filter is not a plain string.
+	 */
+	QString literal_;
+
+	/**
+	 * Identifies the current filter.
+	 */
+	int id_;
+
+	/**
+	 * The text of the filtered field in each row.
+	 */
+	QVector<QString> index_;
+
+	/**
+	 * A lower-case copy of the index, built on demand.
+	 */
+	QVector<QString> lowerIndex_;
+
+	/**
+	 * The field and root path for which the index was built.
+	 */
+	Location::Fields indexField_;
+	QString indexRootPath_;
+
+	/**
+	 * The results of the last filter that ran to completion.
+	 */
+	QBitArray prevMatches_;
+
+	/**
+	 * The last complete filter as a plain string, or a null string if it was
+	 * not a plain string.
+	 */
+	QString prevLiteral_;
+
+	/**
+	 * The case sensitivity of the last complete filter.
+	 */
+	Qt::CaseSensitivity prevCs_;
+
+	/**
+	 * Whether only rows matched by the last complete filter need to be
+	 * examined.
+	 */
+	bool narrow_;
+
+	/**
+	 * Set to abort the filter.
+	 */
+	QAtomicInt stop_;
+
+	static QString literal(const QRegExp&);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_LOCATIONFILTER_H__
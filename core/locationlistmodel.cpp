@@ -48,7 +48,7 @@ LocationListModel::~LocationListModel()
  * @param  locList  Result information
  * @param  parent   Index under which to add the results (ignored)
  */
-void LocationListModel::add(const LocationList& locList,
+void LocationListModel::add(const CompactLocationList& locList,
                             const QModelIndex& parent)
 {
 	(void)parent;
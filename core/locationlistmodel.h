@@ -45,8 +45,15 @@ public:
 	~LocationListModel();
 
 	// LocationMode implementation.
-	void add(const LocationList&, const QModelIndex& index = QModelIndex());
+	void add(const CompactLocationList&,
+	         const QModelIndex& index = QModelIndex());
 	IsEmptyResult isEmpty(const QModelIndex&) const;
+
+	/**
+	 * @return The locations held by the model
+	 */
+	const CompactLocationList& locations() const { return locList_; }
+
 	void clear(const QModelIndex& parent = QModelIndex());
 	bool locationFromIndex(const QModelIndex&, Location&) const;
 	bool firstLocation(Location&) const;
@@ -65,7 +72,7 @@ private:
 	/**
 	 * Result list.
 	 */
-	LocationList locList_;
+	CompactLocationList locList_;
 
 	/**
 	 * Whether add() was called.
@@ -28,6 +28,11 @@ namespace KScope
 namespace Core
 {
 
+/**
+ * The maximal number of paths held by the display path cache.
+ */
+static const int MaxDisplayPaths = 100000;
+
 /**
  * Class constructor.
  * @param  parent   Parent object
@@ -58,6 +63,7 @@ void LocationModel::setRootPath(const QString& path)
 	if (actPath != rootPath_) {
                 beginResetModel();
 		rootPath_ = actPath;
+		displayPaths_.clear();
                 endResetModel();
 	}
 }
@@ -107,6 +113,73 @@ void LocationModel::verify(const QModelIndex& parentIndex) const
 }
 #endif
 
+/**
+ * Generates the text displayed for a field of an entry in a list.
+ * Unlike the model methods, this function does not depend on the state of a
+ * model object, and can be used by threads other than the GUI one.
+ * @param  locList   The list
+ * @param  i         The position of the entry
+ * @param  field     The field
+ * @param  rootPath  Root path, replaced by "$" in file paths
+ * @return The text
+ */
+QString LocationModel::fieldText(const CompactLocationList& locList, int i,
+                                 Location::Fields field,
+                                 const QString& rootPath)
+{
+	switch (field) {
+	case Location::File:
+		// Replace root prefix with "$".
+		if (!rootPath.isEmpty() && locList.file(i).startsWith(rootPath))
+			return QString("$/") + locList.file(i).mid(rootPath.length());
+
+		return locList.file(i);
+
+	case Location::Line:
+		return QString::number(locList.line(i));
+
+	case Location::Column:
+		return QString::number(locList.column(i));
+
+	case Location::TagName:
+		return locList.tagName(i);
+
+	case Location::TagType:
+		return Strings::tagName(locList.tagType(i));
+
+	case Location::Scope:
+		return locList.scope(i);
+
+	case Location::Text:
+		return locList.text(i);
+	}
+
+	return QString();
+}
+
+/**
+ * Returns the displayed form of a file path.
+ * The result is computed once per distinct path, and cached.
+ * @param  path  The file path
+ * @return The path, with the root path replaced by "$"
+ */
+const QString& LocationModel::displayPath(const QString& path) const
+{
+	QHash<QString, QString>::ConstIterator itr = displayPaths_.find(path);
+	if (itr != displayPaths_.end())
+		return *itr;
+
+	// Paths that do not change share their data with the original.
+	QString display = path;
+	if (!rootPath_.isEmpty() && path.startsWith(rootPath_))
+		display = QString("$/") + path.mid(rootPath_.length());
+
+	if (displayPaths_.size() >= MaxDisplayPaths)
+		displayPaths_.clear();
+
+	return *displayPaths_.insert(path, display);
+}
+
 /**
  * Extracts data from a location object, for the given column index.
  * @param  loc  The location object
@@ -135,10 +208,7 @@ QVariant LocationModel::locationData(const Location& loc, uint col,
 	case Location::File:
 		// File path.
 		// Replace root prefix with "$".
-		if (!rootPath_.isEmpty() && loc.file_.startsWith(rootPath_))
-			return QString("$/") + loc.file_.mid(rootPath_.length());
-
-		return loc.file_;
+		return displayPath(loc.file_);
 
 	case Location::Line:
 		// Line number.
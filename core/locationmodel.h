@@ -22,6 +22,7 @@
 #define __CORE_LOCATIONMODEL_H__
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include "globals.h"
 
 namespace KScope
@@ -56,6 +57,11 @@ public:
                 endResetModel();
 	}
 
+	/**
+	 * @return The path replaced by "$" in file names
+	 */
+	const QString& rootPath() const { return rootPath_; }
+
 	/**
 	 * @return The list of query fields presented by the model as columns
 	 */
@@ -68,7 +74,8 @@ public:
 	 * @param  list   The list of locations
 	 * @param  parent The index under which locations should be added
 	 */
-	virtual void add(const LocationList& list, const QModelIndex& parent) = 0;
+	virtual void add(const CompactLocationList& list,
+	                 const QModelIndex& parent) = 0;
 
 	/**
 	 * Possible return values for the isEmpty() method.
@@ -136,6 +143,9 @@ public:
 	virtual QVariant headerData(int, Qt::Orientation,
 	                            int role = Qt::DisplayRole) const;
 
+	static QString fieldText(const CompactLocationList&, int,
+	                         Location::Fields, const QString&);
+
 #ifndef QT_NO_DEBUG
 	void verify(const QModelIndex& parentIndex = QModelIndex()) const;
 #endif
@@ -153,6 +163,14 @@ protected:
 	 */
 	QString rootPath_;
 
+	/**
+	 * Caches the displayed form of file paths, which replaces the root path
+	 * with "$".
+	 * Valid as long as the root path does not change.
+	 */
+	mutable QHash<QString, QString> displayPaths_;
+
+	const QString& displayPath(const QString&) const;
 	QVariant locationData(const Location&, uint, int) const;
 	QString columnText(Location::Fields) const;
 };
@@ -0,0 +1,219 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <QHash>
+#include <QMetaType>
+#include "locationsorter.h"
+#include "locationmodel.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Orders row numbers by their keys.
+ */
+struct KeyLess
+{
+	KeyLess(const QVector<quint64>& keys) : keys_(keys) {}
+
+	bool operator()(int left, int right) const {
+		return keys_[left] < keys_[right];
+	}
+
+	const QVector<quint64>& keys_;
+};
+
+/**
+ * Orders value identifiers by the values they stand for.
+ */
+struct ValueLess
+{
+	ValueLess(const QVector<QString>& values) : values_(values) {}
+
+	bool operator()(quint32 left, quint32 right) const {
+		return values_[left] < values_[right];
+	}
+
+	const QVector<QString>& values_;
+};
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+LocationSorter::LocationSorter(QObject* parent)
+	: QThread(parent), id_(0), stop_(0)
+{
+	qRegisterMetaType< QVector<int> >("QVector<int>");
+}
+
+/**
+ * Class destructor.
+ */
+LocationSorter::~LocationSorter()
+{
+	stop();
+}
+
+/**
+ * Starts sorting a list of locations.
+ * A sort that is already running is stopped first.
+ * @param  locList   The list to sort
+ * @param  keys      The fields to sort by (one or two), primary key first
+ * @param  rootPath  Root path, replaced by "$" in file paths
+ * @return An identifier for the sort, used by the sorted() signal
+ */
+int LocationSorter::apply(const CompactLocationList& locList,
+                          const QList<Location::Fields>& keys,
+                          const QString& rootPath)
+{
+	stop();
+
+	locList_ = locList;
+	keys_ = keys;
+	rootPath_ = rootPath;
+
+	id_++;
+	stop_.store(0);
+	start();
+	return id_;
+}
+
+/**
+ * Aborts the current sort, if any, and waits for the thread to terminate.
+ */
+void LocationSorter::stop()
+{
+	stop_.store(1);
+	wait();
+}
+
+/**
+ * The thread's main function.
+ * Combines the keys of up to two fields into a single 64-bit key per row, and
+ * sorts the rows by these keys.
+ */
+void LocationSorter::run()
+{
+	int rows = locList_.size();
+	QVector<quint64> keys(rows);
+
+	for (int k = 0; k < keys_.size() && k < 2; k++) {
+		QVector<quint32> fieldKeys;
+		if (!this->fieldKeys(keys_[k], fieldKeys))
+			return;
+
+		for (int row = 0; row < rows; row++)
+			keys[row] = (keys[row] << 32) | fieldKeys[row];
+	}
+
+	if (stop_.load())
+		return;
+
+	// Sort row numbers by their keys.
+	QVector<int> order(rows);
+	for (int row = 0; row < rows; row++)
+		order[row] = row;
+
+	std::stable_sort(order.begin(), order.end(), KeyLess(keys));
+
+	if (stop_.load())
+		return;
+
+	QVector<int> ranks(rows);
+	for (int i = 0; i < rows; i++)
+		ranks[order[i]] = i;
+
+	emit sorted(id_, ranks);
+}
+
+/**
+ * Computes a numeric key per row for a single field.
+ * Strings are ranked once per distinct value, so that comparing the keys of
+ * two rows is equivalent to comparing their display strings.
+ * @param  field  The field
+ * @param  keys   Holds the key of each row, upon successful return
+ * @return true if successful, false if the sort was stopped
+ */
+bool LocationSorter::fieldKeys(Location::Fields field, QVector<quint32>& keys)
+{
+	int rows = locList_.size();
+	keys.resize(rows);
+
+	switch (field) {
+	case Location::Line:
+		for (int row = 0; row < rows; row++)
+			keys[row] = locList_.line(row);
+		return true;
+
+	case Location::Column:
+		for (int row = 0; row < rows; row++)
+			keys[row] = locList_.column(row);
+		return true;
+
+	default:
+		;
+	}
+
+	// Assign an identifier to each distinct value.
+	QHash<QString, quint32> valueIds;
+	QVector<QString> values;
+	for (int row = 0; row < rows; row++) {
+		if ((row & 0xfff) == 0 && stop_.load())
+			return false;
+
+		QString text = LocationModel::fieldText(locList_, row, field,
+		                                        rootPath_);
+		QHash<QString, quint32>::ConstIterator itr = valueIds.find(text);
+		if (itr == valueIds.end()) {
+			itr = valueIds.insert(text, values.size());
+			values.append(text);
+		}
+
+		keys[row] = *itr;
+	}
+
+	// Sort the distinct values, and map identifiers to ranks.
+	QVector<quint32> order(values.size());
+	for (int i = 0; i < values.size(); i++)
+		order[i] = i;
+
+	std::sort(order.begin(), order.end(), ValueLess(values));
+
+	if (stop_.load())
+		return false;
+
+	QVector<quint32> ranks(values.size());
+	for (int i = 0; i < order.size(); i++)
+		ranks[order[i]] = i;
+
+	for (int row = 0; row < rows; row++)
+		keys[row] = ranks[keys[row]];
+
+	return true;
+}
+
+} // namespace Core
+
+} // namespace KScope
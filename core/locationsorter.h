@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_LOCATIONSORTER_H__
+#define __CORE_LOCATIONSORTER_H__
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QVector>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * A thread that sorts a list of locations by one or two fields.
+ * Instead of comparing display strings for each pair of rows, the thread
+ * computes a numeric key per row: string fields are replaced by the rank of
+ * their value among the distinct values of the field, and numeric fields are
+ * used as is. The rows are then sorted by these keys, keeping the original
+ * order of rows with equal keys.
+ * The result is the rank of each row in the sorted order, published by the
+ * sorted() signal.
+ * @author Elad Lahav
+ */
+class LocationSorter : public QThread
+{
+	Q_OBJECT
+
+public:
+	LocationSorter(QObject* parent = NULL);
+	~LocationSorter();
+
+	int apply(const CompactLocationList&, const QList<Location::Fields>&,
+	          const QString&);
+	void stop();
+
+signals:
+	/**
+	 * Publishes the results of a sort.
+	 * @param  id     Identifies the sort, as returned by apply()
+	 * @param  ranks  The position of each row in the sorted order
+	 */
+	void sorted(int id, const QVector<int>& ranks);
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The list to sort.
+	 */
+	CompactLocationList locList_;
+
+	/**
+	 * The fields to sort by, primary key first.
+	 */
+	QList<Location::Fields> keys_;
+
+	/**
+	 * Root path, replaced by "$" in file paths.
+	 */
+	QString rootPath_;
+
+	/**
+	 * Identifies the current sort.
+	 */
+	int id_;
+
+	/**
+	 * Set to abort the sort.
+	 */
+	QAtomicInt stop_;
+
+	bool fieldKeys(Location::Fields, QVector<quint32>&);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_LOCATIONSORTER_H__
@@ -0,0 +1,179 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "locationstream.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ * @param  dev  The device to read from, or write to
+ */
+LocationStream::LocationStream(QIODevice* dev) : strm_(dev)
+{
+	strm_.setVersion(QDataStream::Qt_4_5);
+}
+
+/**
+ * Class destructor.
+ */
+LocationStream::~LocationStream()
+{
+}
+
+/**
+ * Writes an interned string.
+ * @param  str  The string to write
+ */
+void LocationStream::writeString(const QString& str)
+{
+	QHash<QString, quint32>::ConstIterator itr = ids_.find(str);
+	if (itr != ids_.end()) {
+		strm_ << *itr;
+		return;
+	}
+
+	// A new string: its identifier is the size of the table.
+	quint32 id = ids_.size();
+	ids_.insert(str, id);
+	strm_ << id << str;
+}
+
+/**
+ * Reads an interned string.
+ * @return The string, a null string in case of an error
+ */
+QString LocationStream::readString()
+{
+	quint32 id;
+	strm_ >> id;
+	if (strm_.status() != QDataStream::Ok)
+		return QString();
+
+	if (id < (quint32)strings_.size())
+		return strings_[id];
+
+	// A new string is expected to carry the next identifier.
+	if (id != (quint32)strings_.size()) {
+		strm_.setStatus(QDataStream::ReadCorruptData);
+		return QString();
+	}
+
+	QString str;
+	strm_ >> str;
+	strings_.append(str);
+	return str;
+}
+
+/**
+ * Writes the given fields of a location.
+ * @param  loc      The location
+ * @param  colList  The fields to write
+ */
+void LocationStream::writeLocation(const Location& loc,
+                                   const QList<Location::Fields>& colList)
+{
+	foreach (Location::Fields field, colList) {
+		switch (field) {
+		case Location::File:
+			writeString(loc.file_);
+			break;
+
+		case Location::Line:
+			strm_ << (quint32)loc.line_;
+			break;
+
+		case Location::Column:
+			strm_ << (quint32)loc.column_;
+			break;
+
+		case Location::TagName:
+			writeString(loc.tag_.name_);
+			break;
+
+		case Location::TagType:
+			strm_ << (quint8)loc.tag_.type_;
+			break;
+
+		case Location::Scope:
+			writeString(loc.tag_.scope_);
+			break;
+
+		case Location::Text:
+			strm_ << loc.text_;
+			break;
+		}
+	}
+}
+
+/**
+ * Reads the given fields of a location.
+ * @param  loc      The location to fill
+ * @param  colList  The fields to read, in the order they were written
+ */
+void LocationStream::readLocation(Location& loc,
+                                  const QList<Location::Fields>& colList)
+{
+	quint32 num;
+	quint8 type;
+
+	foreach (Location::Fields field, colList) {
+		switch (field) {
+		case Location::File:
+			loc.file_ = readString();
+			break;
+
+		case Location::Line:
+			strm_ >> num;
+			loc.line_ = num;
+			break;
+
+		case Location::Column:
+			strm_ >> num;
+			loc.column_ = num;
+			break;
+
+		case Location::TagName:
+			loc.tag_.name_ = readString();
+			break;
+
+		case Location::TagType:
+			strm_ >> type;
+			loc.tag_.type_ = static_cast<Tag::Type>(type);
+			break;
+
+		case Location::Scope:
+			loc.tag_.scope_ = readString();
+			break;
+
+		case Location::Text:
+			strm_ >> loc.text_;
+			break;
+		}
+	}
+}
+
+} // namespace Core
+
+} // namespace KScope
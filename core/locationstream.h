@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_LOCATIONSTREAM_H__
+#define __CORE_LOCATIONSTREAM_H__
+
+#include <QDataStream>
+#include <QHash>
+#include <QVector>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * A binary stream for storing locations.
+ * File paths, tag names and scopes are interned: the first occurrence of a
+ * string is written along with a new identifier, and later occurrences are
+ * written as the identifier alone. The reading side rebuilds the same table as
+ * it goes, so a stream has to be read in the order it was written.
+ * @author Elad Lahav
+ */
+class LocationStream
+{
+public:
+	LocationStream(QIODevice*);
+	~LocationStream();
+
+	/**
+	 * @return The underlying data stream, for values that are not interned
+	 */
+	QDataStream& stream() { return strm_; }
+
+	/**
+	 * @return true if no read or write errors occurred, false otherwise
+	 */
+	bool isValid() const { return strm_.status() == QDataStream::Ok; }
+
+	void writeString(const QString&);
+	QString readString();
+	void writeLocation(const Location&, const QList<Location::Fields>&);
+	void readLocation(Location&, const QList<Location::Fields>&);
+
+private:
+	/**
+	 * The underlying data stream.
+	 */
+	QDataStream strm_;
+
+	/**
+	 * Maps strings written so far to their identifiers.
+	 */
+	QHash<QString, quint32> ids_;
+
+	/**
+	 * Strings read so far, indexed by their identifiers.
+	 */
+	QVector<QString> strings_;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_LOCATIONSTREAM_H__
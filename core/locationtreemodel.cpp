@@ -31,7 +31,7 @@ namespace Core
  * @param  parent   Parent object
  */
 LocationTreeModel::LocationTreeModel(QObject* parent)
-	: LocationModel(parent), root_(Location())
+	: LocationModel(parent), tree_()
 {
 }
 
@@ -47,27 +47,20 @@ LocationTreeModel::~LocationTreeModel()
  * @param  locList  Result information
  * @param  parent   Index under which to add the results
  */
-void LocationTreeModel::add(const LocationList& locList,
+void LocationTreeModel::add(const CompactLocationList& locList,
                             const QModelIndex& parent)
 {
-	Node* node;
-
 	// Determine the node under which to add the results.
-	if (!parent.isValid()) {
-		node = &root_;
-	}
-	else {
-		node = static_cast<Node*>(parent.internalPointer());
-		if (node == NULL)
-			return;
-	}
+	int node = nodeFromIndex(parent);
+	if (node == -1)
+		return;
 
 	// Mark the item for use with isEmpty().
 	// TODO: Is there a way to force the view to repaint this item?
-	node->data().locationsAdded_ = true;
+	tree_.data(node).locationsAdded_ = true;
 
 	// Determine the first and last rows for the new items.
-	int firstRow = node->childCount();
+	int firstRow = tree_.childCount(node);
 	int lastRow = firstRow + locList.size() - 1;
 	if (lastRow < firstRow)
 		return;
@@ -77,8 +70,9 @@ void LocationTreeModel::add(const LocationList& locList,
 	beginInsertRows(parent, firstRow, lastRow);
 
 	// Add the entries.
-	foreach (Location loc, locList)
-		node->addChild(loc);
+	tree_.reserveChildren(node, locList.size());
+	for (int i = 0; i < locList.size(); i++)
+		tree_.addChild(node, locList.at(i));
 
 	// End row insertion.
 	// This is required by QAbstractItemModel.
@@ -93,24 +87,17 @@ void LocationTreeModel::add(const LocationList& locList,
 LocationModel::IsEmptyResult
 LocationTreeModel::isEmpty(const QModelIndex& index) const
 {
-	const Node* node;
-
 	// Get the node from the index.
-	if (!index.isValid()) {
-		node = &root_;
-	}
-	else {
-		node = static_cast<Node*>(index.internalPointer());
-		if (node == NULL)
-			return Unknown;
-	}
+	int node = nodeFromIndex(index);
+	if (node == -1)
+		return Unknown;
 
 	// Return Unknown if locations were never added under this item.
-	if (!node->data().locationsAdded_)
+	if (!tree_.data(node).locationsAdded_)
 		return Unknown;
 
 	// Return Empty or Full, based on the existence of children.
-	return node->childCount() == 0 ? Empty : Full;
+	return tree_.childCount(node) == 0 ? Empty : Full;
 }
 
 /**
@@ -121,24 +108,24 @@ void LocationTreeModel::clear(const QModelIndex& parent)
 {
 	// Handle the root node (removing all data from the model).
 	if (!parent.isValid()) {
-		if (root_.childCount() > 0) {
+		if (tree_.childCount(Tree<LocationTreeItem>::Root) > 0) {
                     beginResetModel();
-			root_.clear();
-			root_.data().locationsAdded_ = false;
+			tree_.clear(Tree<LocationTreeItem>::Root);
+			tree_.data(Tree<LocationTreeItem>::Root).locationsAdded_ = false;
                         endResetModel();
 		}
 		return;
 	}
 
 	// Get the node from the index.
-	Node* node = static_cast<Node*>(parent.internalPointer());
-	if (node == NULL || node->childCount() == 0)
+	int node = nodeFromIndex(parent);
+	if (node == -1 || tree_.childCount(node) == 0)
 		return;
 
 	// Delete all descendants.
-	beginRemoveRows(parent, 0, node->childCount() - 1);
-	node->clear();
-	node->data().locationsAdded_ = false;
+	beginRemoveRows(parent, 0, tree_.childCount(node) - 1);
+	tree_.clear(node);
+	tree_.data(node).locationsAdded_ = false;
 	endRemoveRows();
 }
 
@@ -156,11 +143,11 @@ bool LocationTreeModel::locationFromIndex(const QModelIndex& idx,
 	if (!idx.isValid())
 		return false;
 
-	Node* node = static_cast<Node*>(idx.internalPointer());
-	if (node == NULL)
+	int node = nodeFromIndex(idx);
+	if (node == -1)
 		return false;
 
-	loc = node->data().loc_;
+	loc = tree_.data(node).loc_;
 	return true;
 }
 
@@ -171,10 +158,11 @@ bool LocationTreeModel::locationFromIndex(const QModelIndex& idx,
  */
 bool LocationTreeModel::firstLocation(Location& loc) const
 {
-	if (root_.childCount() == 0)
+	int node = tree_.child(Tree<LocationTreeItem>::Root, 0);
+	if (node == -1)
 		return false;
 
-	loc = root_.child(0)->data().loc_;
+	loc = tree_.data(node).loc_;
 	return true;
 }
 
@@ -191,17 +179,17 @@ QModelIndex LocationTreeModel::nextIndex(const QModelIndex& idx) const
 		return index(0, 0, QModelIndex());
 
 	// Get the tree item for the index.
-	const Node* node = static_cast<Node*>(idx.internalPointer());
-	if (node == NULL)
+	int node = nodeFromIndex(idx);
+	if (node == -1)
 		return QModelIndex();
 
 	// Go up the tree, looking for the first immediate sibling.
-	const Node* parent;
-	while ((parent = node->parent()) != NULL) {
+	int parent;
+	while ((parent = tree_.parent(node)) != -1) {
 		// Get the node's sibling.
-		node = parent->child(node->index() + 1);
-		if (node != NULL)
-			return createIndex(node->index(), 0, (void*)node);
+		int sibling = tree_.child(parent, tree_.row(node) + 1);
+		if (sibling != -1)
+			return createIndex(tree_.row(sibling), 0, (quintptr)sibling);
 
 		node = parent;
 	}
@@ -223,17 +211,17 @@ QModelIndex LocationTreeModel::prevIndex(const QModelIndex& idx) const
 		return index(0, 0, QModelIndex());
 
 	// Get the tree item for the index.
-	const Node* node = static_cast<Node*>(idx.internalPointer());
-	if (node == NULL)
+	int node = nodeFromIndex(idx);
+	if (node == -1)
 		return QModelIndex();
 
 	// Go up the tree, looking for the first immediate sibling.
-	const Node* parent;
-	while ((parent = node->parent()) != NULL) {
+	int parent;
+	while ((parent = tree_.parent(node)) != -1) {
 		// Get the node's sibling.
-		node = parent->child(node->index() - 1);
-		if (node != NULL)
-			return createIndex(node->index(), 0, (void*)node);
+		int sibling = tree_.child(parent, tree_.row(node) - 1);
+		if (sibling != -1)
+			return createIndex(tree_.row(sibling), 0, (quintptr)sibling);
 
 		node = parent;
 	}
@@ -251,24 +239,17 @@ QModelIndex LocationTreeModel::prevIndex(const QModelIndex& idx) const
 QModelIndex LocationTreeModel::index(int row, int column,
 									 const QModelIndex& parent) const
 {
-	// Extract the node object from the index.
-	const Node* node;
-	if (!parent.isValid()) {
-		node = &root_;
-	}
-	else {
-		// Get the tree item for the parent.
-		node = static_cast<Node*>(parent.internalPointer());
-		if (node == NULL)
-			return QModelIndex();
-	}
+	// Extract the node from the index.
+	int node = nodeFromIndex(parent);
+	if (node == -1)
+		return QModelIndex();
 
 	// Get the child at the row'th position.
-	node = node->child(row);
-	if (node == NULL)
+	node = tree_.child(node, row);
+	if (node == -1)
 		return QModelIndex();
 
-	return createIndex(row, column, (void*)node);
+	return createIndex(row, column, (quintptr)node);
 }
 
 /**
@@ -282,16 +263,16 @@ QModelIndex LocationTreeModel::parent(const QModelIndex& idx) const
 		return QModelIndex();
 
 	// Get the tree item for the index.
-	const Node* node = static_cast<Node*>(idx.internalPointer());
-	if (node == NULL)
+	int node = nodeFromIndex(idx);
+	if (node == -1)
 		return QModelIndex();
 
 	// Get the parent node.
-	node = node->parent();
-	if ((node == NULL) || (node == &root_))
+	node = tree_.parent(node);
+	if ((node == -1) || (node == Tree<LocationTreeItem>::Root))
 		return QModelIndex();
 
-	return createIndex(node->index(), 0, (void*)node);
+	return createIndex(tree_.row(node), 0, (quintptr)node);
 }
 
 /**
@@ -301,19 +282,11 @@ QModelIndex LocationTreeModel::parent(const QModelIndex& idx) const
  */
 int LocationTreeModel::rowCount(const QModelIndex& parent) const
 {
-	const Node* node;
-	if (!parent.isValid()) {
-		// An invalid index represents the root item.
-		node = &root_;
-	}
-	else {
-		// Get the tree item for the index.
-		node = static_cast<Node*>(parent.internalPointer());
-		if (node == NULL)
-			return 0;
-	}
+	int node = nodeFromIndex(parent);
+	if (node == -1)
+		return 0;
 
-	return node->childCount();
+	return tree_.childCount(node);
 }
 
 /**
@@ -329,19 +302,11 @@ int LocationTreeModel::rowCount(const QModelIndex& parent) const
  */
 bool LocationTreeModel::hasChildren(const QModelIndex& parent) const
 {
-	const Node* node;
-	if (!parent.isValid()) {
-		// An invalid index represents the root item.
-		node = &root_;
-	}
-	else {
-		// Get the tree item for the index.
-		node = static_cast<Node*>(parent.internalPointer());
-		if (node == NULL)
-			return 0;
-	}
+	int node = nodeFromIndex(parent);
+	if (node == -1)
+		return false;
 
-	return node->childCount() > 0;
+	return tree_.childCount(node) > 0;
 }
 
 /**
@@ -361,12 +326,30 @@ QVariant LocationTreeModel::data(const QModelIndex& idx, int role) const
 	}
 
 	// Get the location for the index's row.
-	Node* node = static_cast<Node*>(idx.internalPointer());
-	if (node == NULL)
+	int node = nodeFromIndex(idx);
+	if (node == -1)
 		return false;
 
 	// Get the column-specific data.
-	return locationData(node->data().loc_, idx.column(), role);
+	return locationData(tree_.data(node).loc_, idx.column(), role);
+}
+
+/**
+ * Translates a model index into the position of a node in the tree.
+ * @param  idx  The index to translate
+ * @return The position of the node, the root's position for an invalid index,
+ *         -1 if the index does not refer to a node
+ */
+int LocationTreeModel::nodeFromIndex(const QModelIndex& idx) const
+{
+	if (!idx.isValid())
+		return Tree<LocationTreeItem>::Root;
+
+	int node = (int)idx.internalId();
+	if (node <= Tree<LocationTreeItem>::Root)
+		return -1;
+
+	return node;
 }
 
 } // namespace Core
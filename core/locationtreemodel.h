@@ -22,7 +22,7 @@
 #define __CORE_LOCATIONTREEMODEL_H__
 
 #include "locationmodel.h"
-#include "treeitem.h"
+#include "tree.h"
 
 namespace KScope
 {
@@ -45,7 +45,7 @@ public:
 	~LocationTreeModel();
 
 	// LocationModel implementation.
-	void add(const LocationList&, const QModelIndex&);
+	void add(const CompactLocationList&, const QModelIndex&);
 	IsEmptyResult isEmpty(const QModelIndex&) const;
 	void clear(const QModelIndex&);
 	bool locationFromIndex(const QModelIndex&, Location&) const;
@@ -83,16 +83,18 @@ private:
 		 * Struct constructor.
 		 * @param  loc The location to store
 		 */
-		LocationTreeItem(const Location& loc)
+		LocationTreeItem(const Location& loc = Location())
 			: loc_(loc), locationsAdded_(false) {}
 	};
 
-	typedef TreeItem<LocationTreeItem> Node;
-
 	/**
-	 * The root item of the tree.
+	 * The tree of locations.
+	 * Model indices hold the positions of nodes in the tree as their internal
+	 * IDs.
 	 */
-	Node root_;
+	Tree<LocationTreeItem> tree_;
+
+	int nodeFromIndex(const QModelIndex&) const;
 };
 
 } // namespace Core
@@ -19,10 +19,14 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QHeaderView>
 #include "locationview.h"
 #include "locationlistmodel.h"
 #include "locationtreemodel.h"
 #include "textfilterdialog.h"
+#include "locationfilter.h"
+#include "locationsorter.h"
+#include "locationstream.h"
 
 namespace KScope
 {
@@ -30,6 +34,378 @@ namespace KScope
 namespace Core
 {
 
+/**
+ * The number of rows above which a list is filtered or sorted in the
+ * background.
+ */
+static const int MinThreadedRows = 10000;
+
+/**
+ * The number of rows above which column widths are computed from samples,
+ * rather than by measuring all rows.
+ */
+static const int MaxMeasuredRows = 1000;
+
+/**
+ * The time, in milliseconds, to wait for more rows before ranking rows added
+ * to a sorted list.
+ */
+static const int RankDelay = 500;
+
+/**
+ * The maximal number of rows sampled in each batch added to the model.
+ */
+static const int MaxSampledRows = 256;
+
+/**
+ * Class constructor.
+ * @param  parent Parent object
+ */
+LocationViewProxyModel::LocationViewProxyModel(QObject* parent)
+	: QSortFilterProxyModel(parent), column_(0), threaded_(false),
+	  filterId_(0), matchedRows_(0), filterRows_(0), sortId_(0),
+	  sortColumn_(-1), sortOrder_(Qt::AscendingOrder)
+{
+	filter_ = new LocationFilter(this);
+	connect(filter_, SIGNAL(matched(int, const QBitArray&, int)), this,
+	        SLOT(filterMatched(int, const QBitArray&, int)));
+
+	sorter_ = new LocationSorter(this);
+	connect(sorter_, SIGNAL(sorted(int, const QVector<int>&)), this,
+	        SLOT(sorterDone(int, const QVector<int>&)));
+
+	rankTimer_.setSingleShot(true);
+	rankTimer_.setInterval(RankDelay);
+	connect(&rankTimer_, SIGNAL(timeout()), this, SLOT(rankRows()));
+}
+
+/**
+ * Class destructor.
+ */
+LocationViewProxyModel::~LocationViewProxyModel()
+{
+	filter_->stop();
+	sorter_->stop();
+}
+
+/**
+ * Sets the location model for the proxy.
+ * @param  model  The source model
+ */
+void LocationViewProxyModel::setSourceModel(QAbstractItemModel* model)
+{
+	if (sourceModel() != NULL) {
+		disconnect(sourceModel(), NULL, this, SLOT(sourceAboutToBeReset()));
+		disconnect(sourceModel(), NULL, this, SLOT(sourceRowsInserted()));
+	}
+
+	sourceAboutToBeReset();
+	QSortFilterProxyModel::setSourceModel(model);
+
+	if (model != NULL) {
+		connect(model, SIGNAL(modelAboutToBeReset()), this,
+		        SLOT(sourceAboutToBeReset()));
+		connect(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+		        this, SLOT(sourceRowsInserted()));
+	}
+}
+
+/**
+ * Applies a text filter to a column.
+ * List models with many rows are filtered in the background. Otherwise, the
+ * filter is handled by QSortFilterProxyModel.
+ * @param  regExp  The filter, empty to show all rows
+ * @param  column  The column to match
+ */
+void LocationViewProxyModel::setLocationFilter(const QRegExp& regExp,
+                                               int column)
+{
+	regExp_ = regExp;
+	column_ = column;
+
+	// Ignore results of a previous filter.
+	filterId_ = 0;
+	matches_.clear();
+	matchedRows_ = 0;
+	filterRows_ = 0;
+
+	LocationListModel* listModel
+		= qobject_cast<LocationListModel*>(sourceModel());
+	if (regExp.isEmpty() || (listModel == NULL)
+	    || (listModel->rowCount() < MinThreadedRows)
+	    || (column < 0) || (column >= listModel->columns().size())) {
+		if (threaded_) {
+			filter_->stop();
+			threaded_ = false;
+		}
+
+		setFilterKeyColumn(column);
+		setFilterRegExp(regExp);
+		return;
+	}
+
+	// Start the filter thread.
+	threaded_ = true;
+	filterRows_ = listModel->rowCount();
+	filterId_ = filter_->apply(listModel->locations(),
+	                           listModel->columns().at(column),
+	                           listModel->rootPath(), regExp);
+
+	// Hide all rows until the first results are published.
+	if (!filterRegExp().isEmpty())
+		setFilterRegExp(QRegExp());
+	else
+		invalidateFilter();
+}
+
+/**
+ * Sorts the rows by a column.
+ * List models with many rows are sorted in the background, while the current
+ * order is kept. Otherwise, rows are sorted by QSortFilterProxyModel.
+ * @param  column  The column to sort by, -1 to restore the model's order
+ * @param  order   Sort order
+ */
+void LocationViewProxyModel::sort(int column, Qt::SortOrder order)
+{
+	LocationListModel* listModel
+		= qobject_cast<LocationListModel*>(sourceModel());
+	if ((column < 0) || (listModel == NULL)
+	    || (listModel->rowCount() < MinThreadedRows)
+	    || (column >= listModel->columns().size())) {
+		sorter_->stop();
+		rankTimer_.stop();
+		sortId_ = 0;
+		sortKeys_.clear();
+		ranks_.clear();
+		rankKeys_.clear();
+		QSortFilterProxyModel::sort(column, order);
+		return;
+	}
+
+	startSort(column, order,
+	          QList<Location::Fields>() << listModel->columns().at(column));
+}
+
+/**
+ * Sorts the rows by file path, and then by line number.
+ * The sort is indicated on the file column, if the model has one.
+ * Only supported for list models.
+ * @param  order  Sort order
+ */
+void LocationViewProxyModel::sortByLocation(Qt::SortOrder order)
+{
+	LocationListModel* listModel
+		= qobject_cast<LocationListModel*>(sourceModel());
+	if (listModel == NULL)
+		return;
+
+	int column = listModel->columns().indexOf(Location::File);
+	if (column < 0)
+		column = 0;
+
+	startSort(column, order,
+	          QList<Location::Fields>() << Location::File << Location::Line);
+}
+
+/**
+ * Starts the sort thread on the rows of a list model.
+ * If the rows were already ranked by the same keys, the order is applied
+ * immediately. Otherwise, the current ranks keep determining the order until
+ * the thread is done.
+ * @param  column  The column on which the sort is indicated
+ * @param  order   Sort order
+ * @param  keys    The fields to sort by, primary key first
+ */
+void LocationViewProxyModel::startSort(int column, Qt::SortOrder order,
+                                       const QList<Location::Fields>& keys)
+{
+	LocationListModel* listModel
+		= static_cast<LocationListModel*>(sourceModel());
+
+	sortColumn_ = column;
+	sortOrder_ = order;
+
+	if ((keys == rankKeys_) && (ranks_.size() == listModel->rowCount())) {
+		sorter_->stop();
+		rankTimer_.stop();
+		sortId_ = 0;
+		sortKeys_ = keys;
+		QSortFilterProxyModel::sort(column, order);
+		return;
+	}
+
+	rankTimer_.stop();
+	sortKeys_ = keys;
+	sortId_ = sorter_->apply(listModel->locations(), keys,
+	                         listModel->rootPath());
+}
+
+/**
+ * Determines whether a row is displayed.
+ * @param  row     The row in the source model
+ * @param  parent  The parent index in the source model
+ * @return true to display the row, false otherwise
+ */
+bool LocationViewProxyModel::filterAcceptsRow(int row,
+                                              const QModelIndex& parent) const
+{
+	if (!threaded_)
+		return QSortFilterProxyModel::filterAcceptsRow(row, parent);
+
+	// Rows examined by the filter thread.
+	if (row < matchedRows_)
+		return matches_.testBit(row);
+
+	// Rows waiting for the filter thread.
+	if (row < filterRows_)
+		return false;
+
+	// Rows added after the filter thread was started.
+	QModelIndex index = sourceModel()->index(row, column_, parent);
+	return regExp_.indexIn(index.data().toString()) >= 0;
+}
+
+/**
+ * Compares two rows.
+ * Once the sort thread has ranked the rows, rows are compared by rank. Rows
+ * added since are compared by the same fields as the ranks, so that all
+ * comparisons agree on a single order.
+ * @param  left   A source index
+ * @param  right  A source index
+ * @return true if the left row comes before the right one, false otherwise
+ */
+bool LocationViewProxyModel::lessThan(const QModelIndex& left,
+                                      const QModelIndex& right) const
+{
+	if (rankKeys_.isEmpty() || left.parent().isValid())
+		return QSortFilterProxyModel::lessThan(left, right);
+
+	if ((left.row() < ranks_.size()) && (right.row() < ranks_.size()))
+		return ranks_[left.row()] < ranks_[right.row()];
+
+	return keyLessThan(left.row(), right.row());
+}
+
+/**
+ * Compares two rows by the fields of the current ranks.
+ * The comparison matches the one made by the sort thread: string fields are
+ * compared by their display text, numeric fields by value, and rows with
+ * equal fields by their position in the model.
+ * @param  left   A row in the source model
+ * @param  right  A row in the source model
+ * @return true if the left row comes before the right one, false otherwise
+ */
+bool LocationViewProxyModel::keyLessThan(int left, int right) const
+{
+	const LocationListModel* listModel
+		= static_cast<const LocationListModel*>(sourceModel());
+	const CompactLocationList& locList = listModel->locations();
+
+	for (int k = 0; k < rankKeys_.size() && k < 2; k++) {
+		Location::Fields field = rankKeys_[k];
+		if (field == Location::Line) {
+			if (locList.line(left) != locList.line(right))
+				return locList.line(left) < locList.line(right);
+		}
+		else if (field == Location::Column) {
+			if (locList.column(left) != locList.column(right))
+				return locList.column(left) < locList.column(right);
+		}
+		else {
+			const QString& rootPath = listModel->rootPath();
+			QString leftText = LocationModel::fieldText(locList, left, field,
+			                                            rootPath);
+			QString rightText = LocationModel::fieldText(locList, right, field,
+			                                             rootPath);
+			if (leftText != rightText)
+				return leftText < rightText;
+		}
+	}
+
+	return left < right;
+}
+
+/**
+ * Called when the sort thread is done.
+ * Applies the new order in a single layout change.
+ * @param  id     Identifies the sort
+ * @param  ranks  The position of each row in the sorted order
+ */
+void LocationViewProxyModel::sorterDone(int id, const QVector<int>& ranks)
+{
+	if (id != sortId_)
+		return;
+
+	sortId_ = 0;
+	ranks_ = ranks;
+	rankKeys_ = sortKeys_;
+	QSortFilterProxyModel::sort(sortColumn_, sortOrder_);
+}
+
+/**
+ * Called when the filter thread publishes results.
+ * @param  id       Identifies the filter
+ * @param  matches  A bit per row, set for matching rows
+ * @param  rows     The number of rows examined so far
+ */
+void LocationViewProxyModel::filterMatched(int id, const QBitArray& matches,
+                                           int rows)
+{
+	if (id != filterId_)
+		return;
+
+	matches_ = matches;
+	matchedRows_ = rows;
+	invalidateFilter();
+}
+
+/**
+ * Called before the contents of the source model are replaced.
+ * The filter thread's results, as well as its index, are no longer valid.
+ * Rows added to the model are matched directly.
+ */
+void LocationViewProxyModel::sourceAboutToBeReset()
+{
+	filter_->reset();
+	filterId_ = 0;
+	matches_.clear();
+	matchedRows_ = 0;
+	filterRows_ = 0;
+
+	sorter_->stop();
+	rankTimer_.stop();
+	sortId_ = 0;
+	sortKeys_.clear();
+	ranks_.clear();
+	rankKeys_.clear();
+}
+
+/**
+ * Called when rows are added to the source model.
+ * Until they are ranked, new rows are placed by comparing their fields (see
+ * lessThan()). As rows usually arrive in batches, the sort thread is only
+ * restarted to rank them once no more rows arrive for a while.
+ */
+void LocationViewProxyModel::sourceRowsInserted()
+{
+	if (!sortKeys_.isEmpty())
+		rankTimer_.start();
+}
+
+/**
+ * Restarts the sort thread, to rank rows added since the last sort.
+ */
+void LocationViewProxyModel::rankRows()
+{
+	if (sortKeys_.isEmpty())
+		return;
+
+	LocationListModel* listModel
+		= static_cast<LocationListModel*>(sourceModel());
+	sortId_ = sorter_->apply(listModel->locations(), sortKeys_,
+	                         listModel->rootPath());
+}
+
 /**
  * Class constructor.
  * @param  parent  The parent widget
@@ -58,6 +434,16 @@ LocationView::LocationView(QWidget* parent, Type type)
 		break;
 	}
 
+	// Track the widest rows as locations are added.
+	connect(locationModel(),
+	        SIGNAL(rowsInserted(const QModelIndex&, int, int)), this,
+	        SLOT(sampleRows(const QModelIndex&, int, int)));
+	connect(locationModel(),
+	        SIGNAL(rowsRemoved(const QModelIndex&, int, int)), this,
+	        SLOT(samplesRemoved()));
+	connect(locationModel(), SIGNAL(modelReset()), this,
+	        SLOT(resetSamples()));
+
 	// Emit requests for locations when an item is double-clicked.
 	connect(this, SIGNAL(activated(const QModelIndex&)), this,
 	        SLOT(requestLocation(const QModelIndex&)));
@@ -66,6 +452,15 @@ LocationView::LocationView(QWidget* parent, Type type)
 	menu_ = new QMenu(this);
 	menu_->addAction(tr("&Filter..."), this, SLOT(promptFilter()));
 	menu_->addAction(tr("C&lear filter"), this, SLOT(clearFilter()));
+
+	// Lists can be sorted by clicking a column header, or by file and line
+	// from the context menu.
+	if (type_ == List) {
+		header()->setSortIndicator(-1, Qt::AscendingOrder);
+		setSortingEnabled(true);
+		menu_->addAction(tr("&Sort by location"), this,
+		                 SLOT(sortByLocation()));
+	}
 }
 
 /**
@@ -77,11 +472,44 @@ LocationView::~LocationView()
 
 /**
  * Adjusts all columns to fit the their contents.
+ * Measuring every row is too expensive for large models. In that case, the
+ * width of each column is determined by the widest row sampled so far and
+ * the currently visible rows.
  */
 void LocationView::resizeColumns()
 {
-	for (int i = 0; i < locationModel()->columnCount(); i++)
-		resizeColumnToContents(i);
+	int columns = locationModel()->columnCount();
+	if (locationModel()->rowCount() <= MaxMeasuredRows) {
+		for (int i = 0; i < columns; i++)
+			resizeColumnToContents(i);
+
+		return;
+	}
+
+	QVector<int> widths(columns);
+	for (int i = 0; i < columns; i++)
+		widths[i] = header()->isHidden() ? 0 : header()->sectionSizeHint(i);
+
+	// Measure the widest sampled rows.
+	for (int i = 0; i < columns && i < widest_.size(); i++) {
+		QModelIndex index = proxy()->mapFromSource(widest_[i]);
+		if (index.isValid())
+			widths[i] = qMax(widths[i], cellWidth(index));
+	}
+
+	// Measure the visible rows.
+	int bottom = viewport()->height();
+	for (QModelIndex index = indexAt(QPoint(0, 0));
+	     index.isValid() && (visualRect(index).top() < bottom);
+	     index = indexBelow(index)) {
+		for (int i = 0; i < columns; i++) {
+			QModelIndex cell = index.sibling(index.row(), i);
+			widths[i] = qMax(widths[i], cellWidth(cell));
+		}
+	}
+
+	for (int i = 0; i < columns; i++)
+		setColumnWidth(i, widths[i]);
 }
 
 /**
@@ -149,6 +577,45 @@ void LocationView::fromXML(const QDomElement& viewElem)
 #endif
 }
 
+/**
+ * Writes a binary representation of the view's model to a stream.
+ * This is a more compact and faster alternative to toXML(). Unlike toXML(),
+ * the view's title and type are not stored, as these are required for
+ * creating the view in the first place.
+ * @param  strm  The stream to write to
+ */
+void LocationView::toStream(LocationStream& strm) const
+{
+	const QList<Location::Fields>& colList = locationModel()->columns();
+	strm.stream() << (quint32)colList.size();
+	foreach (Location::Fields field, colList)
+		strm.stream() << (quint32)field;
+
+	locationToStream(strm, QModelIndex());
+}
+
+/**
+ * Loads the view from a binary representation created by toStream().
+ * @param  strm  The stream to read from
+ */
+void LocationView::fromStream(LocationStream& strm)
+{
+	// Reset the model.
+	locationModel()->clear(QModelIndex());
+
+	quint32 count;
+	strm.stream() >> count;
+	QList<Location::Fields> colList;
+	for (quint32 i = 0; i < count && strm.isValid(); i++) {
+		quint32 field;
+		strm.stream() >> field;
+		colList.append(static_cast<Location::Fields>(field));
+	}
+	locationModel()->setColumns(colList);
+
+	locationFromStream(strm, QModelIndex());
+}
+
 /**
  * Selects the next available index in the proxy.
  */
@@ -181,6 +648,89 @@ void LocationView::selectPrev()
 		emit locationRequested(loc);
 }
 
+/**
+ * Computes the width required for displaying an item.
+ * @param  index  The item (proxy index)
+ * @return The width, in pixels
+ */
+int LocationView::cellWidth(const QModelIndex& index) const
+{
+	QStyleOptionViewItem option = viewOptions();
+	int width = itemDelegate(index)->sizeHint(option, index).width();
+
+	// Account for the indentation of the first column.
+	if (index.column() == 0) {
+		int depth = rootIsDecorated() ? 1 : 0;
+		for (QModelIndex parent = index.parent(); parent.isValid();
+		     parent = parent.parent()) {
+			depth++;
+		}
+
+		width += depth * indentation();
+	}
+
+	return width;
+}
+
+/**
+ * Records the widest rows in a batch of rows added to the model.
+ * Rows are compared by the length of their text. At most MaxSampledRows rows
+ * are examined per batch, evenly spaced.
+ * @param  parent  The parent of the new rows (source index)
+ * @param  first   The first new row
+ * @param  last    The last new row
+ */
+void LocationView::sampleRows(const QModelIndex& parent, int first, int last)
+{
+	LocationModel* model = locationModel();
+	int columns = model->columnCount();
+	if (widest_.size() != columns) {
+		widest_.fill(QPersistentModelIndex(), columns);
+		widestLength_.fill(-1, columns);
+	}
+
+	int step = qMax(1, (last - first + 1) / MaxSampledRows);
+	for (int row = first; row <= last; row += step) {
+		for (int i = 0; i < columns; i++) {
+			QModelIndex index = model->index(row, i, parent);
+			int length = model->data(index).toString().length();
+			if (length > widestLength_[i]) {
+				widest_[i] = index;
+				widestLength_[i] = length;
+			}
+		}
+	}
+}
+
+/**
+ * Called when rows are removed from the model.
+ * Columns whose widest row was removed are sampled again from the remaining
+ * rows.
+ */
+void LocationView::samplesRemoved()
+{
+	bool lost = false;
+	for (int i = 0; i < widest_.size(); i++) {
+		if (!widest_[i].isValid()) {
+			widestLength_[i] = -1;
+			lost = true;
+		}
+	}
+
+	LocationModel* model = locationModel();
+	if (lost && model->rowCount() > 0)
+		sampleRows(QModelIndex(), 0, model->rowCount() - 1);
+}
+
+/**
+ * Discards the widest rows when the model is reset.
+ */
+void LocationView::resetSamples()
+{
+	widest_.clear();
+	widestLength_.clear();
+}
+
 /**
  * Displays the context menu in response to the matching event.
  * @param  event Event parameters
@@ -310,7 +860,7 @@ void LocationView::locationFromXML(const QDomElement& locListElem,
 	// element. These will be loaded later. It's better to first construct the
 	// list of locations for the current level, rather than follow the XML
 	// tree depth-first, due to the behaviour of the add() method.
-	LocationList locList;
+	CompactLocationList locList;
 	QList< QPair<int, QDomElement> > childLists;
 	for (int i = 0; i < nodes.size(); i++) {
 		// Get the current location element.
@@ -367,6 +917,84 @@ void LocationView::locationFromXML(const QDomElement& locListElem,
 		expand(proxy()->mapFromSource(parentIndex));
 }
 
+/**
+ * Recursively writes the location hierarchy stored in the model to a binary
+ * stream.
+ * For each index, the stream holds a flag telling whether the index was
+ * queried, followed (for queried indices) by its expansion state, the number
+ * of children, the children themselves, and then the sub-hierarchy of each
+ * child in order.
+ * @param  strm   The stream to write to
+ * @param  index  The source index whose children are stored
+ */
+void LocationView::locationToStream(LocationStream& strm,
+                                    const QModelIndex& index) const
+{
+	// Non-queried indices are marked so that locationFromStream() does not
+	// call add() for them.
+	if (locationModel()->isEmpty(index) == LocationModel::Unknown) {
+		strm.stream() << (quint8)0;
+		return;
+	}
+
+	QModelIndex proxyIndex = proxy()->mapFromSource(index);
+	int rows = locationModel()->rowCount(index);
+	strm.stream() << (quint8)1 << (quint8)(isExpanded(proxyIndex) ? 1 : 0)
+	              << (quint32)rows;
+
+	const QList<Location::Fields>& colList = locationModel()->columns();
+	for (int i = 0; i < rows; i++) {
+		Location loc;
+		locationModel()->locationFromIndex(locationModel()->index(i, 0, index),
+		                                   loc);
+		strm.writeLocation(loc, colList);
+	}
+
+	for (int i = 0; i < rows; i++)
+		locationToStream(strm, locationModel()->index(i, 0, index));
+}
+
+/**
+ * Loads a hierarchy of locations from a binary stream into the model.
+ * See locationToStream() for the format.
+ * @param  strm         The stream to read from
+ * @param  parentIndex  The source model index under which locations should be
+ *                      added
+ */
+void LocationView::locationFromStream(LocationStream& strm,
+                                      const QModelIndex& parentIndex)
+{
+	quint8 queried, expanded;
+	strm.stream() >> queried;
+	if (!strm.isValid() || !queried)
+		return;
+
+	quint32 rows;
+	strm.stream() >> expanded >> rows;
+
+	// Construct the list of locations for the current level, as the
+	// sub-hierarchies can only be loaded after add() is called.
+	const QList<Location::Fields>& colList = locationModel()->columns();
+	CompactLocationList locList;
+	for (quint32 i = 0; i < rows && strm.isValid(); i++) {
+		Location loc;
+		strm.readLocation(loc, colList);
+		locList.append(loc);
+	}
+
+	if (!strm.isValid())
+		return;
+
+	locationModel()->add(locList, parentIndex);
+
+	for (quint32 i = 0; i < rows && strm.isValid(); i++)
+		locationFromStream(strm, locationModel()->index(i, 0, parentIndex));
+
+	// Expand the item if required.
+	if (expanded)
+		expand(proxy()->mapFromSource(parentIndex));
+}
+
 /**
  * Called when the user double-clicks a location item in the list.
  * Emits the locationRequested() signal for this location.
@@ -386,7 +1014,7 @@ void LocationView::requestLocation(const QModelIndex& index)
 void LocationView::promptFilter()
 {
 	// Create the dialogue.
-	TextFilterDialog dlg(proxy()->filterRegExp());
+	TextFilterDialog dlg(proxy()->locationFilter());
 
 	// Populate the "Filter By" list.
 	KeyValuePairs pairs;
@@ -404,18 +1032,31 @@ void LocationView::promptFilter()
 		return;
 
 	// Apply the filter.
-	proxy()->setFilterKeyColumn(dlg.filterByValue().toInt());
 	QRegExp filter = dlg.filter();
-	proxy()->setFilterRegExp(filter);
+	proxy()->setLocationFilter(filter, dlg.filterByValue().toInt());
 	emit isFiltered(filter.isEmpty());
 }
 
+/**
+ * Sorts a list by file path, and then by line number.
+ */
+void LocationView::sortByLocation()
+{
+	// Update the header without triggering a sort by the file column alone.
+	int column = locationModel()->columns().indexOf(Location::File);
+	header()->blockSignals(true);
+	header()->setSortIndicator(column < 0 ? 0 : column, Qt::AscendingOrder);
+	header()->blockSignals(false);
+
+	proxy()->sortByLocation(Qt::AscendingOrder);
+}
+
 /**
  * Removes any filters from the proxy.
  */
 void LocationView::clearFilter()
 {
-	proxy()->setFilterRegExp(QRegExp());
+	proxy()->setLocationFilter(QRegExp(), 0);
 	emit isFiltered(false);
 }
 
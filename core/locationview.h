@@ -24,6 +24,10 @@
 #include <QTreeView>
 #include <QMenu>
 #include <QSortFilterProxyModel>
+#include <QBitArray>
+#include <QRegExp>
+#include <QTimer>
+#include <QVector>
 #include <QDomDocument>
 #include <QDomElement>
 #include <QContextMenuEvent>
@@ -36,8 +40,20 @@ namespace KScope
 namespace Core
 {
 
+class LocationFilter;
+class LocationSorter;
+class LocationStream;
+
 /**
  * A proxy model used by LocationView.
+ * Large lists are filtered by a LocationFilter thread, rather than by the
+ * standard QSortFilterProxyModel mechanism, so that the GUI remains
+ * responsive. While the thread is running, rows it has not examined yet are
+ * hidden.
+ * Similarly, large lists are sorted by a LocationSorter thread. The view keeps
+ * its current order until the thread provides the rank of each row, after
+ * which rows are compared by rank. Rows added later are compared by the sort
+ * fields, in the same order as the ranks, until they are ranked as well.
  * @author Elad Lahav
  */
 class LocationViewProxyModel : public QSortFilterProxyModel
@@ -45,16 +61,18 @@ class LocationViewProxyModel : public QSortFilterProxyModel
 	Q_OBJECT
 
 public:
-	/**
-	 * Class constructor.
-	 * @param  parent Parent object
-	 */
-	LocationViewProxyModel(QObject* parent) : QSortFilterProxyModel(parent) {}
+	LocationViewProxyModel(QObject* parent);
+	~LocationViewProxyModel();
+
+	virtual void setSourceModel(QAbstractItemModel*);
+	void setLocationFilter(const QRegExp&, int);
+	virtual void sort(int, Qt::SortOrder order = Qt::AscendingOrder);
+	void sortByLocation(Qt::SortOrder order = Qt::AscendingOrder);
 
 	/**
-	 * Class destructor.
+	 * @return The current filter
 	 */
-	~LocationViewProxyModel() {}
+	const QRegExp& locationFilter() const { return regExp_; }
 
 	/**
 	 * Determines if the given index has children.
@@ -71,6 +89,102 @@ public:
 
 		return QSortFilterProxyModel::hasChildren(parent);
 	}
+
+protected:
+	virtual bool filterAcceptsRow(int, const QModelIndex&) const;
+	virtual bool lessThan(const QModelIndex&, const QModelIndex&) const;
+
+private:
+	/**
+	 * Filters large lists in the background.
+	 */
+	LocationFilter* filter_;
+
+	/**
+	 * The current filter.
+	 */
+	QRegExp regExp_;
+
+	/**
+	 * The filtered column.
+	 */
+	int column_;
+
+	/**
+	 * Whether the current filter is applied by the filter thread.
+	 */
+	bool threaded_;
+
+	/**
+	 * Identifies the results of the current filter, 0 if no results are
+	 * expected.
+	 */
+	int filterId_;
+
+	/**
+	 * A bit per row, set for rows matched by the filter thread.
+	 */
+	QBitArray matches_;
+
+	/**
+	 * The number of rows examined by the filter thread so far.
+	 */
+	int matchedRows_;
+
+	/**
+	 * The number of rows given to the filter thread.
+	 * Rows added later are matched directly.
+	 */
+	int filterRows_;
+
+	/**
+	 * Sorts large lists in the background.
+	 */
+	LocationSorter* sorter_;
+
+	/**
+	 * Identifies the results of the current sort, 0 if no results are
+	 * expected.
+	 */
+	int sortId_;
+
+	/**
+	 * The fields by which the current sort orders rows.
+	 */
+	QList<Location::Fields> sortKeys_;
+
+	/**
+	 * The column and order applied once the sort thread is done.
+	 */
+	int sortColumn_;
+	Qt::SortOrder sortOrder_;
+
+	/**
+	 * The position of each row in the sorted order, as computed by the sort
+	 * thread for rankKeys_.
+	 */
+	QVector<int> ranks_;
+
+	/**
+	 * The fields by which ranks_ order the rows, empty if the rows are not
+	 * ranked.
+	 */
+	QList<Location::Fields> rankKeys_;
+
+	/**
+	 * Delays ranking added rows until no more rows arrive for a while.
+	 */
+	QTimer rankTimer_;
+
+	void startSort(int, Qt::SortOrder, const QList<Location::Fields>&);
+	bool keyLessThan(int, int) const;
+
+private slots:
+	void filterMatched(int, const QBitArray&, int);
+	void sorterDone(int, const QVector<int>&);
+	void sourceAboutToBeReset();
+	void sourceRowsInserted();
+	void rankRows();
 };
 
 /**
@@ -94,6 +208,8 @@ public:
 	void resizeColumns();
 	virtual void toXML(QDomDocument&, QDomElement&) const;
 	virtual void fromXML(const QDomElement&);
+	virtual void toStream(LocationStream&) const;
+	virtual void fromStream(LocationStream&);
 
 	/**
 	 * @return  The type of the view
@@ -168,15 +284,32 @@ protected:
 	 */
 	QModelIndex menuIndex_;
 
+	/**
+	 * The widest row sampled in each column (source indices).
+	 */
+	QVector<QPersistentModelIndex> widest_;
+
+	/**
+	 * The text length of the widest row sampled in each column.
+	 */
+	QVector<int> widestLength_;
+
+	int cellWidth(const QModelIndex&) const;
 	virtual void contextMenuEvent(QContextMenuEvent*);
 	virtual void locationToXML(QDomDocument&, QDomElement&,
 	                           const QModelIndex&) const;
 	virtual void locationFromXML(const QDomElement&, const QModelIndex&);
+	void locationToStream(LocationStream&, const QModelIndex&) const;
+	void locationFromStream(LocationStream&, const QModelIndex&);
 
 protected slots:
 	void requestLocation(const QModelIndex&);
 	void promptFilter();
 	void clearFilter();
+	void sortByLocation();
+	void sampleRows(const QModelIndex&, int, int);
+	void samplesRemoved();
+	void resetSamples();
 };
 
 } // namespace Core
@@ -21,8 +21,11 @@
 #ifndef __PARSER_PARSER_H__
 #define __PARSER_PARSER_H__
 
+#include <QByteArray>
 #include <QString>
-#include <QVariant>
+#include <QVector>
+#include <cctype>
+#include <cstring>
 
 namespace KScope
 {
@@ -44,65 +47,125 @@ enum ParseResult
 };
 
 /**
- * A list of values captured during parsing.
- * The use of a QVector container allows us to pre-allocate the list when the
- * number of captured values is known (which is true in most cases, the
- * exception being parsers that include a Kleene-star expression).
+ * A single value captured during parsing.
+ * Captured strings are not copied out of the input: the object only records
+ * where the string is, and the text is decoded on demand. Input is parsed as
+ * raw process output, so decoding only captured strings avoids converting the
+ * entire output to UTF-16, and makes sure that multi-byte characters are never
+ * split between chunks of input.
+ * Captures refer to the input buffer, and are therefore only valid while the
+ * action of a matching transition is executed.
  */
-struct CapList
+struct Capture
 {
 	/**
-	 * The actual storage.
+	 * The beginning of a captured string.
 	 */
-	QVector<QVariant> caps_;
+	const char* data_;
 
 	/**
-	 * The number of used positions in the vector.
+	 * The length, in bytes, of a captured string.
 	 */
-	int used_;
+	int len_;
+
+	/**
+	 * The value of a captured number.
+	 */
+	int num_;
+
+	/**
+	 * @return The captured string, decoded from UTF-8
+	 */
+	QString toString() const { return QString::fromUtf8(data_, len_); }
+
+	/**
+	 * @return The captured number
+	 */
+	uint toUInt() const { return num_; }
 
 	/**
-	 * Default constructor.
-	 * Used when the number of captured values is not known in advance.
+	 * @return The first byte of the captured string
 	 */
-	CapList() : caps_(), used_(0) {}
+	char first() const { return len_ > 0 ? data_[0] : 0; }
 
+	/**
+	 * Compares the captured string with a fixed string, without decoding it.
+	 * @param  str  The string to compare with
+	 * @return true if the strings are equal, false otherwise
+	 */
+	bool equals(const char* str) const {
+		return (qstrlen(str) == (uint)len_) && (memcmp(data_, str, len_) == 0);
+	}
+};
+
+/**
+ * A list of values captured during parsing.
+ * The list is a view over storage provided by a SizedCapList object, which
+ * is a fixed-size array whenever the number of captured values is known at
+ * compile time (which is true in most cases, the exception being parsers that
+ * include a Kleene-star expression). Capturing values therefore does not
+ * allocate memory.
+ */
+struct CapList
+{
 	/**
 	 * Constructor.
-	 * Used when the number of captured values is known in advance.
-	 * @param  size  The number of values that can be captured by the parser
+	 * @param  caps      The storage for captured values
+	 * @param  capacity  The number of values that fit in the storage
 	 */
-	CapList(int size) : caps_(size), used_(0) {}
+	CapList(Capture* caps, int capacity) : caps_(caps), capacity_(capacity),
+		used_(0) {}
 
 	/**
-	 * Appends a value to the vector.
-	 * If the vector was pre-allocated, the value is set at the next available
-	 * position (rather than growing the vector, which is the default).
-	 * @param  var  The value to append
+	 * Appends a value to the list.
+	 * @param  cap  The value to append
 	 * @return A reference to this object
 	 */
-	CapList& operator<<(const QVariant& var) {
-		if (used_ < caps_.size())
-			caps_[used_++] = var;
-		else
-			caps_ << var;
+	CapList& operator<<(const Capture& cap) {
+		if (used_ == capacity_)
+			grow();
 
+		caps_[used_++] = cap;
 		return *this;
 	}
 
 	/**
-	 * Provides random access to the values in the vector.
+	 * Provides random access to the values in the list.
 	 * @param  pos  The position to get
 	 * @return The value at the given position
 	 */
-	const QVariant& operator[](int pos) const {
+	const Capture& operator[](int pos) const {
 		return caps_[pos];
 	}
 
 	/**
-	 * @return The size of the vector
+	 * @return The number of captured values
+	 */
+	int size() const { return used_; }
+
+protected:
+	/**
+	 * The actual storage.
 	 */
-	int size() const { return caps_.size(); }
+	Capture* caps_;
+
+	/**
+	 * The number of values that fit in the storage.
+	 */
+	int capacity_;
+
+	/**
+	 * The number of used positions in the storage.
+	 */
+	int used_;
+
+	/**
+	 * Called when the storage is full.
+	 * Only lists of an unknown size can grow.
+	 */
+	virtual void grow() {
+		qFatal("Too many captured values");
+	}
 };
 
 /**
@@ -111,7 +174,19 @@ struct CapList
 template<int S>
 struct SizedCapList : public CapList
 {
-	 SizedCapList() : CapList(S) {}
+	SizedCapList() : CapList(storage_, S) {}
+
+private:
+	Capture storage_[S];
+};
+
+/**
+ * Specialisation for parsers that do not capture any values.
+ */
+template<>
+struct SizedCapList<0> : public CapList
+{
+	SizedCapList() : CapList(NULL, 0) {}
 };
 
 /**
@@ -120,7 +195,16 @@ struct SizedCapList : public CapList
 template<>
 struct SizedCapList<-1> : public CapList
 {
-	 SizedCapList() : CapList() {}
+	SizedCapList() : CapList(NULL, 0) {}
+
+private:
+	QVector<Capture> storage_;
+
+	void grow() {
+		storage_.resize(qMax(capacity_ * 2, 8));
+		caps_ = storage_.data();
+		capacity_ = storage_.size();
+	}
 };
 
 /**
@@ -182,45 +266,63 @@ struct Literal : public Operators<Literal>
 	 * Class constructor.
 	 * @param  str  The string to match.
 	 */
-	Literal(const QString& str) : str_(str) {}
+	Literal(const char* str) : str_(str) {}
 
 	/**
 	 * Matches the object's string with a prefix of the input.
+	 * The comparison is done in place, without copying the input.
 	 * @param   input  The input string
 	 * @param   pos    The current position in the input string
 	 * @param   caps   An ordered list of captured values
 	 * @return  true if the input has a mathcing prefix, false otherwise
 	 */
-	ParseResult match(const QString& input, int& pos, CapList& caps) const {
+	ParseResult match(const QByteArray& input, int& pos, CapList& caps) const {
 		(void)caps;
 
 #ifdef DEBUG_PARSER
 		qDebug() << "Literal::match" << input.mid(pos) << str_;
 #endif
 
-		// If the input is shorter than the expected string, that it can be at
-		// most a partial match.
-		if (input.length() < str_.length())
-			return str_.startsWith(input) ? PartialMatch : NoMatch;
+		// If the remaining input is shorter than the expected string, that it
+		// can be at most a partial match.
+		int avail = input.size() - pos;
+		if (avail < str_.size()) {
+			return memcmp(input.constData() + pos, str_.constData(), avail) == 0
+			       ? PartialMatch : NoMatch;
+		}
 
 		// Input is longer than expected string, so it is either a full match or
 		// no match.
-		if (input.mid(pos, str_.length()) == str_) {
+		if (memcmp(input.constData() + pos, str_.constData(), str_.size())
+		    == 0) {
 #ifdef DEBUG_PARSER
 			qDebug() << str_;
 #endif
-			pos += str_.length();
+			pos += str_.size();
 			return FullMatch;
 		}
 
 		return NoMatch;
 	}
 
+	/**
+	 * Marks the characters that can begin input matched by the parser.
+	 * @param  chars  A table of 256 entries, indexed by character
+	 * @return true if the input can begin with any character, false otherwise
+	 */
+	bool firstChars(bool* chars) const {
+		if (str_.isEmpty())
+			return true;
+
+		chars[(uchar)str_[0]] = true;
+		return false;
+	}
+
 	static const int capCount_ = 0;
 
 private:
 	/** The string to match. */
-	const QString str_;
+	const QByteArray str_;
 };
 
 /**
@@ -236,7 +338,7 @@ struct Number : public Operators<Number>
 	 * @param   caps   An ordered list of captured values
 	 * @return  true if matched a number, false otherwise
 	 */
-	ParseResult match(const QString& input, int& pos, CapList& caps) const {
+	ParseResult match(const QByteArray& input, int& pos, CapList& caps) const {
 		int digit, number = 0;
 		bool foundNumber = false;
 
@@ -247,7 +349,8 @@ struct Number : public Operators<Number>
 		 // Iterate to the end of the input.
 		while (pos < input.size()) {
 			// Stop if a non-digit character is found.
-		    if ((digit = input[pos].digitValue()) == -1) {
+			digit = input[pos] - '0';
+		    if ((digit < 0) || (digit > 9)) {
 		    	// Check if any input was consumed.
 		    	if (!foundNumber)
 		    		return NoMatch;
@@ -256,7 +359,8 @@ struct Number : public Operators<Number>
 #ifdef DEBUG_PARSER
 				qDebug() << number;
 #endif
-		    	caps << number;
+		    	Capture cap = { NULL, 0, number };
+		    	caps << cap;
 		    	return FullMatch;
 		    }
 
@@ -272,14 +376,81 @@ struct Number : public Operators<Number>
 		return PartialMatch;
 	}
 
+	/**
+	 * Marks the characters that can begin input matched by the parser.
+	 * @param  chars  A table of 256 entries, indexed by character
+	 * @return false, as a number can only begin with a digit
+	 */
+	bool firstChars(bool* chars) const {
+		for (char c = '0'; c <= '9'; c++)
+			chars[(uchar)c] = true;
+
+		return false;
+	}
+
 	static const int capCount_ = 1;
 };
 
 /**
- * Captures a string delimited by a single character.
- * The default delimiter causes the string to match to the end of the input.
+ * A set of delimiter characters for the String parser.
  */
-template<class DelimT = QChar, bool AllowEmpty = false>
+struct CharSet
+{
+	/**
+	 * Class constructor.
+	 * @param  chars  The characters in the set
+	 */
+	CharSet(const char* chars) : chars_(chars) {}
+
+	/**
+	 * Finds the first occurrence of any of the characters in the set.
+	 * @param  input  The input string
+	 * @param  pos    The position from which to start the search
+	 * @return The position of the character, -1 if not found
+	 */
+	int indexIn(const QByteArray& input, int pos) const {
+		const char* data = input.constData();
+		for (int i = pos; i < input.size(); i++) {
+			if (data[i] != 0 && strchr(chars_, data[i]) != NULL)
+				return i;
+		}
+
+		return -1;
+	}
+
+	/** The characters in the set. */
+	const char* chars_;
+};
+
+/**
+ * Finds a single-character delimiter.
+ * @param  input  The input string
+ * @param  delim  The delimiter
+ * @param  pos    The position from which to start the search
+ * @return The position of the delimiter, -1 if not found
+ */
+inline int findDelim(const QByteArray& input, char delim, int pos)
+{
+	return input.indexOf(delim, pos);
+}
+
+/**
+ * Finds any character in a set of delimiters.
+ * @param  input  The input string
+ * @param  delim  The delimiter set
+ * @param  pos    The position from which to start the search
+ * @return The position of the delimiter, -1 if not found
+ */
+inline int findDelim(const QByteArray& input, const CharSet& delim, int pos)
+{
+	return delim.indexIn(input, pos);
+}
+
+/**
+ * Captures a string delimited by a single character, or by any character in a
+ * CharSet.
+ */
+template<class DelimT = char, bool AllowEmpty = false>
 struct String : public Operators< String<DelimT, AllowEmpty> >
 {
 	String(DelimT delim) : delim_(delim) {}
@@ -291,7 +462,7 @@ struct String : public Operators< String<DelimT, AllowEmpty> >
 	 * @param   caps   An ordered list of captured values
 	 * @return  true if matched a non-empty string, false otherwise
 	 */
-	ParseResult match(const QString& input, int& pos, CapList& caps) const {
+	ParseResult match(const QByteArray& input, int& pos, CapList& caps) const {
 #ifdef DEBUG_PARSER
 		qDebug() << "String::match" << input.mid(pos);
 #endif
@@ -300,7 +471,7 @@ struct String : public Operators< String<DelimT, AllowEmpty> >
 			return PartialMatch;
 
 		// Find an occurrence of the delimiter.
-		int delimPos = input.indexOf(delim_, pos);
+		int delimPos = findDelim(input, delim_, pos);
 		if (delimPos == -1)
 			return PartialMatch;
 
@@ -312,11 +483,22 @@ struct String : public Operators< String<DelimT, AllowEmpty> >
 #ifdef DEBUG_PARSER
 		qDebug() << input.mid(pos, delimPos - pos);
 #endif
-		caps << input.mid(pos, delimPos - pos);
+		Capture cap = { input.constData() + pos, delimPos - pos, 0 };
+		caps << cap;
 		pos = delimPos;
 		return FullMatch;
 	}
 
+	/**
+	 * Marks the characters that can begin input matched by the parser.
+	 * @param  chars  ignored
+	 * @return true, as a string can begin with any character
+	 */
+	bool firstChars(bool* chars) const {
+		(void)chars;
+		return true;
+	}
+
 	static const int capCount_ = 1;
 
 private:
@@ -335,19 +517,29 @@ struct Whitespace : public Operators<Whitespace>
 	 * @param   caps   An ordered list of captured values
 	 * @return  Always true
 	 */
-	ParseResult match(const QString& input, int& pos, CapList& caps) const {
+	ParseResult match(const QByteArray& input, int& pos, CapList& caps) const {
 		(void)caps;
 
 #ifdef DEBUG_PARSER
 		qDebug() << "Whitespace::match" << input;
 #endif
 
-		while ((pos < input.size()) && (input[pos].isSpace()))
+		while ((pos < input.size()) && (isspace((uchar)input[pos])))
 			pos++;
 
 		return FullMatch;
 	}
 
+	/**
+	 * Marks the characters that can begin input matched by the parser.
+	 * @param  chars  ignored
+	 * @return true, as the parser also matches empty input
+	 */
+	bool firstChars(bool* chars) const {
+		(void)chars;
+		return true;
+	}
+
 	static const int capCount_ = 0;
 };
 
@@ -360,7 +552,7 @@ struct Concat : public Operators< Concat<Exp1T, Exp2T> >
 {
 	Concat(Exp1T exp1, Exp2T exp2) : exp1_(exp1), exp2_(exp2) {}
 
-	ParseResult match(const QString& input, int& pos, CapList& caps) const {
+	ParseResult match(const QByteArray& input, int& pos, CapList& caps) const {
 		ParseResult result = exp1_.match(input, pos, caps);
 		if (result == FullMatch)
 			return exp2_.match(input, pos, caps);
@@ -368,6 +560,10 @@ struct Concat : public Operators< Concat<Exp1T, Exp2T> >
 		return result;
 	}
 
+	bool firstChars(bool* chars) const {
+		return exp1_.firstChars(chars);
+	}
+
 	static const int capCount_
 		= AddCapCount<Exp1T::capCount_, Exp2T::capCount_>::result_;
 
@@ -385,7 +581,7 @@ struct Kleene : public Operators< Kleene<ExpT> >
 {
 	Kleene(ExpT exp) : exp_(exp) {}
 
-	ParseResult match(const QString& input, int& pos, CapList& caps) const {
+	ParseResult match(const QByteArray& input, int& pos, CapList& caps) const {
 		ParseResult result;
 		while ((result = exp_.match(input, pos, caps)) == FullMatch)
 			;
@@ -396,6 +592,13 @@ struct Kleene : public Operators< Kleene<ExpT> >
 		return FullMatch;
 	}
 
+	bool firstChars(bool* chars) const {
+		(void)chars;
+		return true;
+	}
+
+	static const int capCount_ = -1;
+
 private:
 	ExpT exp_;
 };
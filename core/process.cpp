@@ -26,7 +26,8 @@ namespace KScope
 namespace Core
 {
 
-Process::Process(QObject* parent) : QProcess(parent)
+Process::Process(QObject* parent) : QProcess(parent), parsePos_(0),
+	deleteOnExit_(false)
 {
 	connect(this, SIGNAL(readyReadStandardOutput()), this,
 	        SLOT(readStandardOutput()));
@@ -49,14 +50,25 @@ void Process::setDeleteOnExit()
 
 void Process::readStandardOutput()
 {
+	// Discard parsed output before reading more.
+	// The buffer is only compacted once the parsed part is at least as large
+	// as the unparsed one, so that each byte is moved a bounded number of
+	// times, no matter how the output is divided into chunks.
+	if (parsePos_ > 0 && parsePos_ >= (stdOut_.size() - parsePos_)) {
+		stdOut_.remove(0, parsePos_);
+		parsePos_ = 0;
+	}
+
 	// Read from standard output.
-	stdOut_ += readAllStandardOutput();
+	stdOut_.append(readAllStandardOutput());
 
 	// Parse the text.
-	if (!parse(stdOut_)) {
+	if (!parse(stdOut_, parsePos_)) {
 		emit parseError();
 		return;
 	}
+
+	outputParsed();
 }
 
 void Process::readStandardError()
@@ -77,6 +89,13 @@ void Process::handleError(QProcess::ProcessError code)
 void Process::handleStateChange(QProcess::ProcessState state)
 {
 	qDebug() << "Process state" << state;
+
+	// Do not carry partial output into a new run of the process.
+	if (state == QProcess::Starting) {
+		stdOut_.clear();
+		parsePos_ = 0;
+	}
+
 	if (state == QProcess::NotRunning && deleteOnExit_)
 		deleteLater();
 }
@@ -52,8 +52,25 @@ protected slots:
 	virtual void handleError(QProcess::ProcessError);
 	virtual void handleStateChange(QProcess::ProcessState);
 
+protected:
+	/**
+	 * Called after each chunk of output is parsed successfully.
+	 * Allows derived classes to act on partial results while the process is
+	 * still running.
+	 */
+	virtual void outputParsed() {}
+
 private:
-	QString stdOut_;
+	/**
+	 * Output read from the process, but not parsed yet.
+	 */
+	QByteArray stdOut_;
+
+	/**
+	 * The position in stdOut_ of the first unparsed byte.
+	 */
+	int parsePos_;
+
 	bool deleteOnExit_;
 
 private slots:
@@ -124,6 +124,12 @@ public:
 	 * @return Pointer to the code base
 	 */
 	virtual Codebase* codebase() = 0;
+
+	/**
+	 * Retrieves a copy of the current configuration parameters.
+	 * @param  params  An object into which current values are copied
+	 */
+	virtual void getCurrentParams(Params& params) const = 0;
 };
 
 /**
@@ -284,7 +290,7 @@ public:
 	 * Retrieves a copy of the current configuration parameters.
 	 * @param  params  An object into which current values are copied
 	 */
-	void getCurrentParams(Params& params) const {
+	virtual void getCurrentParams(Params& params) const {
 		params = params_;
 	}
 
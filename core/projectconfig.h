@@ -46,7 +46,7 @@ struct ProjectConfig
 	 * @param  parent   A parent for the new widget
 	 * @return The created widget (NULL by default)
 	 */
-	static QWidget* createConfigWidget(const ProjectT* project,
+	static QWidget* createConfigWidget(const ProjectBase* project,
 	                                   QWidget* parent) {
 		(void)project;
 		(void)parent;
@@ -0,0 +1,215 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "querycache.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The default bound on the memory used by cached results, in bytes.
+ */
+static const int DefaultMaxSize = 32 * 1024 * 1024;
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+QueryCache::QueryCache(QObject* parent) : QObject(parent),
+	cache_(DefaultMaxSize), generation_(0), hits_(0), misses_(0)
+{
+}
+
+/**
+ * Class destructor.
+ * Results not delivered yet are aborted.
+ */
+QueryCache::~QueryCache()
+{
+	while (!pending_.isEmpty())
+		cancel(pending_.first());
+}
+
+/**
+ * Answers a query from the cache, if possible.
+ * @param  conn        The connection to deliver the results to
+ * @param  query       The query
+ * @param  generation  The current database generation
+ * @return true if the query was answered, false if the results are not in the
+ *         cache
+ */
+bool QueryCache::answer(Engine::Connection* conn, const Query& query,
+                        uint generation)
+{
+	const CompactLocationList* locList = NULL;
+	if (generation == generation_)
+		locList = cache_.object(key(query));
+
+	if (locList == NULL) {
+		misses_++;
+		return false;
+	}
+
+	hits_++;
+
+	Result* result = new Result;
+	result->cache_ = this;
+	result->conn_ = conn;
+	result->locList_ = *locList;
+	conn->setCtrlObject(result);
+
+	pending_.append(result);
+	if (pending_.size() == 1)
+		QMetaObject::invokeMethod(this, "deliverResults", Qt::QueuedConnection);
+
+	return true;
+}
+
+/**
+ * Creates a connection object that stores the results of a query, once it
+ * completes successfully.
+ * The object deletes itself when the query terminates.
+ * @param  conn        The connection to pass the results to
+ * @param  query       The query
+ * @param  generation  The current database generation
+ * @return The connection object to pass to the query
+ */
+Engine::Connection* QueryCache::collect(Engine::Connection* conn,
+                                        const Query& query, uint generation)
+{
+	Collector* collector = new Collector;
+	collector->cache_ = this;
+	collector->conn_ = conn;
+	collector->key_ = key(query);
+	collector->generation_ = generation;
+	conn->setCtrlObject(collector);
+	return collector;
+}
+
+/**
+ * Discards all cached results.
+ */
+void QueryCache::clear()
+{
+	cache_.clear();
+}
+
+/**
+ * Generates a key for a query.
+ * Queries that only differ by the Background flag share the same results.
+ * @param  query  The query
+ * @return The key
+ */
+QString QueryCache::key(const Query& query)
+{
+	return QString("%1:%2:%3").arg(query.type_)
+	                          .arg(query.flags_ & ~Query::Background)
+	                          .arg(query.pattern_);
+}
+
+/**
+ * Stores the results of a query.
+ * Results of a newer generation flush the cache.
+ * @param  key         Identifies the query
+ * @param  generation  The database generation at the time of the query
+ * @param  locList     The results
+ */
+void QueryCache::insert(const QString& key, uint generation,
+                        const CompactLocationList& locList)
+{
+	if (generation != generation_) {
+		// Results of an older database are of no use.
+		if ((int)(generation - generation_) < 0)
+			return;
+
+		cache_.clear();
+		generation_ = generation;
+	}
+
+	// Results larger than the cache are discarded by QCache.
+	cache_.insert(key, new CompactLocationList(locList),
+	              qMax(locList.memorySize(), 1));
+}
+
+/**
+ * Discards a result that was not delivered yet.
+ * @param  result  The result to discard
+ */
+void QueryCache::cancel(Result* result)
+{
+	if (!pending_.removeOne(result))
+		return;
+
+	Engine::Connection* conn = result->conn_;
+	delete result;
+
+	conn->setCtrlObject(NULL);
+	conn->onAborted();
+}
+
+/**
+ * Delivers all pending cached results.
+ */
+void QueryCache::deliverResults()
+{
+	while (!pending_.isEmpty()) {
+		Result* result = pending_.takeFirst();
+		Engine::Connection* conn = result->conn_;
+		CompactLocationList locList = result->locList_;
+		delete result;
+
+		conn->setCtrlObject(NULL);
+		if (!locList.isEmpty())
+			conn->onDataReady(locList);
+		conn->onFinished();
+	}
+}
+
+/**
+ * Stores the results, and notifies the original connection.
+ */
+void QueryCache::Collector::onFinished()
+{
+	Engine::Connection* conn = conn_;
+	cache_->insert(key_, generation_, locList_);
+	delete this;
+
+	conn->setCtrlObject(NULL);
+	conn->onFinished();
+}
+
+/**
+ * Notifies the original connection, without storing the partial results.
+ */
+void QueryCache::Collector::onAborted()
+{
+	Engine::Connection* conn = conn_;
+	delete this;
+
+	conn->setCtrlObject(NULL);
+	conn->onAborted();
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_QUERYCACHE_H__
+#define __CORE_QUERYCACHE_H__
+
+#include <QObject>
+#include <QCache>
+#include "engine.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Keeps the results of recent queries.
+ * Results are identified by the query (type, pattern and flags) and by a
+ * database generation number, which the engine increments whenever the
+ * database changes. Entries of earlier generations are discarded.
+ * The cache is bounded by the estimated memory used by the results, and
+ * evicts the least recently used entries first.
+ * Cached results are delivered from the event loop, rather than from within
+ * the engine's query() method, as callers do not expect a connection to be
+ * notified before the query call returns.
+ * @author Elad Lahav
+ */
+class QueryCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	QueryCache(QObject* parent = NULL);
+	~QueryCache();
+
+	bool answer(Engine::Connection*, const Query&, uint);
+	Engine::Connection* collect(Engine::Connection*, const Query&, uint);
+	void clear();
+
+	/**
+	 * @param  bytes  The maximal amount of memory to use for results
+	 */
+	void setMaxSize(int bytes) { cache_.setMaxCost(bytes); }
+
+	/**
+	 * @return The number of queries answered from the cache
+	 */
+	uint hits() const { return hits_; }
+
+	/**
+	 * @return The number of queries not found in the cache
+	 */
+	uint misses() const { return misses_; }
+
+private:
+	/**
+	 * Passes results from the engine to the original connection object, while
+	 * keeping a copy for the cache.
+	 */
+	struct Collector : public Engine::Connection, public Engine::Controlled
+	{
+		QueryCache* cache_;
+		Engine::Connection* conn_;
+		QString key_;
+		uint generation_;
+		CompactLocationList locList_;
+
+		void onDataReady(const CompactLocationList& locList) {
+			locList_ += locList;
+			conn_->onDataReady(locList);
+		}
+
+		void onFinished();
+		void onAborted();
+
+		void onProgress(const QString& text, uint cur, uint total) {
+			conn_->onProgress(text, cur, total);
+		}
+
+		/**
+		 * Forwards a request to stop the query to the engine's control
+		 * object.
+		 */
+		void stop() { Engine::Connection::stop(); }
+	};
+
+	/**
+	 * Cached results waiting to be delivered.
+	 */
+	struct Result : public Engine::Controlled
+	{
+		QueryCache* cache_;
+		Engine::Connection* conn_;
+		CompactLocationList locList_;
+
+		void stop() { cache_->cancel(this); }
+	};
+
+	/**
+	 * The cached results, keyed by query.
+	 */
+	QCache<QString, CompactLocationList> cache_;
+
+	/**
+	 * The database generation of the cached results.
+	 */
+	uint generation_;
+
+	/**
+	 * Results waiting to be delivered.
+	 */
+	QList<Result*> pending_;
+
+	/**
+	 * Counters.
+	 */
+	uint hits_;
+	uint misses_;
+
+	static QString key(const Query&);
+	void insert(const QString&, uint, const CompactLocationList&);
+	void cancel(Result*);
+
+private slots:
+	void deliverResults();
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_QUERYCACHE_H__
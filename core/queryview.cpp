@@ -21,6 +21,7 @@
 #include "queryview.h"
 #include "exception.h"
 #include "engine.h"
+#include "locationstream.h"
 #include "progressbar.h"
 
 namespace KScope
@@ -29,6 +30,16 @@ namespace KScope
 namespace Core
 {
 
+/**
+ * The default number of levels prefetched below the displayed items.
+ */
+static const int DefaultPrefetchDepth = 1;
+
+/**
+ * The maximal number of background queries running at the same time.
+ */
+static const int MaxPrefetchQueries = 2;
+
 /**
  * Class constructor.
  * @param  parent  The parent widget
@@ -36,7 +47,7 @@ namespace Core
  */
 QueryView::QueryView(QWidget* parent, Type type)
 	: LocationView(parent, type), progBar_(NULL),
-	  autoSelectSingleResult_(false)
+	  autoSelectSingleResult_(false), prefetchDepth_(DefaultPrefetchDepth)
 {
 	// Query child items when expanded (in a tree view).
 	if (type_ == Tree) {
@@ -49,9 +60,12 @@ QueryView::QueryView(QWidget* parent, Type type)
 
 /**
  * Class destructor.
+ * Stops all running queries, so that the engine does not reference the
+ * view's connection objects once it is destroyed.
  */
 QueryView::~QueryView()
 {
+	stopQuery();
 }
 
 /**
@@ -62,6 +76,10 @@ void QueryView::query(const Query& query)
 	// Delete the model data.
 	locationModel()->clear(QModelIndex());
 
+	// Prefetched results belong to the previous query.
+	stopPrefetch();
+	prefetched_.clear();
+
 	try {
 		// Get an engine for running the query.
 		Engine* eng;
@@ -118,14 +136,48 @@ void QueryView::fromXML(const QDomElement& viewElem)
 	LocationView::fromXML(viewElem);
 }
 
+/**
+ * Writes a binary representation of the view to a stream.
+ * Adds query information to the representation created by
+ * LocationView::toStream().
+ * @param  strm  The stream to write to
+ */
+void QueryView::toStream(LocationStream& strm) const
+{
+	strm.stream() << (quint32)query_.type_ << (quint32)query_.flags_
+	              << query_.pattern_;
+
+	LocationView::toStream(strm);
+}
+
+/**
+ * Loads a query view from a binary representation.
+ * @param  strm  The stream to read from
+ */
+void QueryView::fromStream(LocationStream& strm)
+{
+	// Get query information.
+	quint32 type, flags;
+	QString pattern;
+	strm.stream() >> type >> flags >> pattern;
+	if (!strm.isValid())
+		return;
+
+	query_.type_ = static_cast<Core::Query::Type>(type);
+	query_.flags_ = flags;
+	query_.pattern_ = pattern;
+
+	LocationView::fromStream(strm);
+}
+
 /**
  * Called by the engine when results are available.
  * Adds the list of locations to the model.
  * @param  locList  Query results
  */
-void QueryView::onDataReady(const LocationList& locList)
+void QueryView::onDataReady(const CompactLocationList& locList)
 {
-	locationModel()->add(locList, queryIndex_);
+	locationModel()->add(locList, QModelIndex());
 }
 
 /**
@@ -157,21 +209,18 @@ void QueryView::onProgress(const QString& text, uint cur, uint total)
 void QueryView::onFinished()
 {
 	// Handle an empty result set.
-	if (locationModel()->rowCount(queryIndex_) == 0)
-		locationModel()->add(LocationList(), queryIndex_);
+	if (locationModel()->rowCount(QModelIndex()) == 0)
+		locationModel()->add(CompactLocationList(), QModelIndex());
 
 	// Destroy the progress-bar, if it exists.
-	if (progBar_) {
-		delete progBar_;
-		progBar_ = NULL;
-	}
+	deleteProgressBar();
 
 	// Adjust column sizes.
 	resizeColumns();
 
 	// Auto-select a single result, if required.
 	Location loc;
-	if (autoSelectSingleResult_ && locationModel()->rowCount(queryIndex_) == 1
+	if (autoSelectSingleResult_ && locationModel()->rowCount(QModelIndex()) == 1
 	                            && locationModel()->firstLocation(loc)) {
 		emit locationRequested(loc);
 	}
@@ -180,6 +229,10 @@ void QueryView::onFinished()
 		if (!isVisible())
 			emit needToShow();
 	}
+
+	// Start querying the next level of a call tree.
+	if (type_ == Tree)
+		prefetch(QModelIndex());
 }
 
 /**
@@ -188,6 +241,40 @@ void QueryView::onFinished()
 void QueryView::onAborted()
 {
 	// Destroy the progress-bar, if it exists.
+	deleteProgressBar();
+}
+
+/**
+ * Called when a query on a tree item terminates.
+ * @param  conn     The connection object for the query
+ * @param  success  true if the query terminated normally, false otherwise
+ */
+void QueryView::itemQueryDone(TreeItemConnection* conn, bool success)
+{
+	// Mark a queried item with no results, so that it is not queried again.
+	if (success && conn->index_.isValid()
+	    && locationModel()->rowCount(conn->index_) == 0) {
+		locationModel()->add(CompactLocationList(), conn->index_);
+	}
+
+	// Start querying the next level.
+	if (success && conn->index_.isValid())
+		prefetch(conn->index_);
+
+	itemConnList_.removeOne(conn);
+	delete conn;
+
+	deleteProgressBar();
+}
+
+/**
+ * Destroys the progress-bar, unless there are still running queries.
+ */
+void QueryView::deleteProgressBar()
+{
+	if (ctrlObject_ != NULL || !itemConnList_.isEmpty())
+		return;
+
 	if (progBar_) {
 		delete progBar_;
 		progBar_ = NULL;
@@ -196,11 +283,19 @@ void QueryView::onAborted()
 
 /**
  * Called when the "Cancel" button is clicked in the progress-bar.
- * Informs the engine that the query process should be stopped.
+ * Informs the engine that the query process should be stopped, along with any
+ * queries on tree items.
  */
 void QueryView::stopQuery()
 {
 	stop();
+
+	// Stopping a query may remove it from the list.
+	QList<TreeItemConnection*> connList = itemConnList_;
+	foreach (TreeItemConnection* conn, connList)
+		conn->stop();
+
+	stopPrefetch();
 }
 
 /**
@@ -215,20 +310,45 @@ void QueryView::queryTreeItem(const QModelIndex& index)
 	if (locationModel()->isEmpty(srcIndex) != LocationModel::Unknown)
 		return;
 
+	// Do not query an item twice.
+	foreach (TreeItemConnection* conn, itemConnList_) {
+		if (conn->index_ == srcIndex)
+			return;
+	}
+
 	// Get the location information from the index.
 	Location loc;
 	if (!locationModel()->locationFromIndex(srcIndex, loc))
 		return;
 
+	// Use prefetched results, if available.
+	QHash<QString, CompactLocationList>::ConstIterator itr
+		= prefetched_.find(loc.tag_.scope_);
+	if (itr != prefetched_.end()) {
+		// An empty list marks the item as having no children.
+		locationModel()->add(*itr, srcIndex);
+		prefetch(srcIndex);
+		return;
+	}
+
 	// Run a query on this location.
+	// Each item uses its own connection, so that several items can be queried
+	// at the same time.
+	TreeItemConnection* conn = NULL;
 	try {
 		Engine* eng;
 		if ((eng = engine()) != NULL) {
-			queryIndex_ = srcIndex;
-			eng->query(this, Query(query_.type_, loc.tag_.scope_));
+			conn = new TreeItemConnection(this, srcIndex);
+			itemConnList_.append(conn);
+			eng->query(conn, Query(query_.type_, loc.tag_.scope_));
 		}
 	}
 	catch (Exception* e) {
+		if (conn) {
+			itemConnList_.removeOne(conn);
+			delete conn;
+		}
+
 		e->showMessage();
 		delete e;
 	}
@@ -250,11 +370,134 @@ void QueryView::requery()
 	}
 
 	// Tree view: rerun the current branch only.
+	// Prefetched results for the branch are discarded, as these may be
+	// out of date.
 	QModelIndex srcIndex = proxy()->mapToSource(menuIndex_);
+	Location loc;
+	if (locationModel()->locationFromIndex(srcIndex, loc))
+		prefetched_.remove(loc.tag_.scope_);
+
 	locationModel()->clear(srcIndex);
 	queryTreeItem(menuIndex_);
 }
 
+/**
+ * Queues background queries for the children of a tree item.
+ * @param  parent  The item (source index)
+ */
+void QueryView::prefetch(const QModelIndex& parent)
+{
+	if (prefetchDepth_ <= 0)
+		return;
+
+	LocationModel* model = locationModel();
+	int rows = model->rowCount(parent);
+	for (int i = 0; i < rows; i++) {
+		Location loc;
+		if (model->locationFromIndex(model->index(i, 0, parent), loc))
+			prefetch(loc.tag_.scope_, prefetchDepth_);
+	}
+
+	startPrefetch();
+}
+
+/**
+ * Queues a background query for a symbol, unless its results are already
+ * available or pending.
+ * @param  symbol  The symbol to query
+ * @param  depth   The number of levels to prefetch, starting with this symbol
+ */
+void QueryView::prefetch(const QString& symbol, int depth)
+{
+	if (symbol.isEmpty() || prefetched_.contains(symbol)
+	    || prefetchPending_.contains(symbol)) {
+		return;
+	}
+
+	PrefetchRequest req;
+	req.symbol_ = symbol;
+	req.depth_ = depth;
+	prefetchQueue_.append(req);
+	prefetchPending_.insert(symbol);
+}
+
+/**
+ * Starts queued background queries, keeping the number of running queries
+ * bounded.
+ */
+void QueryView::startPrefetch()
+{
+	Engine* eng = engine();
+	if (eng == NULL) {
+		prefetchQueue_.clear();
+		prefetchPending_.clear();
+		return;
+	}
+
+	while (prefetchConnList_.size() < MaxPrefetchQueries
+	       && !prefetchQueue_.isEmpty()) {
+		PrefetchRequest req = prefetchQueue_.takeFirst();
+		PrefetchConnection* conn
+			= new PrefetchConnection(this, req.symbol_, req.depth_);
+		prefetchConnList_.append(conn);
+
+		try {
+			eng->query(conn, Query(query_.type_, req.symbol_,
+			                       Query::Background));
+		}
+		catch (Exception* e) {
+			prefetchConnList_.removeOne(conn);
+			prefetchPending_.remove(req.symbol_);
+			delete conn;
+			delete e;
+		}
+	}
+}
+
+/**
+ * Called when a background query terminates.
+ * The results are kept, and the next level is queued, if required.
+ * @param  conn     The connection object for the query
+ * @param  success  true if the query terminated normally, false otherwise
+ */
+void QueryView::prefetchDone(PrefetchConnection* conn, bool success)
+{
+	// Ignore queries that were cancelled.
+	if (!prefetchConnList_.removeOne(conn)) {
+		delete conn;
+		return;
+	}
+
+	prefetchPending_.remove(conn->symbol_);
+
+	if (success) {
+		prefetched_.insert(conn->symbol_, conn->locList_);
+		if (conn->depth_ > 1) {
+			for (int i = 0; i < conn->locList_.size(); i++)
+				prefetch(conn->locList_.scope(i), conn->depth_ - 1);
+		}
+	}
+
+	delete conn;
+	startPrefetch();
+}
+
+/**
+ * Cancels all queued and running background queries.
+ */
+void QueryView::stopPrefetch()
+{
+	prefetchQueue_.clear();
+	prefetchPending_.clear();
+
+	// Detached connections no longer refer to the view, and delete themselves
+	// whenever their queries terminate.
+	QList<PrefetchConnection*> connList = prefetchConnList_;
+	prefetchConnList_.clear();
+	foreach (PrefetchConnection* conn, connList)
+		conn->detach();
+}
+
 } // namespace Core
 
 } // namespace KScope
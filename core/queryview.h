@@ -21,6 +21,8 @@
 #ifndef __CORE_QUERYVIEW_H__
 #define __CORE_QUERYVIEW_H__
 
+#include <QHash>
+#include <QSet>
 #include "locationview.h"
 #include "globals.h"
 #include "engine.h"
@@ -51,6 +53,9 @@ class ProgressBar;
  * Note that the tree view can only work with option 2, as the queryTreeItem()
  * method, connected to the expanded() signal, uses the engine to query run a
  * query on a child item.
+ * In tree mode, the view speculatively queries the items below the displayed
+ * ones (up to a configurable depth), using background queries. Expanding an
+ * item whose results were prefetched does not require a query.
  * @author Elad Lahav
  */
 class QueryView : public LocationView, public Engine::Connection
@@ -64,6 +69,8 @@ public:
 	void query(const Query&);
 	virtual void toXML(QDomDocument&, QDomElement&) const;
 	virtual void fromXML(const QDomElement&);
+	virtual void toStream(LocationStream&) const;
+	virtual void fromStream(LocationStream&);
 
 	/**
 	 * In the case the query returns only a single location, determines whether
@@ -74,8 +81,20 @@ public:
 		autoSelectSingleResult_ = select;
 	}
 
+	/**
+	 * Determines how many levels below the displayed items are prefetched in
+	 * a tree view.
+	 * @param  depth  The number of levels, 0 to disable prefetching
+	 */
+	void setPrefetchDepth(int depth) { prefetchDepth_ = depth; }
+
+	/**
+	 * @return The number of levels prefetched below the displayed items
+	 */
+	int prefetchDepth() const { return prefetchDepth_; }
+
 	// Engine::Connection implementation.
-	virtual void onDataReady(const LocationList&);
+	virtual void onDataReady(const CompactLocationList&);
 	virtual void onFinished();
 	virtual void onAborted();
 	virtual void onProgress(const QString&, uint, uint);
@@ -91,6 +110,161 @@ protected:
 	virtual Engine* engine() { return NULL; }
 
 private:
+	/**
+	 * A connection for a query on a tree item.
+	 * Each expanded item gets its own connection object, so that queries for
+	 * several items can run concurrently.
+	 */
+	struct TreeItemConnection : public Engine::Connection
+	{
+		/**
+		 * Struct constructor.
+		 * @param  view   The owner view
+		 * @param  index  The item being queried (source index)
+		 */
+		TreeItemConnection(QueryView* view, const QModelIndex& index)
+			: Engine::Connection(), view_(view), index_(index) {}
+
+		/**
+		 * Adds results under the queried item.
+		 * @param  locList  Query results
+		 */
+		void onDataReady(const CompactLocationList& locList) {
+			if (index_.isValid())
+				view_->locationModel()->add(locList, index_);
+		}
+
+		/**
+		 * Called when the query terminates normally.
+		 */
+		void onFinished() { view_->itemQueryDone(this, true); }
+
+		/**
+		 * Called when the query terminates abnormally.
+		 */
+		void onAborted() { view_->itemQueryDone(this, false); }
+
+		/**
+		 * Forwards progress information to the view.
+		 * @param  text  Progress message
+		 * @param  cur   Current value
+		 * @param  total Expected final value
+		 */
+		void onProgress(const QString& text, uint cur, uint total) {
+			view_->onProgress(text, cur, total);
+		}
+
+		/**
+		 * The owner view.
+		 */
+		QueryView* view_;
+
+		/**
+		 * The item being queried.
+		 * A persistent index is used since the model may change while the
+		 * query is running.
+		 */
+		QPersistentModelIndex index_;
+	};
+
+	/**
+	 * A connection for a background query, whose results are kept until the
+	 * queried symbol is expanded.
+	 */
+	struct PrefetchConnection : public Engine::Connection
+	{
+		/**
+		 * Struct constructor.
+		 * @param  view    The owner view
+		 * @param  symbol  The queried symbol
+		 * @param  depth   The number of levels to prefetch below the results
+		 */
+		PrefetchConnection(QueryView* view, const QString& symbol, int depth)
+			: Engine::Connection(), view_(view), symbol_(symbol),
+			  depth_(depth) {}
+
+		/**
+		 * Collects the results.
+		 * @param  locList  Query results
+		 */
+		void onDataReady(const CompactLocationList& locList) {
+			locList_ += locList;
+		}
+
+		/**
+		 * Called when the query terminates normally.
+		 * A detached connection deletes itself.
+		 */
+		void onFinished() {
+			if (view_)
+				view_->prefetchDone(this, true);
+			else
+				delete this;
+		}
+
+		/**
+		 * Called when the query terminates abnormally.
+		 * A detached connection deletes itself.
+		 */
+		void onAborted() {
+			if (view_)
+				view_->prefetchDone(this, false);
+			else
+				delete this;
+		}
+
+		/**
+		 * Detaches the connection from the view, and stops the query.
+		 * The object is deleted once the query terminates, which may happen
+		 * before this method returns, without notifying the view.
+		 */
+		void detach() {
+			view_ = NULL;
+			if (ctrlObject_ == NULL)
+				delete this;
+			else
+				stop();
+		}
+
+		/**
+		 * Background queries do not display progress.
+		 */
+		void onProgress(const QString& text, uint cur, uint total) {
+			(void)text;
+			(void)cur;
+			(void)total;
+		}
+
+		/**
+		 * The owner view.
+		 */
+		QueryView* view_;
+
+		/**
+		 * The queried symbol.
+		 */
+		QString symbol_;
+
+		/**
+		 * The number of levels to prefetch below the results.
+		 */
+		int depth_;
+
+		/**
+		 * The results collected so far.
+		 */
+		CompactLocationList locList_;
+	};
+
+	/**
+	 * A symbol waiting to be prefetched.
+	 */
+	struct PrefetchRequest
+	{
+		QString symbol_;
+		int depth_;
+	};
+
 	/**
 	 * The query associated with this view.
 	 * This can be used, e.g., for re-running the query from within the view.
@@ -98,9 +272,9 @@ private:
 	Query query_;
 
 	/**
-	 * The index under which query results should be put.
+	 * Queries running on tree items.
 	 */
-	QModelIndex queryIndex_;
+	QList<TreeItemConnection*> itemConnList_;
 
 	/**
 	 * A progress-bar for displaying query progress information.
@@ -116,6 +290,39 @@ private:
 	 */
 	bool autoSelectSingleResult_;
 
+	/**
+	 * The number of levels below the displayed items to prefetch.
+	 */
+	int prefetchDepth_;
+
+	/**
+	 * Maps symbols to the prefetched results of querying them.
+	 */
+	QHash<QString, CompactLocationList> prefetched_;
+
+	/**
+	 * Symbols waiting to be prefetched.
+	 */
+	QList<PrefetchRequest> prefetchQueue_;
+
+	/**
+	 * Symbols waiting to be prefetched, or being prefetched.
+	 */
+	QSet<QString> prefetchPending_;
+
+	/**
+	 * Running background queries.
+	 */
+	QList<PrefetchConnection*> prefetchConnList_;
+
+	void itemQueryDone(TreeItemConnection*, bool);
+	void deleteProgressBar();
+	void prefetch(const QModelIndex&);
+	void prefetch(const QString&, int);
+	void startPrefetch();
+	void prefetchDone(PrefetchConnection*, bool);
+	void stopPrefetch();
+
 private slots:
 	void stopQuery();
 	void queryTreeItem(const QModelIndex&);
@@ -0,0 +1,213 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include "scancache.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Identifies scan cache files.
+ */
+static const quint32 ScanCacheMagic = 0x4b535343;
+
+/**
+ * Incremented whenever the scan cache file format changes.
+ */
+static const quint32 ScanCacheVersion = 1;
+
+/**
+ * Directories modified this close to the start of a scan (in milliseconds)
+ * are not trusted, as they may change again without the recorded time
+ * changing (due to the resolution of file system time stamps).
+ */
+static const qint64 RacyInterval = 2000;
+
+static QDataStream& operator<<(QDataStream& strm, const ScanCache::Dir& dir)
+{
+	return strm << dir.mtime_ << dir.files_ << dir.dirs_ << dir.links_;
+}
+
+static QDataStream& operator>>(QDataStream& strm, ScanCache::Dir& dir)
+{
+	return strm >> dir.mtime_ >> dir.files_ >> dir.dirs_ >> dir.links_;
+}
+
+/**
+ * Class constructor.
+ */
+ScanCache::ScanCache() : scanTime_(0)
+{
+}
+
+/**
+ * Reads a cache file.
+ * @param  path  The path of the cache file
+ * @return true if successful, false otherwise (in which case the cache is
+ *         empty)
+ */
+bool ScanCache::load(const QString& path)
+{
+	dirMap_.clear();
+	resultMap_.clear();
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_4_5);
+
+	quint32 magic, version;
+	strm >> magic >> version;
+	if (magic != ScanCacheMagic || version != ScanCacheVersion)
+		return false;
+
+	strm >> dirMap_ >> resultMap_;
+	if (strm.status() != QDataStream::Ok) {
+		dirMap_.clear();
+		resultMap_.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Writes the cache to a file.
+ * The file is replaced atomically.
+ * @param  path  The path of the cache file
+ * @return true if successful, false otherwise
+ */
+bool ScanCache::save(const QString& path) const
+{
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_4_5);
+	strm << ScanCacheMagic << ScanCacheVersion << dirMap_ << resultMap_;
+
+	return file.commit();
+}
+
+/**
+ * Marks the beginning of a scan.
+ */
+void ScanCache::startScan()
+{
+	scanTime_ = QDateTime::currentMSecsSinceEpoch();
+}
+
+/**
+ * Looks up the recorded contents of a directory.
+ * This method can be called concurrently by multiple threads, as long as the
+ * cache is not modified.
+ * @param  path   The path of the directory, with a trailing '/'
+ * @param  mtime  The current modification time of the directory
+ * @return The recorded contents, NULL if the directory was not recorded or
+ *         modified since
+ */
+const ScanCache::Dir* ScanCache::find(const QString& path, qint64 mtime) const
+{
+	DirMap::ConstIterator itr = dirMap_.find(path);
+	if (itr == dirMap_.end() || (*itr).mtime_ == -1 || (*itr).mtime_ != mtime)
+		return NULL;
+
+	return &(*itr);
+}
+
+/**
+ * Records the directories read by a scan.
+ * In a recursive scan, directories under the root that were not seen by the
+ * scan no longer exist, and are removed from the cache.
+ * @param  dirMap     The directories read by the scan
+ * @param  root       The root directory of the scan, with a trailing '/'
+ * @param  recursive  Whether the scan was recursive
+ */
+void ScanCache::update(const DirMap& dirMap, const QString& root,
+                       bool recursive)
+{
+	if (recursive) {
+		DirMap::Iterator itr = dirMap_.begin();
+		while (itr != dirMap_.end()) {
+			if (itr.key().startsWith(root) && !dirMap.contains(itr.key()))
+				itr = dirMap_.erase(itr);
+			else
+				++itr;
+		}
+	}
+
+	DirMap::ConstIterator itr;
+	for (itr = dirMap.begin(); itr != dirMap.end(); ++itr) {
+		Dir& dir = dirMap_[itr.key()];
+		dir = *itr;
+
+		// Do not trust directories that may have been modified during the
+		// scan.
+		if (dir.mtime_ >= scanTime_ - RacyInterval)
+			dir.mtime_ = -1;
+	}
+}
+
+/**
+ * Records the files matched by a scan, and compares them with those matched by
+ * the previous scan with the same key.
+ * @param  key          Identifies the scan
+ * @param  fileList     The sorted list of files matched by the scan
+ * @param  addedList    Holds files not matched by the previous scan, upon
+ *                      return
+ * @param  removedList  Holds files matched by the previous scan but not by
+ *                      this one, upon return
+ */
+void ScanCache::updateResult(const QString& key, const QStringList& fileList,
+                             QStringList& addedList, QStringList& removedList)
+{
+	QStringList& oldList = resultMap_[key];
+
+	int i = 0, j = 0;
+	while (i < oldList.size() || j < fileList.size()) {
+		if (j == fileList.size()
+		    || (i < oldList.size() && oldList[i] < fileList[j])) {
+			removedList.append(oldList[i++]);
+		}
+		else if (i == oldList.size() || fileList[j] < oldList[i]) {
+			addedList.append(fileList[j++]);
+		}
+		else {
+			i++;
+			j++;
+		}
+	}
+
+	oldList = fileList;
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_SCANCACHE_H__
+#define __CORE_SCANCACHE_H__
+
+#include <QHash>
+#include <QStringList>
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Remembers the contents of scanned directories between scans.
+ * For each directory the cache holds its modification time and the names of
+ * its children. A directory whose modification time has not changed since it
+ * was recorded does not need to be read again, as entries cannot be added to
+ * or removed from it without updating the time.
+ * The cache also keeps the files matched by each scan (identified by its root
+ * directory and filter), so that a re-scan can report which files were added
+ * and which were removed.
+ * @author Elad Lahav
+ */
+class ScanCache
+{
+public:
+	/**
+	 * The recorded contents of a directory.
+	 */
+	struct Dir
+	{
+		/**
+		 * Modification time, in milliseconds since the epoch, -1 if the
+		 * contents cannot be trusted.
+		 */
+		qint64 mtime_;
+
+		/**
+		 * Names of files (including symbolic links to files).
+		 */
+		QStringList files_;
+
+		/**
+		 * Names of sub-directories.
+		 */
+		QStringList dirs_;
+
+		/**
+		 * Names of symbolic links to directories.
+		 */
+		QStringList links_;
+	};
+
+	typedef QHash<QString, Dir> DirMap;
+
+	ScanCache();
+
+	bool load(const QString&);
+	bool save(const QString&) const;
+	const Dir* find(const QString&, qint64) const;
+	void update(const DirMap&, const QString&, bool);
+	void updateResult(const QString&, const QStringList&, QStringList&,
+	                  QStringList&);
+
+	/**
+	 * @return The time at which the current scan started, in milliseconds
+	 *         since the epoch
+	 */
+	qint64 scanTime() const { return scanTime_; }
+
+	void startScan();
+
+private:
+	/**
+	 * Maps directory paths (with a trailing '/') to their recorded contents.
+	 */
+	DirMap dirMap_;
+
+	/**
+	 * Maps scan keys to the sorted lists of files matched by each scan.
+	 */
+	QHash<QString, QStringList> resultMap_;
+
+	/**
+	 * The time at which the current scan started.
+	 */
+	qint64 scanTime_;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_SCANCACHE_H__
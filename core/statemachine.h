@@ -49,17 +49,45 @@ public:
 	 * A single state in the machine.
 	 * The entire logic of the state machine is implemented in the list of
 	 * Transition objects held by each state.
+	 * In addition, each state keeps a table, indexed by character, of the
+	 * transitions that can match input beginning with that character. The
+	 * order of transitions in each entry follows that of the full list.
 	 */
 	struct State
 	{
-		State(QString name = "") : name_(name) {}
+		State(QString name = "") : name_(name), dispatch_(256) {}
 		State(const State& other) : name_(other.name_),
-			transList_(other.transList_) {}
+			transList_(other.transList_), dispatch_(other.dispatch_) {}
 
 		bool isError() const { return transList_.isEmpty(); }
 
+		/**
+		 * Adds a transition to the state.
+		 * @param  trans  The transition to add
+		 */
+		void addTransition(TransitionBase* trans) {
+			transList_.append(trans);
+
+			bool chars[256] = { false };
+			bool any = trans->firstChars(chars);
+			for (int i = 0; i < 256; i++) {
+				if (any || chars[i])
+					dispatch_[i].append(trans);
+			}
+		}
+
+		/**
+		 * @param  c  The next input character
+		 * @return The transitions that can match input beginning with the
+		 *         character
+		 */
+		const QList<TransitionBase*>& transitions(char c) const {
+			return dispatch_[(uchar)c];
+		}
+
 		QString name_;
 		QList<TransitionBase*> transList_;
+		QVector< QList<TransitionBase*> > dispatch_;
 	};
 
 	/**
@@ -83,7 +111,8 @@ public:
 	{
 		TransitionBase(const State& nextState) : nextState_(nextState) {}
 
-		virtual int matches(const QString& input, int pos) const = 0;
+		virtual int matches(const QByteArray& input, int pos) const = 0;
+		virtual bool firstChars(bool* chars) const = 0;
 
 		const State& nextState_;
 	};
@@ -107,11 +136,12 @@ public:
 		/**
 		 * Determines if a transition should be taken.
 		 * @param  input  The input to match against
+		 * @param  pos    The position of the first character to match
 		 * @return The number of characters matched by the parser if the input
 		 *         matches, -1 if a partial match was found, -2 on a parse
 		 *         error
 		 */
-		int matches(const QString& input, int pos) const {
+		int matches(const QByteArray& input, int pos) const {
 			SizedCapList<ParserT::capCount_> caps;
 			switch (parser_.match(input, pos, caps)) {
 			case NoMatch:
@@ -128,6 +158,16 @@ public:
 			return 0;
 		}
 
+		/**
+		 * Marks the characters that can begin input matching the transition.
+		 * @param  chars  A table of 256 entries, indexed by character
+		 * @return true if the input can begin with any character, false
+		 *         otherwise
+		 */
+		bool firstChars(bool* chars) const {
+			return parser_.firstChars(chars);
+		}
+
 		/**
 		 * The parser used to match input.
 		 */
@@ -154,28 +194,30 @@ public:
 
 	/**
 	 * Parses the given input using the state machine.
-	 * When the method returns, the input string is adjusted to contain only
-	 * the part of the input that was not parsed (in case of a partial parse
-	 * match).
+	 * Parsing starts at the given position, which is advanced past the
+	 * consumed input when the method returns. Any remaining input (in case of
+	 * a partial parse match) is left in place, so that the caller can append
+	 * more input to the same buffer without copying the unparsed part.
 	 * @param  input  The input to parse
+	 * @param  pos    The position of the first character to parse
 	 * @return true if parsing was successful, false otherwise
 	 */
-	bool parse(QString& input) {
+	bool parse(const QByteArray& input, int& pos) {
 		// Return immediately if in an error state.
 		if (curState_->isError()) {
 			qDebug() << "Error state!";
 			return false;
 		}
 
-		int pos = 0;
-		while (pos < input.length()) {
+		while (pos < input.size()) {
 			ParseResult result = NoMatch;
 
-			// Iterate over the list of transitions.
+			// Iterate over the transitions that can match input beginning with
+			// the next character.
+			const QList<TransitionBase*>& transList
+				= curState_->transitions(input[pos]);
 			QList<TransitionBase*>::ConstIterator itr;
-			for (itr = curState_->transList_.begin();
-				 itr != curState_->transList_.end();
-				 ++itr) {
+			for (itr = transList.begin(); itr != transList.end(); ++itr) {
 				// Match the input using the transition's parser.
 				int newPos = (*itr)->matches(input, pos);
 				if (newPos >= 0) {
@@ -209,7 +251,6 @@ public:
 		}
 
 		// Wait for more input.
-		input = input.mid(pos);
 		return true;
 	}
 
@@ -229,7 +270,7 @@ public:
 	             const ActionT& action) {
 		typedef Transition<ParserT, ActionT> TransT;
 		TransT* trans = new TransT(to, parser, action);
-		from.transList_.append(trans);
+		from.addTransition(trans);
 		transList_.append(trans);
 	}
 
@@ -237,7 +278,7 @@ public:
 	void addRule(State& from, const ParserT& parser, const State& to) {
 		typedef Transition<ParserT> TransT;
 		TransT* trans = new TransT(to, parser);
-		from.transList_.append(trans);
+		from.addTransition(trans);
 		transList_.append(trans);
 	}
 
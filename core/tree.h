@@ -0,0 +1,235 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_TREE_H__
+#define __CORE_TREE_H__
+
+#include <QVector>
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * A generic ordered tree structure, with all nodes kept in a single vector.
+ * Unlike TreeItem, which allocates each node separately, nodes are referenced
+ * by their position in the vector. Each node stores the position of its
+ * parent, its own row with respect to the parent, and an array of the
+ * positions of its children, so that moving in any direction in the tree takes
+ * constant time. The root node is always at position 0.
+ * Node positions remain valid until the node is removed. Positions of removed
+ * nodes are reused by later additions.
+ * @author  Elad Lahav
+ */
+template<typename DataT>
+class Tree
+{
+public:
+	/**
+	 * The position of the root node.
+	 */
+	static const int Root = 0;
+
+	/**
+	 * Class constructor.
+	 * Creates a tree with a root node only.
+	 * @param  data  The root's data
+	 */
+	Tree(const DataT& data = DataT()) : nodes_(1) {
+		nodes_[Root].data_ = data;
+	}
+
+	/**
+	 * Class destructor.
+	 */
+	~Tree() {}
+
+	/**
+	 * Data accessor.
+	 * @param  node  The node position
+	 * @return The node's data
+	 */
+	DataT& data(int node) { return nodes_[node].data_; }
+
+	/**
+	 * Data accessor (const version).
+	 * @param  node  The node position
+	 * @return The node's data
+	 */
+	const DataT& data(int node) const { return nodes_[node].data_; }
+
+	/**
+	 * Parent accessor.
+	 * @param  node  The node position
+	 * @return The position of the node's parent, -1 for the root
+	 */
+	int parent(int node) const { return nodes_[node].parent_; }
+
+	/**
+	 * Self-index accessor.
+	 * @param  node  The node position
+	 * @return The index of the node with respect to its parent
+	 */
+	int row(int node) const { return nodes_[node].row_; }
+
+	/**
+	 * Child-count accessor.
+	 * @param  node  The node position
+	 * @return The number of children of the node
+	 */
+	int childCount(int node) const { return nodes_[node].children_.size(); }
+
+	/**
+	 * Child accessor.
+	 * @param  node  The node position
+	 * @param  row   The ordinal number of the requested child
+	 * @return The position of the requested child, -1 if the row is out of
+	 *         bounds
+	 */
+	int child(int node, int row) const {
+		const QVector<int>& children = nodes_[node].children_;
+		if (row < 0 || row >= children.size())
+			return -1;
+
+		return children[row];
+	}
+
+	/**
+	 * Adds a child to a node.
+	 * @param  node  The parent's position
+	 * @param  data  The child's data
+	 * @return The position of the new child
+	 */
+	int addChild(int node, const DataT& data) {
+		int child;
+		if (!freeList_.isEmpty()) {
+			child = freeList_.last();
+			freeList_.removeLast();
+		}
+		else {
+			child = nodes_.size();
+			nodes_.resize(child + 1);
+		}
+
+		Node& childNode = nodes_[child];
+		childNode.data_ = data;
+		childNode.parent_ = node;
+		childNode.row_ = nodes_[node].children_.size();
+		nodes_[node].children_.append(child);
+		return child;
+	}
+
+	/**
+	 * Pre-allocates space for children that are about to be added to a node.
+	 * @param  node   The parent's position
+	 * @param  count  The number of children to be added
+	 */
+	void reserveChildren(int node, int count) {
+		QVector<int>& children = nodes_[node].children_;
+		children.reserve(children.size() + count);
+		nodes_.reserve(nodes_.size() - freeList_.size() + count);
+	}
+
+	/**
+	 * Locates a child node holding the given data.
+	 * @param  node  The parent's position
+	 * @param  data  Used for finding the node
+	 * @return The position of the found child, -1 if no such child exists
+	 */
+	int findChild(int node, const DataT& data) const {
+		const QVector<int>& children = nodes_[node].children_;
+		for (int i = 0; i < children.size(); i++) {
+			if (nodes_[children[i]].data_ == data)
+				return children[i];
+		}
+
+		return -1;
+	}
+
+	/**
+	 * Recursively removes all children of a node.
+	 * @param  node  The node position
+	 */
+	void clear(int node) {
+		QVector<int> children = nodes_[node].children_;
+		nodes_[node].children_.clear();
+
+		for (int i = 0; i < children.size(); i++) {
+			clear(children[i]);
+			nodes_[children[i]] = Node();
+			freeList_.append(children[i]);
+		}
+
+		// Release all memory if the tree is empty.
+		if (node == Root) {
+			nodes_.resize(1);
+			nodes_.squeeze();
+			freeList_.clear();
+			freeList_.squeeze();
+		}
+	}
+
+private:
+	/**
+	 * A single node in the tree.
+	 */
+	struct Node
+	{
+		Node() : parent_(-1), row_(0) {}
+
+		/**
+		 * Node's data.
+		 */
+		DataT data_;
+
+		/**
+		 * The position of the node's parent, -1 for the root.
+		 */
+		int parent_;
+
+		/**
+		 * The index of this node in its parent's list of children.
+		 */
+		int row_;
+
+		/**
+		 * The positions of the node's children.
+		 */
+		QVector<int> children_;
+	};
+
+	/**
+	 * All nodes in the tree.
+	 */
+	QVector<Node> nodes_;
+
+	/**
+	 * Positions of removed nodes, available for reuse.
+	 */
+	QVector<int> freeList_;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_TREE_H__
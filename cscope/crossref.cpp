@@ -19,7 +19,10 @@
  ***************************************************************************/
 
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QTextStream>
+#include <QVector>
 #include <core/exception.h>
 #include "crossref.h"
 #include "ctags.h"
@@ -30,12 +33,20 @@ namespace KScope
 namespace Cscope
 {
 
+bool Crossref::lineMode_ = true;
+bool Crossref::incrementalBuild_ = true;
+int Crossref::shards_ = 1;
+
 /**
  * Class constructor.
  * @param  parent  Parent object
  */
-Crossref::Crossref(QObject* parent) : Core::Engine(parent), status_(Unknown)
+Crossref::Crossref(QObject* parent) : Core::Engine(parent), status_(Unknown),
+	generation_(0), buildGeneration_(0), shardCount_(0), dbGeneration_(0),
+	updater_(NULL), buildConn_(NULL), hasPendingManifest_(false)
 {
+	scheduler_ = new Scheduler(this);
+	queryCache_ = new Core::QueryCache(this);
 }
 
 /**
@@ -53,6 +64,8 @@ Crossref::~Crossref()
  * is the project path (includes the cscope.out and cscope.files files),
  * followed by command-line arguments to Cscope (only the ones that apply to
  * building the database).
+ * If the database was built as a set of partial databases (see shards_), these
+ * are expected under the 'shards' sub-directory.
  * @param  initString  The initialisation string
  * @throw  Exception
  */
@@ -69,35 +82,66 @@ void Crossref::open(const QString& initString, Core::Callback<>* cb)
 	if (!dir.exists())
 		throw new Core::Exception("Database directory does not exist");
 
+	// Store the path, as it is used to locate the database files.
+	QString oldPath = path_;
+	path_ = path;
+
 	// Check if the cross-reference file exists.
 	// If not, the databsae needs to be built. Otherwise, it is ready for
 	// querying, but needs to be rebuilt.
+	// A database in a layout other than the configured one (single vs.
+	// partial databases) can be queried, but needs to be rebuilt.
 	// We also ensure that if it exists it is readable.
-	QFileInfo fi(dir, "cscope.out");
 	Status status;
-	if (!fi.exists())
-		status = Build;
-	else if (!fi.isReadable())
-		throw new Core::Exception("Cannot read the 'cscope.out' file");
-	else
+	if (databaseExists(layout())) {
 		status = Ready;
+		shardCount_ = layout();
+	}
+	else if (databaseExists(0)) {
+		status = Rebuild;
+		shardCount_ = 0;
+	}
+	else {
+		status = Build;
+		shardCount_ = 0;
+	}
+
+	if (status != Build && shardCount_ == 0) {
+		QFileInfo fi(dir, "cscope.out");
+		if (!fi.isReadable())
+			throw new Core::Exception("Cannot read the 'cscope.out' file");
+	}
 
 	// Handle reopening with different parameters (i.e., after a change to the
 	// project parameters).
-	if (status_ != Unknown) {
-		if ((path != path_) || args != args_)
+	if (status_ != Unknown && status != Build) {
+		if ((path != oldPath) || args != args_)
 			status = Rebuild;
 	}
 
 	// Store arguments for running Cscope.
-	path_ = path;
 	args_ = args;
 	status_ = status;
 
+	// Results of queries on the previous database are no longer valid.
+	dbGeneration_++;
+
 	if (cb)
 		cb->call();
 }
 
+/**
+ * Marks the database as out of date, following changes to source files.
+ * A build in progress does not reflect the changes either, so it completes
+ * with the database still requiring a rebuild.
+ */
+void Crossref::invalidate()
+{
+	generation_++;
+	if (status_ == Ready)
+		status_ = Rebuild;
+}
+
 /**
  * Builds a list of fields for each query type.
  * The list specifies the fields that carry useful information for the given
@@ -154,7 +198,11 @@ Crossref::queryFields(Core::Query::Type type) const
 
 /**
  * Starts a Cscope query.
- * Creates a new Cscope process to handle the query.
+ * If the database is made of several partial databases, the query is issued
+ * on each of them, and the results are merged.
+ * Results are cached until the database is rebuilt, so repeated queries do not
+ * require running Cscope. Text searches are not cached, as Cscope answers
+ * these by reading the source files, rather than the database.
  * @param  conn  Connection object to attach to the new process
  * @param  query Query information
  * @throw  Exception
@@ -212,18 +260,130 @@ void Crossref::query(Core::Engine::Connection* conn,
 		                          .arg(query.type_));
 	}
 
+	// Answer from the cache if possible, or collect the results for it.
+	if (query.type_ != Core::Query::Text) {
+		if (queryCache_->answer(conn, query, dbGeneration_))
+			return;
+
+		conn = queryCache_->collect(conn, query, dbGeneration_);
+	}
+
+	if (shardCount_ == 0) {
+		runQuery(conn, path_, type, query);
+		return;
+	}
+
+	// Query all partial databases.
+	// The object deletes itself once all partial queries have terminated.
+	ShardQuery* shardQuery = new ShardQuery(conn, shardCount_);
+	for (int i = 0; i < shardCount_; i++)
+		runQuery(shardQuery->part(i), shardPath(i), type, query);
+}
+
+/**
+ * Runs a query on a single database.
+ * In line mode, the query is handed to the scheduler, which runs it on one of
+ * a pool of persistent Cscope processes. Queries flagged as Background are
+ * only run when no other queries are waiting. Otherwise, a new Cscope process
+ * is created to handle the query.
+ * @param  conn  Connection object to attach to the new process
+ * @param  path  The directory holding the database
+ * @param  type  The Cscope query type
+ * @param  query Query information
+ */
+void Crossref::runQuery(Core::Engine::Connection* conn, const QString& path,
+                        Cscope::QueryType type, const Core::Query& query) const
+{
+	// Queue the query for the line-mode workers.
+	if (lineMode_) {
+		Scheduler::Priority priority
+			= (query.flags_ & Core::Query::Background)
+			  ? Scheduler::Background : Scheduler::Interactive;
+		scheduler_->query(conn, path, type, query.pattern_, priority);
+		return;
+	}
+
 	// Create a new Cscope process object, and start the query.
 	Cscope* cscope = new Cscope();
 	cscope->setDeleteOnExit();
-	cscope->query(conn, path_, type, query.pattern_);
+	cscope->query(conn, path, type, query.pattern_);
+}
+
+/**
+ * Starts a build of the cross-reference database.
+ * In incremental mode, the source files are first compared with the manifest
+ * stored after the last successful build. The database is only rebuilt if
+ * files were added, removed or modified, or if the build arguments changed.
+ * @param  conn  Connection object to attach to the build operation
+ * @throw  Exception
+ */
+void Crossref::build(Core::Engine::Connection* conn) const
+{
+	if (updater_ != NULL)
+		throw new Core::Exception("A build is already in progress");
+
+	buildGeneration_ = generation_;
+
+	if (!incrementalBuild_) {
+		// The manifest no longer describes the database.
+		QFile::remove(ManifestUpdater::manifestPath(path_));
+		hasPendingManifest_ = false;
+		startBuild(conn, args_);
+		return;
+	}
+
+	// Compare the source files with the manifest in a separate thread.
+	updater_ = new ManifestUpdater(path_, args_, const_cast<Crossref*>(this));
+	buildConn_ = conn;
+	buildConn_->setCtrlObject(updater_);
+	connect(updater_, SIGNAL(progress(uint, uint)), this,
+	        SLOT(manifestProgress(uint, uint)));
+	connect(updater_, SIGNAL(finished()), this, SLOT(manifestUpdated()));
+	updater_->start();
+}
+
+/**
+ * @param  shard  The shard number
+ * @return The directory holding the given partial database
+ */
+QString Crossref::shardPath(int shard) const
+{
+	return QString("%1/shards/%2").arg(path_).arg(shard);
+}
+
+/**
+ * Checks whether a database in the given layout exists.
+ * @param  shards  The number of partial databases, 0 for a single database
+ * @return true if all database files exist, false otherwise
+ */
+bool Crossref::databaseExists(int shards) const
+{
+	if (shards == 0)
+		return QFileInfo(QDir(path_), "cscope.out").exists();
+
+	for (int i = 0; i < shards; i++) {
+		if (!QFileInfo(QDir(shardPath(i)), "cscope.out").exists())
+			return false;
+	}
+
+	return true;
 }
 
 /**
  * Starts a Cscope build process.
+ * If the engine is configured to build partial databases, one process is
+ * started for each.
  * @param  conn  Connection object to attach to the new process
+ * @param  args  Command-line arguments for building the database
  */
-void Crossref::build(Core::Engine::Connection* conn) const
+void Crossref::startBuild(Core::Engine::Connection* conn,
+                          const QStringList& args) const
 {
+	if (layout() > 0) {
+		buildShards(conn, args);
+		return;
+	}
+
 	// Create the Cscope process object.
 	Cscope* cscope = new Cscope();
 	cscope->setDeleteOnExit();
@@ -233,13 +393,184 @@ void Crossref::build(Core::Engine::Connection* conn) const
 	        SLOT(buildProcessFinished(int, QProcess::ExitStatus)));
 
 	// Start the build process.
-	cscope->build(conn, path_, args_);
+	cscope->build(conn, path_, args);
 }
 
+/**
+ * Builds a set of partial databases in parallel.
+ * The project's file list is divided among the shards by a hash of each file
+ * name. The division is stable, so that a file is assigned to the same shard
+ * on every build, allowing Cscope to reuse the entries of unmodified files.
+ * @param  conn  Connection object to attach to the build operation
+ * @param  args  Command-line arguments for building the databases
+ * @throw  Exception
+ */
+void Crossref::buildShards(Core::Engine::Connection* conn,
+                           const QStringList& args) const
+{
+	int shards = layout();
+
+	// Read the project's file list.
+	QFile listFile(QDir(path_).filePath("cscope.files"));
+	if (!listFile.open(QIODevice::ReadOnly | QIODevice::Text))
+		throw new Core::Exception("Cannot read the 'cscope.files' file");
+
+	QVector<QStringList> fileLists(shards);
+	QDir dir(path_);
+	QTextStream in(&listFile);
+	QString line;
+	while (!(line = in.readLine()).isNull()) {
+		line = line.trimmed();
+		if (line.isEmpty())
+			continue;
+
+		// Cscope is run in the shard's directory, so relative paths need to
+		// be resolved against the project directory.
+		QString file = dir.absoluteFilePath(line);
+		fileLists[qHash(file) % shards].append(file);
+	}
+
+	// Write the file list of each shard.
+	QStringList pathList;
+	for (int i = 0; i < shards; i++) {
+		QString path = shardPath(i);
+		if (!QDir().mkpath(path))
+			throw new Core::Exception("Cannot create the shard directory");
+
+		QFile shardFile(QDir(path).filePath("cscope.files"));
+		if (!shardFile.open(QIODevice::WriteOnly | QIODevice::Truncate
+		                    | QIODevice::Text)) {
+			throw new Core::Exception("Cannot write a shard's file list");
+		}
+
+		QTextStream out(&shardFile);
+		foreach (QString file, fileLists[i])
+			out << file << "\n";
+
+		pathList << path;
+	}
+
+	// Start the build processes.
+	// The object deletes itself once all processes have terminated.
+	ShardBuild* build = new ShardBuild(conn, const_cast<Crossref*>(this));
+	connect(build, SIGNAL(finished(bool)), this,
+	        SLOT(shardBuildFinished(bool)));
+	build->start(pathList, args);
+}
+
+/**
+ * Reports the progress of the manifest comparison.
+ * @param  cur    The number of files checked so far
+ * @param  total  The number of files to check
+ */
+void Crossref::manifestProgress(uint cur, uint total)
+{
+	if (buildConn_)
+		buildConn_->onProgress(tr("Checking for modified files..."), cur,
+		                       total);
+}
+
+/**
+ * Called when the manifest comparison thread terminates.
+ * Either completes the build, if the database is up to date, or starts a
+ * Cscope build process. Cscope reuses the entries of unmodified files from the
+ * existing cscope.out file, unless the build arguments changed, in which case
+ * an unconditional build (-u) is requested.
+ */
+void Crossref::manifestUpdated()
+{
+	ManifestUpdater* updater = updater_;
+	Core::Engine::Connection* conn = buildConn_;
+	updater_ = NULL;
+	buildConn_ = NULL;
+	updater->deleteLater();
+
+	if (conn == NULL)
+		return;
+
+	conn->setCtrlObject(NULL);
+
+	if (updater->isCancelled()) {
+		conn->onAborted();
+		return;
+	}
+
+	// Nothing to do if the database exists, and no source file changed.
+	// The manifest is still stored, to record the new time stamps of files
+	// that were touched without being modified.
+	if (databaseExists(layout()) && !updater->hasChanges()) {
+		qDebug() << "Cross-reference database is up to date";
+		updater->manifest().save(ManifestUpdater::manifestPath(path_));
+		status_ = (buildGeneration_ == generation_) ? Ready : Rebuild;
+		shardCount_ = layout();
+		conn->onFinished();
+		return;
+	}
+
+	qDebug() << "Rebuilding:" << updater->added().size() << "added,"
+	         << updater->removed().size() << "removed,"
+	         << updater->changed().size() << "modified";
+
+	pendingManifest_ = updater->manifest();
+	hasPendingManifest_ = true;
+
+	QStringList args = args_;
+	if (updater->argsChanged())
+		args << "-u";
+
+	startBuild(conn, args);
+}
+
+/**
+ * Called when a build process terminates.
+ * Updates the status of the database, stores the manifest describing the
+ * files used for the build, and restarts the line-mode workers, so that they
+ * load the new cross-reference file.
+ * @param  code    The exit code of the process
+ * @param  status  Used to indicate process crashes
+ */
 void Crossref::buildProcessFinished(int code, QProcess::ExitStatus status)
 {
 	if ((code == 0) && (status == QProcess::NormalExit))
-		status_ = Ready;
+		buildSucceeded(0);
+
+	hasPendingManifest_ = false;
+	pendingManifest_ = Manifest();
+}
+
+/**
+ * Called when the build of a set of partial databases terminates.
+ * @param  success  true if all partial databases were built, false otherwise
+ */
+void Crossref::shardBuildFinished(bool success)
+{
+	if (success)
+		buildSucceeded(layout());
+
+	hasPendingManifest_ = false;
+	pendingManifest_ = Manifest();
+}
+
+/**
+ * Updates the state of the engine after a successful build.
+ * @param  shards  The number of partial databases built, 0 for a single
+ *                 database
+ */
+void Crossref::buildSucceeded(int shards)
+{
+	status_ = (buildGeneration_ == generation_) ? Ready : Rebuild;
+	shardCount_ = shards;
+	dbGeneration_++;
+	if (hasPendingManifest_)
+		pendingManifest_.save(ManifestUpdater::manifestPath(path_));
+
+	QStringList pathList;
+	if (shardCount_ == 0)
+		pathList << path_;
+	for (int i = 0; i < shardCount_; i++)
+		pathList << shardPath(i);
+
+	scheduler_->restart(pathList);
 }
 
 } // namespace Cscope
@@ -21,7 +21,11 @@
 #ifndef __CSCOPE_CROSSREF_H__
 #define __CSCOPE_CROSSREF_H__
 
+#include <core/querycache.h>
 #include "cscope.h"
+#include "scheduler.h"
+#include "manifest.h"
+#include "shards.h"
 #include "ctags.h"
 #include "engineconfigwidget.h"
 
@@ -55,14 +59,39 @@ public:
 	 */
 	Status status() const { return status_; }
 
+	void invalidate();
+
 	QList<Core::Location::Fields> queryFields(Core::Query::Type) const;
 
+	/**
+	 * @return The cache of query results (e.g., for hit statistics)
+	 */
+	const Core::QueryCache& queryCache() const { return *queryCache_; }
+
 public slots:
 	void query(Core::Engine::Connection*, const Core::Query&) const;
 	void build(Core::Engine::Connection*) const;
 
 	const QString& path() { return path_; }
 
+	/**
+	 * Whether queries are handled by a persistent, line-mode Cscope process
+	 * (true), or by a new process per query (false).
+	 */
+	static bool lineMode_;
+
+	/**
+	 * Whether a build is preceded by a check for modified source files, so
+	 * that the database is only rebuilt when needed.
+	 */
+	static bool incrementalBuild_;
+
+	/**
+	 * The number of partial databases built in parallel, each from a subset
+	 * of the source files. A value of 1 builds a single cscope.out file.
+	 */
+	static int shards_;
+
 private:
 	/**
 	 * The path of the directory containing the cscope.out file.
@@ -79,8 +108,79 @@ private:
 	 */
 	Status status_;
 
+	/**
+	 * Incremented whenever source files are modified.
+	 */
+	uint generation_;
+
+	/**
+	 * The value of generation_ when the current build started.
+	 * A build started before files were modified does not make the database
+	 * up-to-date.
+	 */
+	mutable uint buildGeneration_;
+
+	/**
+	 * The number of partial databases making up the current database, or 0
+	 * if it is stored in a single cscope.out file.
+	 */
+	mutable int shardCount_;
+
+	/**
+	 * Distributes queries among line-mode Cscope processes.
+	 */
+	Scheduler* scheduler_;
+
+	/**
+	 * Results of recent queries.
+	 */
+	Core::QueryCache* queryCache_;
+
+	/**
+	 * Incremented whenever the database changes, to invalidate cached query
+	 * results.
+	 */
+	uint dbGeneration_;
+
+	/**
+	 * Compares the source files with the manifest, before a build.
+	 */
+	mutable ManifestUpdater* updater_;
+
+	/**
+	 * The connection for the build waiting on the manifest comparison.
+	 */
+	mutable Core::Engine::Connection* buildConn_;
+
+	/**
+	 * The manifest to store once the current build completes successfully.
+	 */
+	mutable Manifest pendingManifest_;
+
+	/**
+	 * Whether pendingManifest_ should be stored when the build completes.
+	 */
+	mutable bool hasPendingManifest_;
+
+	/**
+	 * @return The number of shards used by new builds, 0 for a single
+	 *         database
+	 */
+	static int layout() { return shards_ > 1 ? shards_ : 0; }
+
+	QString shardPath(int) const;
+	bool databaseExists(int) const;
+	void startBuild(Core::Engine::Connection*, const QStringList&) const;
+	void buildShards(Core::Engine::Connection*, const QStringList&) const;
+	void buildSucceeded(int);
+	void runQuery(Core::Engine::Connection*, const QString&, Cscope::QueryType,
+	              const Core::Query&) const;
+
 private slots:
+	void manifestProgress(uint, uint);
+	void manifestUpdated();
 	void buildProcessFinished(int, QProcess::ExitStatus);
+	void shardBuildFinished(bool);
 };
 
 } // namespace Cscope
@@ -99,6 +199,10 @@ struct EngineConfig<Cscope::Crossref>
 	static void getConfig(KeyValuePairs& confParams) {
 		confParams["CscopePath"] = Cscope::Cscope::execPath_;
 		confParams["CtagsPath"] = Cscope::Ctags::execPath_;
+		confParams["LineModeQueries"] = Cscope::Crossref::lineMode_;
+		confParams["QueryWorkers"] = Cscope::Scheduler::maxWorkers_;
+		confParams["IncrementalBuild"] = Cscope::Crossref::incrementalBuild_;
+		confParams["BuildShards"] = Cscope::Crossref::shards_;
 	}
 
 	static void setConfig(const KeyValuePairs& confParams) {
@@ -109,6 +213,24 @@ struct EngineConfig<Cscope::Crossref>
 		QString ctagsPath = confParams["CtagsPath"].toString();
 		if (!ctagsPath.isEmpty())
 			Cscope::Ctags::execPath_ = ctagsPath;
+
+		if (confParams.contains("LineModeQueries")) {
+			Cscope::Crossref::lineMode_
+				= confParams["LineModeQueries"].toBool();
+		}
+
+		if (confParams.contains("IncrementalBuild")) {
+			Cscope::Crossref::incrementalBuild_
+				= confParams["IncrementalBuild"].toBool();
+		}
+
+		int workers = confParams["QueryWorkers"].toInt();
+		if (workers > 0)
+			Cscope::Scheduler::maxWorkers_ = workers;
+
+		int shards = confParams["BuildShards"].toInt();
+		if (shards > 0)
+			Cscope::Crossref::shards_ = shards;
 	}
 
 	static QWidget* createConfigWidget(QWidget* parent) {
@@ -117,6 +239,11 @@ struct EngineConfig<Cscope::Crossref>
 		qDebug() << Cscope::Cscope::execPath_ << Cscope::Ctags::execPath_;
 		widget->cscopePathEdit_->setText(Cscope::Cscope::execPath_);
 		widget->ctagsPathEdit_->setText(Cscope::Ctags::execPath_);
+		widget->lineModeCheck_->setChecked(Cscope::Crossref::lineMode_);
+		widget->workersSpin_->setValue(Cscope::Scheduler::maxWorkers_);
+		widget->incrementalCheck_->setChecked(
+			Cscope::Crossref::incrementalBuild_);
+		widget->shardsSpin_->setValue(Cscope::Crossref::shards_);
 		return widget;
 	}
 
@@ -128,6 +255,10 @@ struct EngineConfig<Cscope::Crossref>
 
 		Cscope::Cscope::execPath_ = configWidget->cscopePath();
 		Cscope::Ctags::execPath_ = configWidget->ctagsPath();
+		Cscope::Crossref::lineMode_ = configWidget->lineMode();
+		Cscope::Scheduler::maxWorkers_ = configWidget->workers();
+		Cscope::Crossref::incrementalBuild_ = configWidget->incremental();
+		Cscope::Crossref::shards_ = configWidget->shards();
 	}
 };
 
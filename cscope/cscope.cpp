@@ -120,6 +120,7 @@ void Cscope::query(Core::Engine::Connection* conn, const QString& path,
 	conn_->setCtrlObject(this);
 	setState(queryProgState_);
 	locList_.clear();
+	batchTimer_.invalidate();
 	type_ = type;
 
 	// Start the process.
@@ -160,6 +161,49 @@ void Cscope::build(Core::Engine::Connection* conn, const QString& path,
 	start(prog, args);
 }
 
+/**
+ * Delivers parsed results while the process is still running.
+ * The first results of a query are delivered as soon as they are parsed, so
+ * that they can be displayed immediately. Later results are delivered in
+ * batches, bounded both by size and by time, to avoid updating the view on
+ * every chunk of output.
+ */
+void Cscope::outputParsed()
+{
+	if (conn_ == NULL || locList_.isEmpty())
+		return;
+
+	if (batchTimer_.isValid() && locList_.size() < BatchSize
+	    && batchTimer_.elapsed() < BatchInterval) {
+		return;
+	}
+
+	Core::CompactLocationList locList;
+	locList.swap(locList_);
+	batchTimer_.start();
+	conn_->onDataReady(locList);
+}
+
+/**
+ * Stops a query/build process.
+ * The connection object is detached and notified before this method returns,
+ * as it may be deleted by the caller once the operation is stopped. The
+ * process itself terminates asynchronously.
+ */
+void Cscope::stop()
+{
+	if (conn_ == NULL)
+		return;
+
+	Core::Engine::Connection* conn = conn_;
+	conn_ = NULL;
+	locList_.clear();
+	kill();
+
+	conn->setCtrlObject(NULL);
+	conn->onAborted();
+}
+
 /**
  * Called when the process terminates.
  * @param  code    The exit code of the process
@@ -169,16 +213,23 @@ void Cscope::handleFinished(int code, QProcess::ExitStatus status)
 {
 	Process::handleFinished(code, status);
 
-	// Hand over data to the other side of the connection.
-	if (!locList_.isEmpty())
-		conn_->onDataReady(locList_);
-
-	// Signal normal termination.
-	conn_->onFinished();
+	// Nothing to report if the operation was stopped.
+	if (conn_ == NULL)
+		return;
 
 	// Detach from the connection object.
+	// This is done first, so that the other side of the connection sees no
+	// running operation when notified.
+	Core::Engine::Connection* conn = conn_;
 	conn_->setCtrlObject(NULL);
 	conn_ = NULL;
+
+	// Hand over data to the other side of the connection.
+	if (!locList_.isEmpty())
+		conn->onDataReady(locList_);
+
+	// Signal normal termination.
+	conn->onFinished();
 }
 
 } // namespace Cscope
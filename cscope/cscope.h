@@ -21,6 +21,7 @@
 #ifndef __CSCOPE_CSCOPE_H__
 #define __CSCOPE_CSCOPE_H__
 
+#include <QElapsedTimer>
 #include <core/process.h>
 #include <core/globals.h>
 #include <core/engine.h>
@@ -64,17 +65,28 @@ public:
 	           const QString&);
 	void build(Core::Engine::Connection*, const QString&, const QStringList&);
 
+	virtual void stop();
+
+	static QString execPath_;
+
 	/**
-	 * Stops a query/build process.
+	 * The maximal number of parsed results held back before they are delivered
+	 * to the connection object.
 	 */
-	virtual void stop() { kill(); }
+	static const int BatchSize = 1000;
 
-	static QString execPath_;
+	/**
+	 * The maximal time, in milliseconds, parsed results are held back before
+	 * they are delivered to the connection object.
+	 */
+	static const int BatchInterval = 100;
 
 protected slots:
 	virtual void handleFinished(int, QProcess::ExitStatus);
 
-private:
+protected:
+	virtual void outputParsed();
+
 	/**
 	 * The current connection object, used to communicate progress and result
 	 * information.
@@ -114,9 +126,16 @@ private:
 
 	/**
 	 * List of locations.
-	 * The list is constructed when result lines are parsed.
+	 * The list is constructed when result lines are parsed, and handed over to
+	 * the connection object in batches.
+	 */
+	Core::CompactLocationList locList_;
+
+	/**
+	 * Measures the time since the last batch of results was delivered.
+	 * Invalid until the first batch of a query is delivered.
 	 */
-	Core::LocationList locList_;
+	QElapsedTimer batchTimer_;
 
 	/**
 	 * The type of the current query.
@@ -11,6 +11,11 @@ HEADERS += engineconfigwidget.h \
     managedproject.h \
     crossref.h \
     cscope.h \
+    worker.h \
+    scheduler.h \
+    manifest.h \
+    shards.h \
+    filelist.h \
     files.h
 FORMS += configwidget.ui \
     engineconfigwidget.ui
@@ -20,6 +25,11 @@ SOURCES += engineconfigwidget.cpp \
     managedproject.cpp \
     crossref.cpp \
     cscope.cpp \
+    worker.cpp \
+    scheduler.cpp \
+    manifest.cpp \
+    shards.cpp \
+    filelist.cpp \
     files.cpp
 INCLUDEPATH += .. \
     .
@@ -42,7 +42,8 @@ Ctags::Ctags() : Process(), conn_(NULL)
 	                    << Parser::Literal("\t")
 	                    << Parser::Number()
 	                    << Parser::Literal(";\"\t")
-	                    << Parser::String<QRegExp>(QRegExp("[\t\n]")),
+	                    << Parser::String<Parser::CharSet>(
+	                        Parser::CharSet("\t\n")),
 	        attrListState_, ParseAction(*this));
 
 	// Attribute lists:
@@ -50,7 +51,8 @@ Ctags::Ctags() : Process(), conn_(NULL)
 	addRule(attrListState_, Parser::Literal("\t")
 	                        << Parser::String<>(':')
 	                        << Parser::Literal(":")
-	                        << Parser::String<QRegExp, true>(QRegExp("[\t\n]")),
+	                        << Parser::String<Parser::CharSet, true>(
+	                            Parser::CharSet("\t\n")),
 	        attrListState_, ParseAttributeAction(*this));
 	addRule(attrListState_, Parser::Literal("\n"),
 	        initState_);
@@ -96,16 +98,19 @@ void Ctags::handleFinished(int code, QProcess::ExitStatus status)
 {
 	Process::handleFinished(code, status);
 
+	// Detach from the connection object.
+	// This is done first, so that the other side of the connection sees no
+	// running operation when notified.
+	Core::Engine::Connection* conn = conn_;
+	conn_->setCtrlObject(NULL);
+	conn_ = NULL;
+
 	// Hand over data to the other side of the connection.
 	if (!locList_.isEmpty())
-		conn_->onDataReady(locList_);
+		conn->onDataReady(locList_);
 
 	// Signal normal termination.
-	conn_->onFinished();
-
-	// Detach from the connection object.
-	conn_->setCtrlObject(NULL);
-	conn_ = NULL;
+	conn->onFinished();
 }
 
 } // namespace Cscope
@@ -68,7 +68,7 @@ private:
 	 * List of locations.
 	 * The list is constructed when result lines are parsed.
 	 */
-	Core::LocationList locList_;
+	Core::CompactLocationList locList_;
 
 	/**
 	 * State for parsing the single-character tag type.
@@ -105,7 +105,7 @@ private:
 			loc.column_ = 0;
 
 			// Translate a Ctags type character into a tag type value.
-			switch (capList[3].toString().at(0).toLatin1()) {
+			switch (capList[3].first()) {
 			case 'v':
 				loc.tag_.type_ = Core::Tag::Variable;
 				break;
@@ -172,20 +172,18 @@ private:
 		 * @param  capList  List of captured strings
 		 */
 		void operator()(const Parser::CapList& capList) const {
-			Core::Location& loc = self_.locList_.last();
-
 			for (int i = 0; i < capList.size(); i++) {
 				// Get the attribute name.
-				QString attr = capList[i++].toString();
+				const Parser::Capture& attr = capList[i++];
 				if (capList.size() == i)
 					break;
 
-				// Get the attribute value.
-				QString val = capList[i].toString();
-				if ((attr == "struct")
-				    || (attr == "union")
-				    || (attr == "enum")) {
-					loc.tag_.scope_ = val;
+				// Only decode the value of interesting attributes.
+				if (attr.equals("struct")
+				    || attr.equals("union")
+				    || attr.equals("enum")) {
+					self_.locList_.setScope(self_.locList_.size() - 1,
+					                        capList[i].toString());
 				}
 			}
 		}
@@ -39,6 +39,10 @@ public:
 
 	QString cscopePath() { return cscopePathEdit_->text(); }
 	QString ctagsPath() { return ctagsPathEdit_->text(); }
+	bool lineMode() { return lineModeCheck_->isChecked(); }
+	int workers() { return workersSpin_->value(); }
+	bool incremental() { return incrementalCheck_->isChecked(); }
+	int shards() { return shardsSpin_->value(); }
 };
 
 } // namespace Cscope
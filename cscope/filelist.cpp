@@ -0,0 +1,469 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QMap>
+#include <QtEndian>
+#include <QDebug>
+#include <core/exception.h>
+#include "filelist.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Identifies file list files.
+ */
+static const quint32 FileListMagic = 0x4b53464c;
+
+/**
+ * Incremented whenever the file list format changes.
+ */
+static const quint32 FileListVersion = 1;
+
+/**
+ * The header holds the magic number, the version, the number of paths in the
+ * table and the size of the table, in bytes.
+ */
+static const int HeaderSize = 16;
+
+/**
+ * Delta record types.
+ */
+static const char AddRecord = '+';
+static const char RemoveRecord = '-';
+
+/**
+ * Sets the modification time of a file to that of another file.
+ * Used to mark the list and its text version as describing the same files, so
+ * that only later changes to either one make it newer than the other.
+ * @param  path     The file to modify
+ * @param  refPath  The file whose modification time is copied
+ */
+static void matchTime(const QString& path, const QString& refPath)
+{
+	QDateTime mtime = QFileInfo(refPath).lastModified();
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append)
+	    || !file.setFileTime(mtime, QFileDevice::FileModificationTime)) {
+		qDebug() << "Failed to set the modification time of" << path;
+	}
+}
+
+/**
+ * The layout of a file list, as described by its header.
+ */
+struct Layout
+{
+	/**
+	 * The number of paths in the table.
+	 */
+	quint32 count_;
+
+	/**
+	 * The offset of the first delta record.
+	 */
+	qint64 tableEnd_;
+
+	/**
+	 * The size of the file.
+	 */
+	qint64 size_;
+
+	/**
+	 * Whether all delta records were read successfully.
+	 */
+	bool complete_;
+};
+
+/**
+ * Maps each path in the delta records to true if it was added, false if it
+ * was removed. Later records override earlier ones.
+ */
+typedef QMap<QString, bool> DeltaMap;
+
+static inline quint32 readWord(const uchar* pos)
+{
+	return qFromLittleEndian<quint32>(pos);
+}
+
+static inline void appendWord(QByteArray& buf, quint32 val)
+{
+	uchar data[4];
+	qToLittleEndian<quint32>(val, data);
+	buf.append((const char*)data, 4);
+}
+
+static inline void appendPath(QByteArray& buf, const QString& path)
+{
+	QByteArray utf8 = path.toUtf8();
+	appendWord(buf, utf8.size());
+	buf.append(utf8);
+}
+
+/**
+ * Decodes a length-prefixed path.
+ * @param  pos   The position of the path, advanced past it on success
+ * @param  end   The end of the buffer
+ * @param  path  Holds the path, upon successful return
+ * @return true if successful, false if the buffer is too short
+ */
+static bool nextPath(const uchar*& pos, const uchar* end, QString& path)
+{
+	if (end - pos < 4)
+		return false;
+
+	quint32 len = readWord(pos);
+	if ((quint32)(end - pos - 4) < len)
+		return false;
+
+	path = QString::fromUtf8((const char*)pos + 4, len);
+	pos += 4 + len;
+	return true;
+}
+
+/**
+ * Reads the header of a file list.
+ * @param  file  An open file
+ * @param  lay   Holds the layout, upon successful return
+ * @return true if successful, false if the file is not a valid file list
+ */
+static bool readLayout(QFile& file, Layout& lay)
+{
+	uchar header[HeaderSize];
+	if (file.read((char*)header, HeaderSize) != HeaderSize)
+		return false;
+
+	if (readWord(header) != FileListMagic
+	    || readWord(header + 4) != FileListVersion) {
+		return false;
+	}
+
+	lay.count_ = readWord(header + 8);
+	lay.tableEnd_ = HeaderSize + (qint64)readWord(header + 12);
+	lay.size_ = file.size();
+	lay.complete_ = true;
+	return lay.tableEnd_ <= lay.size_;
+}
+
+/**
+ * Enumerates the paths in a file list.
+ * The table is merged with the delta records, so that paths are reported in
+ * sorted order.
+ * @param  path  The path of the file list
+ * @param  cb    Called for each path
+ * @param  lay   Holds the layout of the file, upon successful return
+ * @return true if successful, false if the file could not be read
+ */
+static bool readList(const QString& path, Core::Callback<const QString&>& cb,
+                     Layout& lay)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly) || !readLayout(file, lay))
+		return false;
+
+	uchar* base = file.map(0, lay.size_);
+	if (base == NULL)
+		return false;
+
+	// Collect the delta records.
+	// A truncated record (left behind by an interrupted update) ends the list.
+	const uchar* pos = base + lay.tableEnd_;
+	const uchar* end = base + lay.size_;
+	DeltaMap deltas;
+	QString name;
+	while (pos < end) {
+		char type = (char)*pos++;
+		if ((type != AddRecord && type != RemoveRecord)
+		    || !nextPath(pos, end, name)) {
+			lay.complete_ = false;
+			break;
+		}
+
+		deltas[name] = (type == AddRecord);
+	}
+
+	// Merge the table with the deltas.
+	DeltaMap::ConstIterator delta = deltas.begin();
+	pos = base + HeaderSize;
+	end = base + lay.tableEnd_;
+	while (nextPath(pos, end, name)) {
+		for (; delta != deltas.end() && delta.key() < name; ++delta) {
+			if (delta.value())
+				cb.call(delta.key());
+		}
+
+		if (delta != deltas.end() && delta.key() == name) {
+			bool keep = delta.value();
+			++delta;
+			if (!keep)
+				continue;
+		}
+
+		cb.call(name);
+	}
+
+	for (; delta != deltas.end(); ++delta) {
+		if (delta.value())
+			cb.call(delta.key());
+	}
+
+	file.unmap(base);
+	return true;
+}
+
+/**
+ * Appends paths to a string list.
+ */
+struct AppendCallback : public Core::Callback<const QString&>
+{
+	QStringList& list_;
+
+	AppendCallback(QStringList& list) : list_(list) {}
+
+	void call(const QString& path) {
+		list_.append(path);
+	}
+};
+
+/**
+ * Appends paths, one per line, to a buffer in the format expected by Cscope.
+ */
+struct ExportCallback : public Core::Callback<const QString&>
+{
+	QByteArray& buf_;
+
+	ExportCallback(QByteArray& buf) : buf_(buf) {}
+
+	void call(const QString& path) {
+		buf_ += QFile::encodeName(path);
+		buf_ += '\n';
+	}
+};
+
+/**
+ * @return true if the file exists and has a valid header, false otherwise
+ */
+bool FileList::isValid() const
+{
+	QFile file(path_);
+	Layout lay;
+	return file.open(QIODevice::ReadOnly) && readLayout(file, lay);
+}
+
+/**
+ * @return true if the list has no paths (or cannot be read), false otherwise
+ */
+bool FileList::isEmpty() const
+{
+	QFile file(path_);
+	Layout lay;
+	if (!file.open(QIODevice::ReadOnly) || !readLayout(file, lay))
+		return true;
+
+	if (lay.tableEnd_ == lay.size_)
+		return lay.count_ == 0;
+
+	// Delta records can add or remove paths, so the list needs to be read.
+	QStringList list;
+	read(list);
+	return list.isEmpty();
+}
+
+/**
+ * Enumerates the paths in the list, in sorted order.
+ * @param  cb  Called for each path
+ * @return true if successful, false otherwise
+ */
+bool FileList::read(Core::Callback<const QString&>& cb) const
+{
+	Layout lay;
+	return readList(path_, cb, lay);
+}
+
+/**
+ * Reads all paths in the list.
+ * @param  fileList  The list object to fill
+ * @return true if successful, false otherwise
+ */
+bool FileList::read(QStringList& fileList) const
+{
+	AppendCallback cb(fileList);
+	return read(cb);
+}
+
+/**
+ * Replaces the contents of the file list.
+ * The file is replaced atomically, so that an interrupted write does not
+ * leave a corrupt list behind.
+ * @param  fileList  A sorted list of paths, without duplicates
+ * @throw  Exception
+ */
+void FileList::write(const QStringList& fileList) const
+{
+	QByteArray buf;
+	appendWord(buf, FileListMagic);
+	appendWord(buf, FileListVersion);
+	appendWord(buf, fileList.size());
+	appendWord(buf, 0);
+
+	QStringList::ConstIterator itr;
+	for (itr = fileList.begin(); itr != fileList.end(); ++itr)
+		appendPath(buf, *itr);
+
+	// Now that the size of the table is known, store it in the header.
+	qToLittleEndian<quint32>(buf.size() - HeaderSize,
+	                         (uchar*)buf.data() + 12);
+
+	QSaveFile file(path_);
+	if (!file.open(QIODevice::WriteOnly) || file.write(buf) != buf.size()
+	    || !file.commit()) {
+		throw new Core::Exception("Failed to write the file list");
+	}
+}
+
+/**
+ * Changes the contents of the file list.
+ * The differences between the current and the new lists are appended as
+ * delta records. The whole file is rewritten instead if it cannot be read,
+ * or if the deltas grow beyond a quarter of the size of the table.
+ * @param  fileList  A sorted list of paths, without duplicates
+ * @return true if the file was modified, false if the lists are identical
+ * @throw  Exception
+ */
+bool FileList::update(const QStringList& fileList) const
+{
+	// Read the current list.
+	QStringList oldList;
+	AppendCallback cb(oldList);
+	Layout lay;
+	if (!readList(path_, cb, lay) || !lay.complete_) {
+		write(fileList);
+		return true;
+	}
+
+	// Compare the sorted lists.
+	QByteArray deltas;
+	int i = 0, j = 0;
+	while (i < oldList.size() || j < fileList.size()) {
+		if (j == fileList.size()
+		    || (i < oldList.size() && oldList[i] < fileList[j])) {
+			deltas.append(RemoveRecord);
+			appendPath(deltas, oldList[i++]);
+		}
+		else if (i == oldList.size() || fileList[j] < oldList[i]) {
+			deltas.append(AddRecord);
+			appendPath(deltas, fileList[j++]);
+		}
+		else {
+			i++;
+			j++;
+		}
+	}
+
+	if (deltas.isEmpty())
+		return false;
+
+	// Compact the list if the deltas become too large.
+	qint64 deltaSize = lay.size_ - lay.tableEnd_ + deltas.size();
+	if (deltaSize > (lay.tableEnd_ - HeaderSize) / 4) {
+		write(fileList);
+		return true;
+	}
+
+	QFile file(path_);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append)
+	    || file.write(deltas) != deltas.size()) {
+		throw new Core::Exception("Failed to update the file list");
+	}
+
+	return true;
+}
+
+/**
+ * Creates or updates the list from a text file with a path on each line.
+ * The binary list is only written if its contents differ from the text file.
+ * Either way, the list is given the modification time of the text file, so
+ * that the text file is not imported again until it changes.
+ * @param  textPath  The path of the text file
+ * @return true if successful, false if the text file could not be read
+ * @throw  Exception
+ */
+bool FileList::importText(const QString& textPath) const
+{
+	QFile file(textPath);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	QStringList fileList;
+	QTextStream strm(&file);
+	while (!strm.atEnd())
+		fileList.append(strm.readLine().trimmed());
+
+	normalise(fileList);
+	update(fileList);
+	matchTime(path_, textPath);
+	return true;
+}
+
+/**
+ * Writes the list as a text file with a path on each line, which is the
+ * format read by Cscope.
+ * The list is then given the modification time of the text file, so that the
+ * text file does not appear to have been modified since it was exported.
+ * @param  textPath  The path of the text file
+ * @throw  Exception
+ */
+void FileList::exportText(const QString& textPath) const
+{
+	QByteArray buf;
+	ExportCallback cb(buf);
+	read(cb);
+
+	QSaveFile file(textPath);
+	if (!file.open(QIODevice::WriteOnly) || file.write(buf) != buf.size()
+	    || !file.commit()) {
+		throw new Core::Exception("Failed to write the 'cscope.files' file");
+	}
+
+	matchTime(path_, textPath);
+}
+
+/**
+ * Sorts a list of paths, and removes duplicate and empty entries.
+ * @param  fileList  The list to normalise
+ */
+void FileList::normalise(QStringList& fileList)
+{
+	fileList.removeAll(QString());
+	fileList.sort();
+	fileList.removeDuplicates();
+}
+
+} // namespace Cscope
+
+} // namespace KScope
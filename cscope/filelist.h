@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_FILELIST_H__
+#define __CSCOPE_FILELIST_H__
+
+#include <QStringList>
+#include <core/globals.h>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * A binary list of project files.
+ * The file starts with a header, followed by a table of the paths in the
+ * project, sorted and without duplicates. Each path is stored as a 32-bit
+ * length, followed by its UTF-8 encoding. The table is followed by zero or
+ * more delta records, each adding or removing a single path, which allow
+ * small changes to be written without rewriting the whole file. The table is
+ * rewritten (atomically) once the deltas grow too large.
+ * Reading is done by mapping the file to memory, so no I/O buffering is
+ * involved in enumerating the files.
+ * @author Elad Lahav
+ */
+class FileList
+{
+public:
+	FileList(const QString& path = QString()) : path_(path) {}
+
+	/**
+	 * @param  path  The path of the file list
+	 */
+	void setPath(const QString& path) { path_ = path; }
+
+	/**
+	 * @return The path of the file list
+	 */
+	const QString& path() const { return path_; }
+
+	bool isValid() const;
+	bool isEmpty() const;
+	bool read(Core::Callback<const QString&>&) const;
+	bool read(QStringList&) const;
+	void write(const QStringList&) const;
+	bool update(const QStringList&) const;
+	bool importText(const QString&) const;
+	void exportText(const QString&) const;
+
+	static void normalise(QStringList&);
+
+private:
+	/**
+	 * The path of the file list.
+	 */
+	QString path_;
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif  // __CSCOPE_FILELIST_H__
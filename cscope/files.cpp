@@ -20,7 +20,7 @@
 
 #include <QDir>
 #include <QFileInfo>
-#include <QTextStream>
+#include <QDateTime>
 #include <core/exception.h>
 #include "files.h"
 
@@ -30,6 +30,11 @@ namespace KScope
 namespace Cscope
 {
 
+/**
+ * The name of the binary file list.
+ */
+static const char* FileListName = "cscope.filelist";
+
 /**
  * Class constructor.
  * @param  parent  Parent object
@@ -46,8 +51,9 @@ Files::~Files()
 }
 
 /**
- * Creates a new cscope.files file.
+ * Creates a new, empty, file list.
  * @param  path  The project path under which to create the new file
+ * @throw  Exception
  */
 void Files::create(const QString& path)
 {
@@ -56,16 +62,29 @@ void Files::create(const QString& path)
 	if (!dir.exists())
 		throw new Core::Exception("File list directory does not exist");
 
-	// Open the file for writing.
-	QFile file(dir.filePath("cscope.files"));
-	if (!file.open(QIODevice::WriteOnly))
-		throw Core::Exception("Failed to create the 'cscope.files' file");
+	// Create the file list, and an empty cscope.files file.
+	list_.setPath(dir.filePath(FileListName));
+	list_.write(QStringList());
+	list_.exportText(dir.filePath("cscope.files"));
 
 	path_ = dir.filePath("cscope.files");
 	writable_ = true;
 	empty_ = true;
 }
 
+/**
+ * Opens the file list of a project.
+ * Projects created before the binary file list was introduced only have a
+ * cscope.files file, from which the list is imported. The list is also
+ * re-imported if cscope.files is newer, i.e., it was modified outside KScope.
+ * The cscope.files file is exported from the list if it is missing or older
+ * than the list. Importing and exporting give both files the same
+ * modification time, so an up-to-date pair is neither imported nor
+ * exported.
+ * @param  path  The project path
+ * @param  cb    Called once the list is open
+ * @throw  Exception
+ */
 void Files::open(const QString& path, Core::Callback<>* cb)
 {
 	// Make sure the directory exists.
@@ -73,27 +92,49 @@ void Files::open(const QString& path, Core::Callback<>* cb)
 	if (!dir.exists())
 		throw new Core::Exception("File list directory does not exist");
 
-	// Check if the file exists.
-	QFileInfo fi(dir, "cscope.files");
-	if (fi.exists()) {
-		// Yes, make sure it can be read.
-		if (!fi.isReadable())
+	list_.setPath(dir.filePath(FileListName));
+	path_ = dir.filePath("cscope.files");
+
+	QFileInfo textInfo(path_);
+	if (!list_.isValid()) {
+		if (!textInfo.exists()) {
+			// No list, create a new one.
+			create(path);
+			if (cb)
+				cb->call();
+			return;
+		}
+
+		// Import an existing cscope.files file.
+		if (!textInfo.isReadable())
 			throw new Core::Exception("Cannot open 'cscope.files' for reading");
 
-		path_ = dir.filePath("cscope.files");
-		writable_ = fi.isWritable();
-		empty_ = (fi.size() == 0);
+		if (!list_.importText(path_))
+			throw new Core::Exception("Failed to import 'cscope.files'");
 	}
 	else {
-		// No, create a new file.
-		try {
-			create(path);
+		QFileInfo listInfo(list_.path());
+		if (textInfo.exists()
+		    && textInfo.lastModified() > listInfo.lastModified()) {
+			// Pick up changes made to cscope.files outside KScope.
+			if (!textInfo.isReadable()) {
+				throw new Core::Exception("Cannot open 'cscope.files' "
+				                          "for reading");
+			}
+
+			if (!list_.importText(path_))
+				throw new Core::Exception("Failed to import 'cscope.files'");
 		}
-		catch (Core::Exception* e) {
-			throw e;
+		else if (!textInfo.exists()
+		         || textInfo.lastModified() < listInfo.lastModified()) {
+			// Export the list if Cscope would otherwise see a stale file.
+			list_.exportText(path_);
 		}
 	}
 
+	writable_ = QFileInfo(list_.path()).isWritable();
+	empty_ = list_.isEmpty();
+
 	if (cb)
 		cb->call();
 }
@@ -105,27 +146,27 @@ void Files::save(const QString& path)
 
 void Files::getFiles(Core::Callback<const QString&>& cb) const
 {
-	QFile file(path_);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-		return;
-
-	QTextStream strm(&file);
-	while (!strm.atEnd())
-		cb.call(strm.readLine());
+	list_.read(cb);
 }
 
+/**
+ * Replaces the list of files.
+ * Only the differences from the current list are written. The cscope.files
+ * file is exported only if the list has changed, as Cscope can only read the
+ * complete text file.
+ * @param  fileList  The new list of files
+ * @throw  Exception
+ */
 void Files::setFiles(const QStringList& fileList)
 {
-	QFile file(path_);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-		return;
+	QStringList sortedList = fileList;
+	FileList::normalise(sortedList);
 
-	QTextStream strm(&file);
-	QStringList::ConstIterator itr;
-	for (itr = fileList.begin(); itr != fileList.end(); ++itr)
-		strm << *itr << endl;
+	if (list_.update(sortedList))
+		list_.exportText(path_);
 
-	empty_ = fileList.isEmpty();
+	empty_ = sortedList.isEmpty();
+	emit modified();
 }
 
 } // namespace Cscope
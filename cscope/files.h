@@ -22,6 +22,7 @@
 #define __CSCOPE_FILES_H__
 
 #include <core/codebase.h>
+#include "filelist.h"
 
 namespace KScope
 {
@@ -30,9 +31,10 @@ namespace Cscope
 {
 
 /**
- * Manages a cscope.files file.
- * A cscope.files file is a text file containing the name of each file in the
- * project on a separate line.
+ * Manages the list of files in a Cscope project.
+ * The list is kept in a binary file (see FileList), and exported to a
+ * cscope.files file, which is a text file containing the name of each file in
+ * the project on a separate line, as expected by Cscope.
  * @author Elad Lahav
  */
 class Files : public Core::Codebase
@@ -59,6 +61,11 @@ private:
 	 */
 	QString path_;
 
+	/**
+	 * The binary list of files.
+	 */
+	FileList list_;
+
 	/**
 	 * Whether the file can be written to.
 	 */
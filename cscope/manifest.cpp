@@ -0,0 +1,258 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QTextStream>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include "manifest.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Identifies manifest files.
+ */
+static const quint32 ManifestMagic = 0x4b534d46;
+
+/**
+ * Incremented whenever the manifest file format changes.
+ */
+static const quint32 ManifestVersion = 1;
+
+/**
+ * Reads a manifest file.
+ * @param  path  The path of the manifest file
+ * @return true if successful, false otherwise
+ */
+bool Manifest::load(const QString& path)
+{
+	args_.clear();
+	entryMap_.clear();
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_4_5);
+
+	// Check the header.
+	quint32 magic, version;
+	strm >> magic >> version;
+	if (magic != ManifestMagic || version != ManifestVersion)
+		return false;
+
+	// Read the build arguments and the number of entries.
+	quint32 count;
+	strm >> args_ >> count;
+
+	// Read the file entries.
+	entryMap_.reserve(count);
+	for (quint32 i = 0; i < count && strm.status() == QDataStream::Ok; i++) {
+		QString name;
+		Entry entry;
+		strm >> name >> entry.mtime_ >> entry.size_ >> entry.hash_;
+		entryMap_.insert(name, entry);
+	}
+
+	if (strm.status() != QDataStream::Ok) {
+		args_.clear();
+		entryMap_.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Writes the manifest to a file.
+ * The file is replaced atomically, so that an interrupted write does not
+ * leave a corrupt manifest behind.
+ * @param  path  The path of the manifest file
+ * @return true if successful, false otherwise
+ */
+bool Manifest::save(const QString& path) const
+{
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_4_5);
+	strm << ManifestMagic << ManifestVersion << args_
+	     << (quint32)entryMap_.size();
+
+	QHash<QString, Entry>::ConstIterator itr;
+	for (itr = entryMap_.begin(); itr != entryMap_.end(); ++itr) {
+		strm << itr.key() << itr.value().mtime_ << itr.value().size_
+		     << itr.value().hash_;
+	}
+
+	return file.commit();
+}
+
+/**
+ * Class constructor.
+ * @param  path    The directory holding cscope.files and the manifest
+ * @param  args    The Cscope build arguments
+ * @param  parent  Parent object
+ */
+ManifestUpdater::ManifestUpdater(const QString& path, const QStringList& args,
+                                 QObject* parent)
+	: QThread(parent), path_(path), argsChanged_(false), stop_(0)
+{
+	manifest_.args_ = args;
+}
+
+/**
+ * Class destructor.
+ */
+ManifestUpdater::~ManifestUpdater()
+{
+	stop();
+	wait();
+}
+
+/**
+ * @param  path  The directory holding the cross-reference database
+ * @return The path of the manifest file for this directory
+ */
+QString ManifestUpdater::manifestPath(const QString& path)
+{
+	return QDir(path).filePath("cscope.manifest");
+}
+
+/**
+ * Thread function.
+ * Reads the list of files from cscope.files, and compares the information on
+ * each file with the stored manifest. A file is only read (in order to compute
+ * its hash) if it is new, or if its modification time or size changed. Files
+ * that were only touched (i.e., the time stamp changed, but not the contents)
+ * are not considered modified.
+ */
+void ManifestUpdater::run()
+{
+	QDir dir(path_);
+
+	// Read the list of files.
+	QStringList fileList;
+	QFile listFile(dir.filePath("cscope.files"));
+	if (listFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		QTextStream strm(&listFile);
+		while (!strm.atEnd()) {
+			QString line = strm.readLine().trimmed();
+			if (!line.isEmpty())
+				fileList << line;
+		}
+	}
+
+	// Load the stored manifest.
+	// A missing or unreadable manifest results in all files being considered
+	// as added.
+	Manifest old;
+	old.load(manifestPath(path_));
+	argsChanged_ = (old.args_ != manifest_.args_);
+
+	// Compare each file with its stored information.
+	uint total = fileList.size();
+	manifest_.entryMap_.reserve(total);
+	for (uint i = 0; i < total; i++) {
+		if (stop_)
+			return;
+
+		// Report progress every so often.
+		if ((i & 0xff) == 0)
+			emit progress(i, total);
+
+		const QString& name = fileList[i];
+		if (manifest_.entryMap_.contains(name))
+			continue;
+
+		// Files that no longer exist are treated as removed.
+		QFileInfo fi(dir, name);
+		if (!fi.exists())
+			continue;
+
+		Manifest::Entry entry;
+		entry.mtime_ = fi.lastModified().toMSecsSinceEpoch();
+		entry.size_ = fi.size();
+
+		QHash<QString, Manifest::Entry>::ConstIterator itr
+			= old.entryMap_.find(name);
+		if (itr == old.entryMap_.end()) {
+			entry.hash_ = hashFile(fi.filePath());
+			added_ << name;
+		}
+		else if (itr.value().mtime_ == entry.mtime_
+		         && itr.value().size_ == entry.size_) {
+			entry.hash_ = itr.value().hash_;
+		}
+		else if (itr.value().size_ != entry.size_) {
+			entry.hash_ = hashFile(fi.filePath());
+			changed_ << name;
+		}
+		else {
+			entry.hash_ = hashFile(fi.filePath());
+			if (entry.hash_ != itr.value().hash_)
+				changed_ << name;
+		}
+
+		manifest_.entryMap_.insert(name, entry);
+	}
+
+	// Find removed files.
+	QHash<QString, Manifest::Entry>::ConstIterator itr;
+	for (itr = old.entryMap_.begin(); itr != old.entryMap_.end(); ++itr) {
+		if (!manifest_.entryMap_.contains(itr.key()))
+			removed_ << itr.key();
+	}
+
+	emit progress(total, total);
+}
+
+/**
+ * Computes a hash of the contents of a file.
+ * @param  path  The file to read
+ * @return The hash value, empty if the file cannot be read
+ */
+QByteArray ManifestUpdater::hashFile(const QString& path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	while (!file.atEnd())
+		hash.addData(file.read(64 * 1024));
+
+	return hash.result();
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,188 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_MANIFEST_H__
+#define __CSCOPE_MANIFEST_H__
+
+#include <QThread>
+#include <QHash>
+#include <QStringList>
+#include <QAtomicInt>
+#include <core/engine.h>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Describes the state of the source files at the time the database was built.
+ * The manifest holds the modification time, size and content hash of each
+ * file listed in cscope.files, along with the Cscope arguments used for
+ * building. It is stored in a cscope.manifest file next to cscope.out.
+ * @author Elad Lahav
+ */
+struct Manifest
+{
+	/**
+	 * Information on a single file.
+	 */
+	struct Entry
+	{
+		/**
+		 * Modification time, in milliseconds since the epoch.
+		 */
+		qint64 mtime_;
+
+		/**
+		 * File size, in bytes.
+		 */
+		qint64 size_;
+
+		/**
+		 * A hash of the file contents.
+		 */
+		QByteArray hash_;
+	};
+
+	/**
+	 * The Cscope build arguments.
+	 */
+	QStringList args_;
+
+	/**
+	 * Maps file paths to file information.
+	 */
+	QHash<QString, Entry> entryMap_;
+
+	bool load(const QString&);
+	bool save(const QString&) const;
+};
+
+/**
+ * Compares the files in a cscope.files list with the stored manifest.
+ * The comparison is performed in a separate thread, as it requires a stat()
+ * call on each file, and reading files whose time stamps changed.
+ * @author Elad Lahav
+ */
+class ManifestUpdater : public QThread, public Core::Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	ManifestUpdater(const QString&, const QStringList&, QObject* parent = 0);
+	~ManifestUpdater();
+
+	/**
+	 * Cancels the comparison.
+	 */
+	virtual void stop() { stop_ = 1; }
+
+	/**
+	 * @return true if the comparison was cancelled, false otherwise
+	 */
+	bool isCancelled() const { return stop_ != 0; }
+
+	/**
+	 * @return true if the database needs to be rebuilt
+	 */
+	bool hasChanges() const {
+		return argsChanged_ || !added_.isEmpty() || !removed_.isEmpty()
+		       || !changed_.isEmpty();
+	}
+
+	/**
+	 * @return true if the build arguments differ from the stored ones
+	 */
+	bool argsChanged() const { return argsChanged_; }
+
+	/**
+	 * @return Files listed in cscope.files, but not in the stored manifest
+	 */
+	const QStringList& added() const { return added_; }
+
+	/**
+	 * @return Files listed in the stored manifest, but not in cscope.files
+	 */
+	const QStringList& removed() const { return removed_; }
+
+	/**
+	 * @return Files whose contents changed since the manifest was stored
+	 */
+	const QStringList& changed() const { return changed_; }
+
+	/**
+	 * @return The manifest describing the current state of the files
+	 */
+	const Manifest& manifest() const { return manifest_; }
+
+	static QString manifestPath(const QString&);
+
+signals:
+	void progress(uint cur, uint total);
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The directory holding cscope.files and the manifest.
+	 */
+	QString path_;
+
+	/**
+	 * The new manifest.
+	 */
+	Manifest manifest_;
+
+	/**
+	 * Whether the build arguments changed.
+	 */
+	bool argsChanged_;
+
+	/**
+	 * Added files.
+	 */
+	QStringList added_;
+
+	/**
+	 * Removed files.
+	 */
+	QStringList removed_;
+
+	/**
+	 * Modified files.
+	 */
+	QStringList changed_;
+
+	/**
+	 * Set to stop the comparison.
+	 */
+	QAtomicInt stop_;
+
+	static QByteArray hashFile(const QString&);
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_MANIFEST_H__
@@ -0,0 +1,303 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QThread>
+#include <QDebug>
+#include <core/exception.h>
+#include "scheduler.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+int Scheduler::maxWorkers_ = QThread::idealThreadCount();
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+Scheduler::Scheduler(QObject* parent) : QObject(parent)
+{
+}
+
+/**
+ * Class destructor.
+ * Detaches queued queries from their connections, and terminates all worker
+ * processes.
+ */
+Scheduler::~Scheduler()
+{
+	for (int i = 0; i < PriorityCount; i++) {
+		foreach (Job* job, queue_[i]) {
+			job->conn_->setCtrlObject(NULL);
+			delete job;
+		}
+	}
+
+	qDeleteAll(workerList_);
+}
+
+/**
+ * Queues a query.
+ * The query is handed to a worker as soon as one is available. Queries with an
+ * Interactive priority are always handled before Background ones.
+ * @param  conn      A connection object used for reporting progress and data
+ * @param  path      The directory holding the database to query
+ * @param  type      The type of query to run
+ * @param  pattern   The pattern to query
+ * @param  priority  The priority of the query
+ */
+void Scheduler::query(Core::Engine::Connection* conn, const QString& path,
+                      Cscope::QueryType type, const QString& pattern,
+                      Priority priority)
+{
+	// Create a job for the query.
+	Job* job = new Job(this);
+	job->conn_ = conn;
+	job->path_ = path;
+	job->type_ = type;
+	job->pattern_ = pattern;
+
+	// Allow the query to be cancelled while in the queue.
+	conn->setCtrlObject(job);
+
+	queue_[priority].append(job);
+	dispatch();
+}
+
+/**
+ * Restarts all workers.
+ * Should be called after the database is rebuilt. Workers on databases that
+ * are no longer part of the project (e.g., after the number of shards has
+ * changed) are removed from the pool, aborting their current queries.
+ * @param  pathList  The directories of the current databases
+ */
+void Scheduler::restart(const QStringList& pathList)
+{
+	QList<Worker*> removed;
+	QList<Worker*>::Iterator itr = workerList_.begin();
+	while (itr != workerList_.end()) {
+		if (pathList.contains((*itr)->path())) {
+			(*itr)->restart();
+			++itr;
+		}
+		else {
+			removed.append(*itr);
+			itr = workerList_.erase(itr);
+		}
+	}
+
+	// Stopping a worker notifies its connection, which may issue new queries.
+	foreach (Worker* worker, removed) {
+		worker->stop();
+		delete worker;
+	}
+
+	dispatch();
+}
+
+/**
+ * Hands queued queries to idle workers, and starts new workers if needed.
+ */
+void Scheduler::dispatch()
+{
+	// Hand queries to idle workers that have the right database open.
+	for (int i = 0; i < PriorityCount; i++) {
+		QList<Job*>::Iterator itr = queue_[i].begin();
+		while (itr != queue_[i].end()) {
+			Worker* match = NULL;
+			foreach (Worker* worker, workerList_) {
+				if (worker->isIdle() && worker->path() == (*itr)->path_) {
+					match = worker;
+					break;
+				}
+			}
+
+			if (match == NULL) {
+				++itr;
+				continue;
+			}
+
+			Job* job = *itr;
+			itr = queue_[i].erase(itr);
+			run(match, job);
+		}
+	}
+
+	// Collect the queries that could not be handled, in order.
+	QList<Job*> waiting;
+	for (int i = 0; i < PriorityCount; i++)
+		waiting += queue_[i];
+
+	// Queries expected to be handled by workers that are about to become
+	// ready do not need another worker.
+	foreach (Worker* worker, workerList_) {
+		if (!waiting.isEmpty() && worker->isStarting()) {
+			for (int j = 0; j < waiting.size(); j++) {
+				if (waiting[j]->path_ == worker->path()) {
+					waiting.removeAt(j);
+					break;
+				}
+			}
+		}
+	}
+
+	// Restart stopped workers, preferably for queries on their own databases.
+	// A stopped worker has no running process, so moving it to another
+	// database is cheap. Idle workers are never moved, as that requires
+	// killing their processes.
+	foreach (Worker* worker, workerList_) {
+		if (waiting.isEmpty())
+			return;
+
+		if (!worker->isStopped())
+			continue;
+
+		int j = 0;
+		while ((j < waiting.size()) && (waiting[j]->path_ != worker->path()))
+			j++;
+
+		Job* job = waiting.takeAt(j < waiting.size() ? j : 0);
+		worker->setPath(job->path_);
+		worker->restart();
+	}
+
+	// Add workers to the pool, up to the maximal number. A query on a database
+	// that has no worker at all gets a new one regardless of the pool size.
+	int maxWorkers = qMax(maxWorkers_, 1);
+	foreach (Job* job, waiting) {
+		bool hasWorker = false;
+		foreach (Worker* worker, workerList_) {
+			if (worker->path() == job->path_) {
+				hasWorker = true;
+				break;
+			}
+		}
+
+		if (!hasWorker || (workerList_.size() < maxWorkers))
+			addWorker(job->path_);
+	}
+}
+
+/**
+ * Creates a new worker and starts its process.
+ * @param  path  The directory holding the worker's database
+ */
+void Scheduler::addWorker(const QString& path)
+{
+	Worker* worker = new Worker(path);
+	connect(worker, SIGNAL(ready()), this, SLOT(workerReady()));
+	connect(worker, SIGNAL(failed()), this, SLOT(workerFailed()));
+	workerList_.append(worker);
+
+	worker->restart();
+}
+
+/**
+ * Hands a query to a worker.
+ * @param  worker  An idle worker
+ * @param  job     The query to run (deleted by this method)
+ */
+void Scheduler::run(Worker* worker, Job* job)
+{
+	try {
+		worker->query(job->conn_, job->type_, job->pattern_);
+	}
+	catch (Core::Exception* e) {
+		qDebug() << e->reason();
+		delete e;
+		job->conn_->setCtrlObject(NULL);
+		job->conn_->onAborted();
+	}
+
+	delete job;
+}
+
+/**
+ * Removes a query from the queue.
+ * Called when a queued query is stopped through its connection.
+ * @param  job  The query to remove
+ */
+void Scheduler::cancel(Job* job)
+{
+	for (int i = 0; i < PriorityCount; i++)
+		queue_[i].removeOne(job);
+
+	Core::Engine::Connection* conn = job->conn_;
+	delete job;
+
+	conn->setCtrlObject(NULL);
+	conn->onAborted();
+}
+
+/**
+ * Called when a worker can accept a new query.
+ */
+void Scheduler::workerReady()
+{
+	dispatch();
+}
+
+/**
+ * Called when a worker process fails.
+ * The worker is removed from the pool. If no other worker is available for
+ * the same database, all queued queries on that database are aborted.
+ */
+void Scheduler::workerFailed()
+{
+	Worker* worker = static_cast<Worker*>(sender());
+	QString path = worker->path();
+	workerList_.removeOne(worker);
+	worker->deleteLater();
+
+	// Remaining workers will pick up queued queries once ready.
+	foreach (Worker* other, workerList_) {
+		if (other->path() == path)
+			return;
+	}
+
+	QList<Job*> aborted;
+	for (int i = 0; i < PriorityCount; i++) {
+		QList<Job*>::Iterator itr = queue_[i].begin();
+		while (itr != queue_[i].end()) {
+			if ((*itr)->path_ == path) {
+				aborted.append(*itr);
+				itr = queue_[i].erase(itr);
+			}
+			else {
+				++itr;
+			}
+		}
+	}
+
+	foreach (Job* job, aborted) {
+		Core::Engine::Connection* conn = job->conn_;
+		delete job;
+
+		conn->setCtrlObject(NULL);
+		conn->onAborted();
+	}
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,147 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_SCHEDULER_H__
+#define __CSCOPE_SCHEDULER_H__
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include "worker.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Distributes queries among a pool of Cscope workers.
+ * The scheduler keeps up to maxWorkers_ line-mode Cscope processes, which are
+ * started on demand. Queries that cannot be handled immediately are kept in a
+ * queue, ordered first by priority and then by arrival time. Queued queries
+ * can be cancelled through their connection objects.
+ * Each query names the directory of the database it applies to (a project may
+ * be split into several databases). Workers stay on the database they were
+ * started on, as moving a worker requires restarting its process. Queries are
+ * handed to workers that have the query's database open, and the pool grows
+ * beyond maxWorkers_ when needed to give each database a worker of its own.
+ * @author Elad Lahav
+ */
+class Scheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	/**
+	 * Query priorities.
+	 */
+	enum Priority {
+		/** Queries requested by the user. */
+		Interactive,
+		/** Speculative queries. */
+		Background,
+		/** The number of priority levels. */
+		PriorityCount
+	};
+
+	Scheduler(QObject* parent = NULL);
+	~Scheduler();
+
+	void query(Core::Engine::Connection*, const QString&, Cscope::QueryType,
+	           const QString&, Priority priority = Interactive);
+	void restart(const QStringList&);
+
+	/**
+	 * The maximal number of concurrent Cscope processes.
+	 */
+	static int maxWorkers_;
+
+private:
+	/**
+	 * A queued query.
+	 * The object serves as the control object of the query's connection while
+	 * the query is queued, so that stopping the connection removes the query
+	 * from the queue.
+	 */
+	struct Job : public Core::Engine::Controlled
+	{
+		/**
+		 * Struct constructor.
+		 * @param  sched  The owner scheduler
+		 */
+		Job(Scheduler* sched) : sched_(sched) {}
+
+		/**
+		 * Removes the query from the queue.
+		 */
+		virtual void stop() { sched_->cancel(this); }
+
+		/**
+		 * The owner scheduler.
+		 */
+		Scheduler* sched_;
+
+		/**
+		 * The connection object for the query.
+		 */
+		Core::Engine::Connection* conn_;
+
+		/**
+		 * The directory holding the database to query.
+		 */
+		QString path_;
+
+		/**
+		 * The Cscope query type.
+		 */
+		Cscope::QueryType type_;
+
+		/**
+		 * The pattern to query.
+		 */
+		QString pattern_;
+	};
+
+	/**
+	 * The pool of workers.
+	 */
+	QList<Worker*> workerList_;
+
+	/**
+	 * Queued queries, one FIFO per priority level.
+	 */
+	QList<Job*> queue_[PriorityCount];
+
+	void dispatch();
+	void addWorker(const QString&);
+	void run(Worker*, Job*);
+	void cancel(Job*);
+
+private slots:
+	void workerReady();
+	void workerFailed();
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_SCHEDULER_H__
@@ -0,0 +1,274 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QStringList>
+#include "shards.h"
+#include "cscope.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Class constructor.
+ * @param  conn    The connection object of the combined build
+ * @param  parent  Parent object
+ */
+ShardBuild::ShardBuild(Core::Engine::Connection* conn, QObject* parent)
+	: QObject(parent), conn_(conn), remaining_(0), success_(true),
+	  stopped_(false)
+{
+}
+
+/**
+ * Class destructor.
+ */
+ShardBuild::~ShardBuild()
+{
+}
+
+/**
+ * Starts a Cscope build process for each shard.
+ * @param  pathList  The directories of the shards
+ * @param  args      Command-line arguments for building the databases
+ */
+void ShardBuild::start(const QStringList& pathList, const QStringList& args)
+{
+	partList_.resize(pathList.size());
+	remaining_ = pathList.size();
+	conn_->setCtrlObject(this);
+
+	for (int i = 0; i < pathList.size(); i++) {
+		Part& part = partList_[i];
+		part.build_ = this;
+		part.cur_ = 0;
+		part.total_ = 0;
+		part.done_ = false;
+
+		Cscope* cscope = new Cscope();
+		cscope->setDeleteOnExit();
+		part.process_ = cscope;
+		connect(cscope, SIGNAL(finished(int, QProcess::ExitStatus)), this,
+		        SLOT(processFinished(int, QProcess::ExitStatus)));
+		connect(cscope, SIGNAL(error(QProcess::ProcessError)), this,
+		        SLOT(processError(QProcess::ProcessError)));
+		cscope->build(&part, pathList[i], args);
+	}
+}
+
+/**
+ * Stops all running build processes.
+ */
+void ShardBuild::stop()
+{
+	stopped_ = true;
+	for (int i = 0; i < partList_.size(); i++) {
+		if (!partList_[i].done_)
+			partList_[i].stop();
+	}
+}
+
+/**
+ * Called when the build process of a shard terminates.
+ * Once all processes have terminated, the combined build is reported as
+ * successful only if all shards were built.
+ * @param  process  The build process
+ * @param  success  Whether the shard was built
+ */
+void ShardBuild::partDone(QObject* process, bool success)
+{
+	for (int i = 0; i < partList_.size(); i++) {
+		if (partList_[i].process_ == process) {
+			partList_[i].done_ = true;
+			partList_[i].process_ = NULL;
+		}
+	}
+
+	if (!success)
+		success_ = false;
+
+	if (--remaining_ > 0)
+		return;
+
+	success = success_ && !stopped_;
+	emit finished(success);
+
+	conn_->setCtrlObject(NULL);
+	if (success)
+		conn_->onFinished();
+	else
+		conn_->onAborted();
+
+	deleteLater();
+}
+
+/**
+ * Called when a build process exits.
+ * @param  code    The exit code of the process
+ * @param  status  Used to indicate process crashes
+ */
+void ShardBuild::processFinished(int code, QProcess::ExitStatus status)
+{
+	partDone(sender(), (code == 0) && (status == QProcess::NormalExit));
+}
+
+/**
+ * Called when a build process reports an error.
+ * A process that failed to start does not emit finished().
+ * @param  code  The error code
+ */
+void ShardBuild::processError(QProcess::ProcessError code)
+{
+	if (code == QProcess::FailedToStart)
+		partDone(sender(), false);
+}
+
+/**
+ * Reports the combined progress of all build processes.
+ * @param  text  The progress message
+ */
+void ShardBuild::partProgress(const QString& text)
+{
+	uint cur = 0, total = 0;
+	for (int i = 0; i < partList_.size(); i++) {
+		cur += partList_[i].cur_;
+		total += partList_[i].total_;
+	}
+
+	conn_->onProgress(text, cur, total);
+}
+
+/**
+ * Class constructor.
+ * @param  conn    The connection object of the combined query
+ * @param  shards  The number of shards to query
+ */
+ShardQuery::ShardQuery(Core::Engine::Connection* conn, int shards)
+	: conn_(conn), partList_(shards), remaining_(shards), success_(true),
+	  stopping_(false)
+{
+	for (int i = 0; i < shards; i++) {
+		Part& part = partList_[i];
+		part.query_ = this;
+		part.cur_ = 0;
+		part.total_ = 0;
+		part.done_ = false;
+	}
+
+	conn_->setCtrlObject(this);
+}
+
+/**
+ * Class destructor.
+ */
+ShardQuery::~ShardQuery()
+{
+}
+
+/**
+ * Stops the query.
+ * The connection object is detached and notified immediately, as partial
+ * queries on one-shot processes may only terminate later.
+ */
+void ShardQuery::stop()
+{
+	if (conn_ == NULL)
+		return;
+
+	Core::Engine::Connection* conn = conn_;
+	conn_ = NULL;
+	conn->setCtrlObject(NULL);
+	conn->onAborted();
+
+	// Partial queries may terminate synchronously when stopped.
+	stopping_ = true;
+	for (int i = 0; i < partList_.size(); i++) {
+		if (!partList_[i].done_)
+			partList_[i].stop();
+	}
+	stopping_ = false;
+
+	if (remaining_ == 0)
+		delete this;
+}
+
+/**
+ * Forwards a batch of results delivered by a partial query.
+ * @param  locList  The list of locations
+ */
+void ShardQuery::partDataReady(const Core::CompactLocationList& locList)
+{
+	if (conn_)
+		conn_->onDataReady(locList);
+}
+
+/**
+ * Called when a partial query terminates.
+ * Once all partial queries have terminated, the combined query is reported as
+ * finished and the object is deleted.
+ * @param  part     The shard's connection object
+ * @param  success  Whether the partial query completed successfully
+ */
+void ShardQuery::partDone(Part* part, bool success)
+{
+	part->done_ = true;
+	if (!success)
+		success_ = false;
+
+	if (--remaining_ > 0)
+		return;
+
+	if (conn_) {
+		Core::Engine::Connection* conn = conn_;
+		conn_ = NULL;
+		conn->setCtrlObject(NULL);
+		if (success_)
+			conn->onFinished();
+		else
+			conn->onAborted();
+	}
+
+	if (!stopping_)
+		delete this;
+}
+
+/**
+ * Reports the combined progress of all partial queries.
+ * @param  text  The progress message
+ */
+void ShardQuery::partProgress(const QString& text)
+{
+	if (conn_ == NULL)
+		return;
+
+	uint cur = 0, total = 0;
+	for (int i = 0; i < partList_.size(); i++) {
+		cur += partList_[i].cur_;
+		total += partList_[i].total_;
+	}
+
+	conn_->onProgress(text, cur, total);
+}
+
+} // namespace Cscope
+
+} // namespace KScope
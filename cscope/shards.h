@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_SHARDS_H__
+#define __CSCOPE_SHARDS_H__
+
+#include <QObject>
+#include <QVector>
+#include <QProcess>
+#include <core/engine.h>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Combines the builds of several partial databases into a single operation.
+ * Each partial database (shard) is built by a separate Cscope process. The
+ * progress of all processes is reported as a single value through the
+ * connection object of the build, which is notified once all processes have
+ * terminated.
+ * @author Elad Lahav
+ */
+class ShardBuild : public QObject, public Core::Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	ShardBuild(Core::Engine::Connection*, QObject* parent = NULL);
+	~ShardBuild();
+
+	void start(const QStringList&, const QStringList&);
+	virtual void stop();
+
+signals:
+	/**
+	 * Emitted when all build processes have terminated, before the connection
+	 * object is notified.
+	 * @param  success  true if all shards were built, false otherwise
+	 */
+	void finished(bool success);
+
+private:
+	/**
+	 * Connects the build process of a single shard with the combined build.
+	 * Termination is detected through the process' signals, rather than
+	 * through the connection, as the exit code determines whether the build
+	 * succeeded.
+	 */
+	struct Part : public Core::Engine::Connection
+	{
+		ShardBuild* build_;
+		QProcess* process_;
+		uint cur_;
+		uint total_;
+		bool done_;
+
+		void onDataReady(const Core::CompactLocationList& locList) {
+			(void)locList;
+		}
+		void onFinished() {}
+		void onAborted() {}
+		void onProgress(const QString& text, uint cur, uint total) {
+			cur_ = cur;
+			total_ = total;
+			build_->partProgress(text);
+		}
+	};
+
+	/**
+	 * The connection object of the combined build.
+	 */
+	Core::Engine::Connection* conn_;
+
+	/**
+	 * One object per shard.
+	 */
+	QVector<Part> partList_;
+
+	/**
+	 * The number of processes that have not terminated yet.
+	 */
+	int remaining_;
+
+	/**
+	 * Whether all processes terminated successfully so far.
+	 */
+	bool success_;
+
+	/**
+	 * Set if the build was stopped.
+	 */
+	bool stopped_;
+
+	void partDone(QObject*, bool);
+	void partProgress(const QString&);
+
+private slots:
+	void processFinished(int, QProcess::ExitStatus);
+	void processError(QProcess::ProcessError);
+};
+
+/**
+ * Combines the results of a query issued on several partial databases.
+ * Results are forwarded as soon as any shard delivers them, and the combined
+ * query finishes once all partial queries have terminated.
+ * @author Elad Lahav
+ */
+class ShardQuery : public Core::Engine::Controlled
+{
+public:
+	ShardQuery(Core::Engine::Connection*, int);
+	~ShardQuery();
+
+	/**
+	 * @param  shard  The shard number
+	 * @return The connection object to use for querying that shard
+	 */
+	Core::Engine::Connection* part(int shard) { return &partList_[shard]; }
+
+	virtual void stop();
+
+private:
+	/**
+	 * Forwards the results of querying a single shard.
+	 */
+	struct Part : public Core::Engine::Connection
+	{
+		ShardQuery* query_;
+		uint cur_;
+		uint total_;
+		bool done_;
+
+		void onDataReady(const Core::CompactLocationList& locList) {
+			query_->partDataReady(locList);
+		}
+		void onFinished() { query_->partDone(this, true); }
+		void onAborted() { query_->partDone(this, false); }
+		void onProgress(const QString& text, uint cur, uint total) {
+			cur_ = cur;
+			total_ = total;
+			query_->partProgress(text);
+		}
+	};
+
+	/**
+	 * The connection object of the combined query, NULL once the query was
+	 * stopped.
+	 */
+	Core::Engine::Connection* conn_;
+
+	/**
+	 * One object per shard.
+	 */
+	QVector<Part> partList_;
+
+	/**
+	 * The number of partial queries that have not terminated yet.
+	 */
+	int remaining_;
+
+	/**
+	 * Whether all partial queries terminated successfully so far.
+	 */
+	bool success_;
+
+	/**
+	 * Set while partial queries are being stopped, to defer the deletion of
+	 * the object.
+	 */
+	bool stopping_;
+
+	void partDataReady(const Core::CompactLocationList&);
+	void partDone(Part*, bool);
+	void partProgress(const QString&);
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_SHARDS_H__
@@ -0,0 +1,284 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDebug>
+#include <core/exception.h>
+#include "worker.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Class constructor.
+ * Adds the rules required for parsing the output of an interactive Cscope
+ * process to those created by the Cscope class.
+ * The process is not started until the first call to restart() or query().
+ * @param  path  The directory holding the cross-reference database
+ */
+Worker::Worker(const QString& path)
+	: Cscope(),
+	  status_(NotRunning),
+	  path_(path),
+	  restart_(false),
+	  failed_(false),
+	  shutdown_(false),
+	  startState_("Start"),
+	  promptState_("Prompt"),
+	  idleState_("Idle")
+{
+	// The first prompt marks the process as ready.
+	addRule(startState_, Parser::Literal(">> "), idleState_,
+	        PromptAction(*this));
+
+	// Cscope prints an error message instead of the number of lines if the
+	// query fails. It is still followed by a prompt.
+	addRule(queryProgState_, Parser::Literal("Unable to search database\n"),
+	        promptState_, FailAction(*this));
+	addRule(promptState_, Parser::Literal(">> "), idleState_,
+	        PromptAction(*this));
+
+	// A prompt following the result lines terminates the query.
+	addRule(queryResultState_, Parser::Literal(">> "), idleState_,
+	        PromptAction(*this));
+}
+
+/**
+ * Class destructor.
+ */
+Worker::~Worker()
+{
+	shutdown_ = true;
+	if (state() != QProcess::NotRunning) {
+		kill();
+		waitForFinished();
+	}
+}
+
+/**
+ * Sends a query to the Cscope process.
+ * @param  conn     A connection object used for reporting progress and data
+ * @param  type     The type of query to run
+ * @param  pattern  The pattern to query
+ * @throw  Exception
+ */
+void Worker::query(Core::Engine::Connection* conn, QueryType type,
+                   const QString& pattern)
+{
+	// Only one query can be handled at a time.
+	if (status_ != Idle)
+		throw new Core::Exception("Cscope worker is not ready");
+
+	// Initialise parsing.
+	conn_ = conn;
+	conn_->setCtrlObject(this);
+	setState(queryProgState_);
+	locList_.clear();
+	batchTimer_.invalidate();
+	type_ = type;
+	failed_ = false;
+	status_ = Busy;
+
+	// Line-mode queries are given as the query number, immediately followed
+	// by the pattern.
+	qDebug() << "Worker query" << type << pattern << "in" << path_;
+	write(QString("%1%2\n").arg(type).arg(pattern).toLocal8Bit());
+}
+
+/**
+ * Restarts the Cscope process.
+ * This is required after the database is rebuilt, as a running process keeps
+ * the old cross-reference file open. If a query is currently handled, the
+ * process is restarted once the query is done.
+ */
+void Worker::restart()
+{
+	switch (status_) {
+	case Busy:
+		restart_ = true;
+		break;
+
+	case NotRunning:
+		launch();
+		break;
+
+	default:
+		// Killing the process results in a call to handleFinished(), which
+		// launches a new one.
+		status_ = Restarting;
+		kill();
+	}
+}
+
+/**
+ * Changes the directory holding the database.
+ * The process is restarted if needed.
+ * @param  path  The new directory
+ */
+void Worker::setPath(const QString& path)
+{
+	if (path == path_)
+		return;
+
+	path_ = path;
+	if (status_ != NotRunning)
+		restart();
+}
+
+/**
+ * Stops the current query.
+ * There is no way to abort a single query in an interactive Cscope process, so
+ * the process is killed and started again. The connection is informed
+ * immediately.
+ */
+void Worker::stop()
+{
+	if (status_ != Busy)
+		return;
+
+	// Detach from the connection before killing the process, so that the
+	// connection object is not referenced once this method returns.
+	Core::Engine::Connection* conn = conn_;
+	conn_ = NULL;
+	locList_.clear();
+	status_ = Restarting;
+	kill();
+
+	if (conn) {
+		conn->setCtrlObject(NULL);
+		conn->onAborted();
+	}
+}
+
+/**
+ * Called when the process terminates.
+ * A process that was killed while handling queries is restarted immediately.
+ * If the process terminates before showing its first prompt, the worker is
+ * considered to have failed.
+ * @param  code    The exit code of the process
+ * @param  status  Used to indicate process crashes
+ */
+void Worker::handleFinished(int code, QProcess::ExitStatus status)
+{
+	Process::handleFinished(code, status);
+
+	// Abort the current query, if any.
+	if (conn_) {
+		Core::Engine::Connection* conn = conn_;
+		conn_ = NULL;
+		locList_.clear();
+		conn->setCtrlObject(NULL);
+		conn->onAborted();
+	}
+
+	Status prevStatus = status_;
+	status_ = NotRunning;
+	restart_ = false;
+	if (shutdown_)
+		return;
+
+	if (prevStatus == Starting)
+		emit failed();
+	else
+		launch();
+}
+
+/**
+ * Called when the process fails to start.
+ * @param  code  The error code
+ */
+void Worker::handleError(QProcess::ProcessError code)
+{
+	Process::handleError(code);
+
+	if (code == QProcess::FailedToStart) {
+		status_ = NotRunning;
+		emit failed();
+	}
+}
+
+/**
+ * Starts a new Cscope process in line-oriented mode.
+ */
+void Worker::launch()
+{
+	// Prepare the argument list.
+	QStringList args;
+	args << "-d";
+	args << "-l";
+	args << "-v";
+	setWorkingDirectory(path_);
+
+	// Wait for the first prompt.
+	setState(startState_);
+	status_ = Starting;
+
+	qDebug() << "Running" << execPath_ << args << "in" << path_;
+	start(execPath_, args);
+}
+
+/**
+ * Handles a prompt from the Cscope process.
+ * Delivers the results of the current query (if any), and signals that the
+ * worker is ready for the next one.
+ */
+void Worker::promptReceived()
+{
+	// The process may have been killed after the prompt was parsed.
+	if (status_ != Starting && status_ != Busy)
+		return;
+
+	// Detach from the current query before calling the connection object, as
+	// it may issue new queries.
+	Core::Engine::Connection* conn = conn_;
+	Core::CompactLocationList locList = locList_;
+	bool failed = failed_;
+	conn_ = NULL;
+	locList_.clear();
+	failed_ = false;
+	status_ = Idle;
+
+	// Handle a restart request made while the query was running.
+	if (restart_) {
+		restart_ = false;
+		restart();
+	}
+
+	if (conn) {
+		conn->setCtrlObject(NULL);
+		if (failed) {
+			conn->onAborted();
+		}
+		else {
+			if (!locList.isEmpty())
+				conn->onDataReady(locList);
+			conn->onFinished();
+		}
+	}
+
+	if (status_ == Idle)
+		emit ready();
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,217 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_WORKER_H__
+#define __CSCOPE_WORKER_H__
+
+#include "cscope.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * A long-lived Cscope process, used for running queries.
+ * Starting a new Cscope process for every query means that each query pays for
+ * loading the cross-reference database (and the inverted index, if any). A
+ * worker instead keeps a single process running in line-oriented interactive
+ * mode (the -l option), and feeds queries to it through its standard input.
+ * Results are parsed with the same rules used for single-shot queries, with the
+ * addition of the ">> " prompt, which marks the end of each query.
+ * A worker handles one query at a time. The ready() signal is emitted whenever
+ * the worker can accept a new query.
+ * @author Elad Lahav
+ */
+class Worker : public Cscope
+{
+	Q_OBJECT
+
+public:
+	Worker(const QString&);
+	~Worker();
+
+	void query(Core::Engine::Connection*, QueryType, const QString&);
+	void restart();
+	void setPath(const QString&);
+	virtual void stop();
+
+	/**
+	 * @return true if the worker can accept a new query, false otherwise
+	 */
+	bool isIdle() const { return status_ == Idle; }
+
+	/**
+	 * @return true if the process is starting, and will be ready soon
+	 */
+	bool isStarting() const {
+		return (status_ == Starting) || (status_ == Restarting);
+	}
+
+	/**
+	 * @return true if the Cscope process is not running
+	 */
+	bool isStopped() const { return status_ == NotRunning; }
+
+	/**
+	 * @return The directory holding the database used by this worker
+	 */
+	const QString& path() const { return path_; }
+
+signals:
+	/**
+	 * Emitted when the worker is ready to accept a new query.
+	 */
+	void ready();
+
+	/**
+	 * Emitted when the Cscope process could not be started, or terminated
+	 * before it was ready to accept queries.
+	 */
+	void failed();
+
+protected slots:
+	virtual void handleFinished(int, QProcess::ExitStatus);
+	virtual void handleError(QProcess::ProcessError);
+
+private:
+	/**
+	 * The state of the worker.
+	 */
+	enum Status {
+		/** No process is running. */
+		NotRunning,
+		/** The process was started, but did not show a prompt yet. */
+		Starting,
+		/** Waiting for a query. */
+		Idle,
+		/** Handling a query. */
+		Busy,
+		/** The process is being killed, and will be started again. */
+		Restarting
+	};
+
+	/**
+	 * The current state of the worker.
+	 */
+	Status status_;
+
+	/**
+	 * The directory holding the cross-reference database.
+	 */
+	QString path_;
+
+	/**
+	 * Whether the process should be restarted once the current query ends.
+	 */
+	bool restart_;
+
+	/**
+	 * Set when Cscope reports that the current query failed.
+	 */
+	bool failed_;
+
+	/**
+	 * Set by the destructor, to prevent the process from being restarted.
+	 */
+	bool shutdown_;
+
+	/**
+	 * Waiting for the first prompt, after the process was started.
+	 */
+	State startState_;
+
+	/**
+	 * Waiting for a prompt after a failed query.
+	 */
+	State promptState_;
+
+	/**
+	 * Waiting for a query (no output is expected in this state).
+	 */
+	State idleState_;
+
+	void launch();
+
+	/**
+	 * Functor for transitions on a prompt.
+	 * Since actions are invoked while the input is parsed, the end of the query
+	 * is handled asynchronously, after parsing is done.
+	 */
+	struct PromptAction
+	{
+		/**
+		 * Struct constructor.
+		 * @param  self  The owner Worker object
+		 */
+		PromptAction(Worker& self) : self_(self) {}
+
+		/**
+		 * Functor operator.
+		 * @param  capList  ignored
+		 */
+		void operator()(const Parser::CapList& capList) const {
+			(void)capList;
+			QMetaObject::invokeMethod(&self_, "promptReceived",
+			                          Qt::QueuedConnection);
+		}
+
+		/**
+		 * The owner Worker object.
+		 */
+		Worker& self_;
+	};
+
+	/**
+	 * Functor for the query failure transition.
+	 */
+	struct FailAction
+	{
+		/**
+		 * Struct constructor.
+		 * @param  self  The owner Worker object
+		 */
+		FailAction(Worker& self) : self_(self) {}
+
+		/**
+		 * Functor operator.
+		 * @param  capList  ignored
+		 */
+		void operator()(const Parser::CapList& capList) const {
+			(void)capList;
+			self_.failed_ = true;
+		}
+
+		/**
+		 * The owner Worker object.
+		 */
+		Worker& self_;
+	};
+
+private slots:
+	void promptReceived();
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_WORKER_H__
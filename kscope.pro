@@ -5,6 +5,6 @@ CONFIG += qscintilla2_qt5
 TEMPLATE = subdirs
 
 # Directories
-SUBDIRS += core cscope editor app
+SUBDIRS += core cscope native editor app bench
 
 message(Installation root path is $${INSTALL_PATH})
@@ -0,0 +1,564 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <core/exception.h>
+#include "index.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+bool Index::enabled_ = false;
+
+/**
+ * Orders locations by file and line.
+ */
+static bool locationLessThan(const Core::Location& loc1,
+                             const Core::Location& loc2)
+{
+	if (loc1.file_ != loc2.file_)
+		return loc1.file_ < loc2.file_;
+
+	return loc1.line_ < loc2.line_;
+}
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+Index::Index(QObject* parent) : Core::Engine(parent), status_(Unknown),
+	generation_(0), buildGeneration_(0), indexer_(NULL), buildConn_(NULL)
+{
+}
+
+/**
+ * Class destructor.
+ */
+Index::~Index()
+{
+	// Detach from connections waiting for results.
+	foreach (Result* result, pending_) {
+		result->conn_->setCtrlObject(NULL);
+		delete result;
+	}
+}
+
+/**
+ * Opens the index.
+ * The initialisation string has the same format as for the Cscope engine:
+ * the first colon-delimited section is the directory holding the cscope.files
+ * file, under which the index is stored. Remaining sections are Cscope build
+ * options, which do not apply to this engine and are ignored.
+ * @param  initString  The initialisation string
+ * @param  cb          Called once the index is open
+ * @throw  Exception
+ */
+void Index::open(const QString& initString, Core::Callback<>* cb)
+{
+	QStringList args = initString.split(":", QString::SkipEmptyParts);
+	if (args.isEmpty())
+		throw new Core::Exception("Missing index directory");
+
+	QString path = args.takeFirst();
+
+	// Make sure the path exists.
+	QDir dir(path);
+	if (!dir.exists())
+		throw new Core::Exception("Index directory does not exist");
+
+	// Load the index, if it exists.
+	// An index that cannot be read (e.g., in an old format) needs to be
+	// built.
+	path_ = path;
+	if (!QFileInfo(indexPath()).exists())
+		status_ = Build;
+	else if (!index_.load(indexPath()))
+		status_ = Build;
+	else
+		status_ = Ready;
+
+	if (cb)
+		cb->call();
+}
+
+/**
+ * Builds a list of fields for each query type.
+ * The fields are the same as those of the Cscope engine, so that query
+ * results look the same regardless of the engine in use.
+ * @param  type  Query type
+ * @return A list of Location structure fields
+ */
+QList<Core::Location::Fields>
+Index::queryFields(Core::Query::Type type) const
+{
+	QList<Core::Location::Fields> fieldList;
+
+	switch (type) {
+	case Core::Query::FindFile:
+		fieldList << Core::Location::File;
+		break;
+
+	case Core::Query::Text:
+	case Core::Query::IncludingFiles:
+		fieldList << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
+	case Core::Query::Definition:
+		fieldList << Core::Location::TagName
+		          << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
+	case Core::Query::References:
+	case Core::Query::CalledFunctions:
+	case Core::Query::CallingFunctions:
+		fieldList << Core::Location::Scope
+		          << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
+	case Core::Query::LocalTags:
+		fieldList << Core::Location::TagName
+		          << Core::Location::Scope
+		          << Core::Location::Line
+		          << Core::Location::TagType;
+		break;
+
+	default:
+		;
+	}
+
+	return fieldList;
+}
+
+/**
+ * Runs a query.
+ * All query types other than Text are answered by looking up the index.
+ * @param  conn   Connection object to report results to
+ * @param  query  Query information
+ * @throw  Exception
+ */
+void Index::query(Core::Engine::Connection* conn,
+                  const Core::Query& query) const
+{
+	Core::LocationList locList;
+
+	switch (query.type_) {
+	case Core::Query::Text:
+		{
+			// Scan the files in a separate thread.
+			TextSearch* search
+				= new TextSearch(conn, path_, index_.files(), query,
+				                 const_cast<Index*>(this));
+			conn->setCtrlObject(search);
+			connect(search, SIGNAL(progress(uint, uint)), this,
+			        SLOT(textSearchProgress(uint, uint)));
+			connect(search, SIGNAL(finished()), this,
+			        SLOT(textSearchFinished()));
+			search->start();
+		}
+		return;
+
+	case Core::Query::Definition:
+	case Core::Query::References:
+		{
+			// Collect the matching records of each matching symbol.
+			bool defs = (query.type_ == Core::Query::Definition);
+			foreach (quint32 symbol, matchSymbols(query)) {
+				quint32 begin, end;
+				index_.symbolRecords(symbol, begin, end);
+				for (quint32 r = begin; r < end; r++) {
+					const SymbolIndex::Record& rec = index_.record(r);
+					if (defs && rec.kind_ != SymbolIndex::Definition)
+						continue;
+					if (!defs && rec.kind_ == SymbolIndex::Include)
+						continue;
+
+					locList.append(location(r, false));
+				}
+			}
+
+			addText(locList);
+		}
+		break;
+
+	case Core::Query::CalledFunctions:
+		// Follow the call edges from each matching function.
+		// The called function is reported as the scope, as Cscope does.
+		foreach (quint32 symbol, matchSymbols(query)) {
+			foreach (quint32 r, index_.callsFrom(symbol)) {
+				Core::Location loc = location(r, false);
+				loc.tag_.scope_ = loc.tag_.name_;
+				locList.append(loc);
+			}
+		}
+
+		qSort(locList.begin(), locList.end(), locationLessThan);
+		addText(locList);
+		break;
+
+	case Core::Query::CallingFunctions:
+		// Report the calls to each matching function, along with the
+		// calling function.
+		foreach (quint32 symbol, matchSymbols(query)) {
+			quint32 begin, end;
+			index_.symbolRecords(symbol, begin, end);
+			for (quint32 r = begin; r < end; r++) {
+				const SymbolIndex::Record& rec = index_.record(r);
+				if (rec.kind_ == SymbolIndex::Call
+				    && rec.scope_ != SymbolIndex::NoSymbol) {
+					locList.append(location(r, false));
+				}
+			}
+		}
+
+		addText(locList);
+		break;
+
+	case Core::Query::FindFile:
+		{
+			QRegExp re(query.pattern_,
+			           (query.flags_ & Core::Query::IgnoreCase)
+			           ? Qt::CaseInsensitive : Qt::CaseSensitive,
+			           (query.flags_ & Core::Query::RegExp)
+			           ? QRegExp::RegExp2 : QRegExp::FixedString);
+
+			foreach (QString file, index_.files()) {
+				if (re.indexIn(file) != -1)
+					locList.append(Core::Location(file));
+			}
+		}
+		break;
+
+	case Core::Query::IncludingFiles:
+		{
+			// Match the pattern against the file name in each directive,
+			// either as a whole or as its last path components.
+			QRegExp re(query.pattern_,
+			           (query.flags_ & Core::Query::IgnoreCase)
+			           ? Qt::CaseInsensitive : Qt::CaseSensitive,
+			           (query.flags_ & Core::Query::RegExp)
+			           ? QRegExp::RegExp2 : QRegExp::FixedString);
+
+			foreach (quint32 r, index_.includes()) {
+				QString name
+					= QString::fromLocal8Bit(index_.name(index_.record(r)
+					                                     .symbol_));
+				if (re.exactMatch(name)
+				    || (re.indexIn(name) > 0
+				        && name.at(re.pos() - 1) == '/'
+				        && re.pos() + re.matchedLength() == name.size())) {
+					locList.append(location(r, false));
+				}
+			}
+
+			qSort(locList.begin(), locList.end(), locationLessThan);
+			addText(locList);
+		}
+		break;
+
+	case Core::Query::LocalTags:
+		{
+			// Find the file in the file table.
+			QDir dir(path_);
+			QString path = QDir::cleanPath(dir.absoluteFilePath(query.pattern_));
+			const QStringList& files = index_.files();
+			for (int f = 0; f < files.size(); f++) {
+				if (QDir::cleanPath(dir.absoluteFilePath(files[f])) != path)
+					continue;
+
+				foreach (quint32 r, index_.definitionsIn(f))
+					locList.append(location(r, true));
+			}
+
+			qSort(locList.begin(), locList.end(), locationLessThan);
+		}
+		break;
+
+	default:
+		// Query type is not supported.
+		throw new Core::Exception(QString("Unsupported query type '%1")
+		                          .arg(query.type_));
+	}
+
+	postResult(conn, locList);
+}
+
+/**
+ * Marks the index as out of date, following changes to source files.
+ * An index being built may not reflect the changes either, so the build
+ * completes with the index still requiring a rebuild.
+ */
+void Index::invalidate()
+{
+	generation_++;
+	if (status_ == Ready)
+		status_ = Rebuild;
+}
+
+/**
+ * Starts building the index.
+ * @param  conn  Connection object to report progress to
+ * @throw  Exception
+ */
+void Index::build(Core::Engine::Connection* conn) const
+{
+	if (indexer_ != NULL)
+		throw new Core::Exception("A build is already in progress");
+
+	buildGeneration_ = generation_;
+	indexer_ = new Indexer(path_, indexPath(), const_cast<Index*>(this));
+	buildConn_ = conn;
+	buildConn_->setCtrlObject(indexer_);
+	connect(indexer_, SIGNAL(progress(uint, uint)), this,
+	        SLOT(buildProgress(uint, uint)));
+	connect(indexer_, SIGNAL(finished()), this, SLOT(buildFinished()));
+	indexer_->start();
+}
+
+/**
+ * @return The path of the index file
+ */
+QString Index::indexPath() const
+{
+	return QDir(path_).filePath("kscope.idx");
+}
+
+/**
+ * Finds the symbols matching a query pattern.
+ * A plain, case-sensitive pattern is looked up directly. Otherwise, the
+ * pattern has to match the entire symbol name.
+ * @param  query  Query information
+ * @return A list of name table positions
+ */
+QList<quint32> Index::matchSymbols(const Core::Query& query) const
+{
+	QList<quint32> symbols;
+
+	if ((query.flags_ & (Core::Query::RegExp | Core::Query::IgnoreCase))
+	    == 0) {
+		quint32 symbol = index_.lookup(query.pattern_.toLocal8Bit());
+		if (symbol != SymbolIndex::NoSymbol)
+			symbols << symbol;
+		return symbols;
+	}
+
+	QRegExp re(query.pattern_,
+	           (query.flags_ & Core::Query::IgnoreCase)
+	           ? Qt::CaseInsensitive : Qt::CaseSensitive,
+	           (query.flags_ & Core::Query::RegExp)
+	           ? QRegExp::RegExp2 : QRegExp::FixedString);
+
+	for (quint32 s = 0; s < index_.symbolCount(); s++) {
+		if (re.exactMatch(QString::fromLocal8Bit(index_.name(s))))
+			symbols << s;
+	}
+
+	return symbols;
+}
+
+/**
+ * Creates a location object for an index record.
+ * @param  rec       The record index
+ * @param  tagScope  true to report the enclosing structure as the scope
+ *                   (local tags), false to report the global scope
+ *                   explicitly, as Cscope does
+ * @return The location object
+ */
+Core::Location Index::location(quint32 rec, bool tagScope) const
+{
+	const SymbolIndex::Record& record = index_.record(rec);
+
+	Core::Location loc(index_.files()[record.file_], record.line_);
+	loc.tag_.name_ = QString::fromLocal8Bit(index_.name(record.symbol_));
+	loc.tag_.type_ = static_cast<Core::Tag::Type>(record.tagType_);
+	if (record.scope_ != SymbolIndex::NoSymbol)
+		loc.tag_.scope_ = QString::fromLocal8Bit(index_.name(record.scope_));
+	else if (!tagScope)
+		loc.tag_.scope_ = "<global>";
+
+	return loc;
+}
+
+/**
+ * Fills in the line text for a list of locations.
+ * The text is not kept in the index, but rather read from the source files.
+ * Each file is read once, which requires the list to be grouped by file.
+ * @param  locList  The list of locations to update
+ */
+void Index::addText(Core::LocationList& locList) const
+{
+	QDir dir(path_);
+	QString curFile;
+	QList<QByteArray> lines;
+
+	for (int i = 0; i < locList.size(); i++) {
+		Core::Location& loc = locList[i];
+		if (loc.file_ != curFile) {
+			curFile = loc.file_;
+			lines.clear();
+
+			QFile file(dir.absoluteFilePath(curFile));
+			if (file.open(QIODevice::ReadOnly))
+				lines = file.readAll().split('\n');
+		}
+
+		if (loc.line_ > 0 && (int)loc.line_ <= lines.size()) {
+			loc.text_
+				= QString::fromLocal8Bit(lines[loc.line_ - 1]).trimmed();
+		}
+	}
+}
+
+/**
+ * Queues the results of an index lookup for delivery.
+ * @param  conn     The connection to deliver the results to
+ * @param  locList  The results
+ */
+void Index::postResult(Core::Engine::Connection* conn,
+                       const Core::LocationList& locList) const
+{
+	Result* result = new Result;
+	result->engine_ = this;
+	result->conn_ = conn;
+	result->locList_ = locList;
+	conn->setCtrlObject(result);
+
+	pending_.append(result);
+	if (pending_.size() == 1) {
+		QMetaObject::invokeMethod(const_cast<Index*>(this), "deliverResults",
+		                          Qt::QueuedConnection);
+	}
+}
+
+/**
+ * Discards a result that was not delivered yet.
+ * @param  result  The result to discard
+ */
+void Index::cancel(Result* result) const
+{
+	if (!pending_.removeOne(result))
+		return;
+
+	Core::Engine::Connection* conn = result->conn_;
+	delete result;
+
+	conn->setCtrlObject(NULL);
+	conn->onAborted();
+}
+
+/**
+ * Delivers all pending lookup results.
+ */
+void Index::deliverResults()
+{
+	while (!pending_.isEmpty()) {
+		Result* result = pending_.takeFirst();
+		Core::Engine::Connection* conn = result->conn_;
+		Core::LocationList locList = result->locList_;
+		delete result;
+
+		conn->setCtrlObject(NULL);
+		if (!locList.isEmpty())
+			conn->onDataReady(Core::CompactLocationList(locList));
+		conn->onFinished();
+	}
+}
+
+/**
+ * Reports the progress of a build.
+ * @param  cur    The number of files parsed so far
+ * @param  total  The number of files to parse
+ */
+void Index::buildProgress(uint cur, uint total)
+{
+	if (buildConn_)
+		buildConn_->onProgress(tr("Indexing files..."), cur, total);
+}
+
+/**
+ * Called when the build thread terminates.
+ * Replaces the current index with the new one.
+ */
+void Index::buildFinished()
+{
+	Indexer* indexer = indexer_;
+	Core::Engine::Connection* conn = buildConn_;
+	indexer_ = NULL;
+	buildConn_ = NULL;
+	indexer->deleteLater();
+
+	conn->setCtrlObject(NULL);
+	if (indexer->isCancelled() || !indexer->succeeded()) {
+		conn->onAborted();
+		return;
+	}
+
+	index_ = indexer->index();
+	status_ = (buildGeneration_ == generation_) ? Ready : Rebuild;
+	conn->onFinished();
+}
+
+/**
+ * Reports the progress of a text search.
+ * @param  cur    The number of files searched so far
+ * @param  total  The number of files to search
+ */
+void Index::textSearchProgress(uint cur, uint total)
+{
+	TextSearch* search = static_cast<TextSearch*>(sender());
+	if (search->connection())
+		search->connection()->onProgress(tr("Searching..."), cur, total);
+}
+
+/**
+ * Called when a text search thread terminates.
+ * Delivers the matching lines.
+ */
+void Index::textSearchFinished()
+{
+	TextSearch* search = static_cast<TextSearch*>(sender());
+	Core::Engine::Connection* conn = search->connection();
+	search->deleteLater();
+
+	// Cancelled searches have already been reported.
+	if (conn == NULL)
+		return;
+
+	conn->setCtrlObject(NULL);
+
+	if (!search->results().isEmpty())
+		conn->onDataReady(Core::CompactLocationList(search->results()));
+	conn->onFinished();
+}
+
+} // namespace Native
+
+} // namespace KScope
@@ -0,0 +1,188 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __NATIVE_INDEX_H__
+#define __NATIVE_INDEX_H__
+
+#include <core/engine.h>
+#include "symbolindex.h"
+#include "indexer.h"
+#include "textsearch.h"
+#include "indexconfigwidget.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * An engine that answers queries from a symbol index built in-process.
+ * The index is created from the files listed in a cscope.files file, using a
+ * built-in C/C++ tokeniser, and is stored in a kscope.idx file in the same
+ * directory. Symbol queries are answered by direct lookups in the index,
+ * without running external processes. Free-text searches scan the source
+ * files in a separate thread.
+ * @author Elad Lahav
+ */
+class Index : public Core::Engine
+{
+	Q_OBJECT
+
+public:
+	Index(QObject* parent = 0);
+	~Index();
+
+	void open(const QString&, Core::Callback<>*);
+
+	/**
+	 * @return The current status of the index.
+	 */
+	Status status() const { return status_; }
+
+	void invalidate();
+
+	QList<Core::Location::Fields> queryFields(Core::Query::Type) const;
+
+	/**
+	 * Whether projects use this engine, rather than Cscope.
+	 */
+	static bool enabled_;
+
+public slots:
+	void query(Core::Engine::Connection*, const Core::Query&) const;
+	void build(Core::Engine::Connection*) const;
+
+private:
+	/**
+	 * Results of an index lookup, waiting to be delivered.
+	 * Lookups complete synchronously, but results are delivered from the
+	 * event loop, as callers do not expect a connection to be notified before
+	 * query() returns.
+	 */
+	struct Result : public Core::Engine::Controlled
+	{
+		const Index* engine_;
+		Core::Engine::Connection* conn_;
+		Core::LocationList locList_;
+
+		void stop() { engine_->cancel(this); }
+	};
+
+	/**
+	 * The path of the directory containing the index and cscope.files files.
+	 */
+	QString path_;
+
+	/**
+	 * The current status of the index.
+	 */
+	Status status_;
+
+	/**
+	 * Incremented whenever source files are modified.
+	 */
+	uint generation_;
+
+	/**
+	 * The value of generation_ when the current build started.
+	 */
+	mutable uint buildGeneration_;
+
+	/**
+	 * The symbol index.
+	 */
+	SymbolIndex index_;
+
+	/**
+	 * The thread building a new index, NULL if no build is in progress.
+	 */
+	mutable Indexer* indexer_;
+
+	/**
+	 * The connection for the current build.
+	 */
+	mutable Core::Engine::Connection* buildConn_;
+
+	/**
+	 * Lookup results waiting to be delivered.
+	 */
+	mutable QList<Result*> pending_;
+
+	QString indexPath() const;
+	QList<quint32> matchSymbols(const Core::Query&) const;
+	Core::Location location(quint32, bool) const;
+	void addText(Core::LocationList&) const;
+	void postResult(Core::Engine::Connection*,
+	                const Core::LocationList&) const;
+	void cancel(Result*) const;
+
+private slots:
+	void deliverResults();
+	void buildProgress(uint, uint);
+	void buildFinished();
+	void textSearchProgress(uint, uint);
+	void textSearchFinished();
+};
+
+} // namespace Native
+
+namespace Core
+{
+
+/**
+ * Provides configuration management for the native engine.
+ */
+template<>
+struct EngineConfig<Native::Index>
+{
+	static QString name() { return "Native"; }
+
+	static void getConfig(KeyValuePairs& confParams) {
+		confParams["Enabled"] = Native::Index::enabled_;
+	}
+
+	static void setConfig(const KeyValuePairs& confParams) {
+		if (confParams.contains("Enabled"))
+			Native::Index::enabled_ = confParams["Enabled"].toBool();
+	}
+
+	static QWidget* createConfigWidget(QWidget* parent) {
+		Native::IndexConfigWidget* widget
+			= new Native::IndexConfigWidget(parent);
+		widget->enabledCheck_->setChecked(Native::Index::enabled_);
+		return widget;
+	}
+
+	static void configFromWidget(QWidget* widget) {
+		Native::IndexConfigWidget* configWidget
+			= dynamic_cast<Native::IndexConfigWidget*>(widget);
+		if (configWidget == NULL)
+			return;
+
+		Native::Index::enabled_ = configWidget->enabled();
+	}
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __NATIVE_INDEX_H__
@@ -0,0 +1,683 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QTextStream>
+#include <QDebug>
+#include "indexer.h"
+#include "tokenizer.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * C/C++ keywords, which are never recorded as symbols.
+ */
+static const char* const keywords[] = {
+	"alignas", "alignof", "asm", "auto", "bool", "break", "case", "catch",
+	"char", "class", "const", "constexpr", "const_cast", "continue",
+	"decltype", "default", "delete", "do", "double", "dynamic_cast", "else",
+	"enum", "explicit", "export", "extern", "false", "float", "for", "friend",
+	"goto", "if", "inline", "int", "long", "mutable", "namespace", "new",
+	"noexcept", "nullptr", "operator", "private", "protected", "public",
+	"register", "reinterpret_cast", "restrict", "return", "short", "signed",
+	"sizeof", "static", "static_assert", "static_cast", "struct", "switch",
+	"template", "this", "throw", "true", "try", "typedef", "typeid",
+	"typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+	"while", "_Bool", "__attribute__", "__inline", "__inline__", "__restrict",
+	"__asm__", "__volatile__", "__typeof__", "typeof", NULL
+};
+
+/**
+ * Extracts symbol information from a single source file.
+ * The parser does not attempt to fully understand C/C++ syntax. Instead, it
+ * tracks nesting of braces and parentheses, and uses the tokens surrounding
+ * each identifier to classify it as a definition, a function call or a plain
+ * reference, in a manner similar to Cscope.
+ * @author Elad Lahav
+ */
+class FileParser
+{
+public:
+	FileParser(SymbolIndex&, quint32, const QByteArray&);
+
+	void parse();
+
+private:
+	/**
+	 * The kinds of brace-delimited blocks.
+	 */
+	enum BlockKind
+	{
+		/** A statement block or an initialiser. */
+		Block,
+		/** A function body. */
+		Function,
+		/** A structure, union or class body. */
+		Class,
+		/** An enumeration body. */
+		Enum,
+		/** A namespace or an extern "C" block. */
+		Namespace
+	};
+
+	/**
+	 * An open brace-delimited block.
+	 */
+	struct Brace
+	{
+		BlockKind kind_;
+		quint32 scope_;
+	};
+
+	SymbolIndex& index_;
+	quint32 file_;
+	Tokenizer tokenizer_;
+
+	/**
+	 * All non-preprocessor tokens in the file.
+	 */
+	QVector<Token> toks_;
+
+	/**
+	 * Currently-open blocks.
+	 */
+	QVector<Brace> braces_;
+
+	/**
+	 * The kind of block opened by the next brace.
+	 */
+	BlockKind pendingKind_;
+
+	/**
+	 * The scope of the block opened by the next brace.
+	 */
+	quint32 pendingScope_;
+
+	/**
+	 * Current nesting level of parentheses.
+	 */
+	int parenDepth_;
+
+	/**
+	 * Whether the current statement is a type definition.
+	 */
+	bool typedef_;
+
+	/**
+	 * The brace nesting level of the current type definition.
+	 */
+	int typedefDepth_;
+
+	/**
+	 * The number of parenthesised groups closed in the current type
+	 * definition.
+	 */
+	int typedefGroups_;
+
+	/**
+	 * The position of the last identifier that was already handled as part
+	 * of a preceding keyword.
+	 */
+	int skipUntil_;
+
+	void tokenize();
+	void directive(Token&);
+	void identifier(int);
+	int skipParens(int) const;
+	bool isKeyword(const Token&) const;
+	bool isPunct(int, char) const;
+	bool inFunction() const;
+	quint32 scope() const;
+	quint32 functionScope() const;
+	quint32 symbol(const Token& tok) {
+		return index_.addSymbol(tokenizer_.text(tok));
+	}
+	void record(const Token& tok, quint32 scope, SymbolIndex::Kind kind,
+	            Core::Tag::Type type = Core::Tag::UnknownTag) {
+		index_.addRecord(symbol(tok), file_, tok.line_, scope, kind, type);
+	}
+};
+
+/**
+ * The keyword table, as a set.
+ */
+static QSet<QByteArray> keywordSet()
+{
+	QSet<QByteArray> set;
+	for (int i = 0; keywords[i] != NULL; i++)
+		set.insert(QByteArray(keywords[i]));
+
+	return set;
+}
+
+/**
+ * Class constructor.
+ * @param  index  The index to add records to
+ * @param  file   The position of the file in the index's file table
+ * @param  src    The file contents
+ */
+FileParser::FileParser(SymbolIndex& index, quint32 file, const QByteArray& src)
+	: index_(index), file_(file), tokenizer_(src), pendingKind_(Block),
+	  pendingScope_(SymbolIndex::NoSymbol), parenDepth_(0), typedef_(false),
+	  typedefDepth_(0), typedefGroups_(0), skipUntil_(-1)
+{
+}
+
+/**
+ * Parses the file.
+ */
+void FileParser::parse()
+{
+	tokenize();
+
+	for (int i = 0; i < toks_.size(); i++) {
+		const Token& tok = toks_[i];
+
+		if (tok.type_ == Token::Identifier) {
+			if (i > skipUntil_)
+				identifier(i);
+			continue;
+		}
+
+		if (tok.type_ != Token::Punct)
+			continue;
+
+		switch (tok.ch_) {
+		case '{':
+			{
+				Brace brace;
+				brace.kind_ = pendingKind_;
+				brace.scope_ = (pendingKind_ == Function
+				                || pendingKind_ == Class)
+				               ? pendingScope_ : SymbolIndex::NoSymbol;
+				braces_.append(brace);
+				pendingKind_ = Block;
+				pendingScope_ = SymbolIndex::NoSymbol;
+				parenDepth_ = 0;
+			}
+			break;
+
+		case '}':
+			if (!braces_.isEmpty())
+				braces_.pop_back();
+			pendingKind_ = Block;
+			pendingScope_ = SymbolIndex::NoSymbol;
+			parenDepth_ = 0;
+			break;
+
+		case ';':
+			if (parenDepth_ == 0) {
+				if (typedef_ && braces_.size() <= typedefDepth_)
+					typedef_ = false;
+				pendingKind_ = Block;
+				pendingScope_ = SymbolIndex::NoSymbol;
+			}
+			break;
+
+		case '(':
+			parenDepth_++;
+			break;
+
+		case ')':
+			if (parenDepth_ > 0)
+				parenDepth_--;
+			if (typedef_ && parenDepth_ == 0)
+				typedefGroups_++;
+			break;
+
+		default:
+			;
+		}
+	}
+}
+
+/**
+ * Splits the file into tokens.
+ * Preprocessor directives are handled here, so that the token list only
+ * holds C/C++ code.
+ */
+void FileParser::tokenize()
+{
+	Token tok;
+
+	tokenizer_.next(tok);
+	while (tok.type_ != Token::End) {
+		if (tok.bol_ && tok.is('#')) {
+			directive(tok);
+			continue;
+		}
+
+		toks_.append(tok);
+		tokenizer_.next(tok);
+	}
+}
+
+/**
+ * Handles a preprocessor directive.
+ * Records #include directives and macro definitions. Identifiers in other
+ * directives are recorded as references.
+ * @param  tok  The '#' token on input, the first token following the
+ *              directive on output
+ */
+void FileParser::directive(Token& tok)
+{
+	tokenizer_.next(tok);
+	if (tok.type_ != Token::Identifier || tok.bol_)
+		return;
+
+	if (tokenizer_.equals(tok, "include")
+	    || tokenizer_.equals(tok, "include_next")
+	    || tokenizer_.equals(tok, "import")) {
+		uint line = tok.line_;
+		QByteArray arg = tokenizer_.restOfLine();
+
+		// Strip the quotes or angle brackets around the file name.
+		if (arg.size() > 2 && (arg[0] == '"' || arg[0] == '<')) {
+			char close = (arg[0] == '"') ? '"' : '>';
+			int end = arg.indexOf(close, 1);
+			if (end > 1) {
+				index_.addRecord(index_.addSymbol(arg.mid(1, end - 1)), file_,
+				                 line, SymbolIndex::NoSymbol,
+				                 SymbolIndex::Include, Core::Tag::Include);
+			}
+		}
+
+		tokenizer_.next(tok);
+		return;
+	}
+
+	bool define = tokenizer_.equals(tok, "define");
+	tokenizer_.next(tok);
+
+	// Record the macro name as a definition.
+	if (define && tok.type_ == Token::Identifier && !tok.bol_) {
+		record(tok, SymbolIndex::NoSymbol, SymbolIndex::Definition,
+		       Core::Tag::Define);
+		tokenizer_.next(tok);
+	}
+
+	// Record identifiers up to the end of the directive as references.
+	while (tok.type_ != Token::End && !tok.bol_) {
+		if (tok.type_ == Token::Identifier && !isKeyword(tok)
+		    && !tokenizer_.equals(tok, "defined")) {
+			record(tok, SymbolIndex::NoSymbol, SymbolIndex::Reference);
+		}
+
+		tokenizer_.next(tok);
+	}
+}
+
+/**
+ * Classifies an identifier, and records it.
+ * @param  i  The position of the identifier in the token list
+ */
+void FileParser::identifier(int i)
+{
+	const Token& tok = toks_[i];
+
+	if (isKeyword(tok)) {
+		if (tokenizer_.equals(tok, "struct")
+		    || tokenizer_.equals(tok, "class")
+		    || tokenizer_.equals(tok, "union")
+		    || tokenizer_.equals(tok, "enum")) {
+			bool isEnum = tokenizer_.equals(tok, "enum");
+			bool isUnion = tokenizer_.equals(tok, "union");
+			BlockKind kind = isEnum ? Enum : Class;
+
+			// A tag followed by a body (or a base class list) is a
+			// definition.
+			int j = i + 1;
+			if (isEnum && j < toks_.size()
+			    && (tokenizer_.equals(toks_[j], "class")
+			        || tokenizer_.equals(toks_[j], "struct"))) {
+				j++;
+			}
+
+			if (isPunct(j, '{')) {
+				pendingKind_ = kind;
+				pendingScope_ = SymbolIndex::NoSymbol;
+				skipUntil_ = j - 1;
+			}
+			else if (j < toks_.size()
+			         && toks_[j].type_ == Token::Identifier
+			         && !isKeyword(toks_[j])
+			         && (isPunct(j + 1, '{') || isPunct(j + 1, ':'))) {
+				Core::Tag::Type type = isEnum ? Core::Tag::Enum
+				                       : (isUnion ? Core::Tag::Union
+				                                  : Core::Tag::Struct);
+				record(toks_[j], scope(), SymbolIndex::Definition, type);
+				pendingKind_ = kind;
+				pendingScope_ = symbol(toks_[j]);
+				skipUntil_ = j;
+			}
+		}
+		else if (tokenizer_.equals(tok, "namespace")) {
+			pendingKind_ = Namespace;
+		}
+		else if (tokenizer_.equals(tok, "extern")) {
+			if (i + 1 < toks_.size() && toks_[i + 1].type_ == Token::String
+			    && isPunct(i + 2, '{')) {
+				pendingKind_ = Namespace;
+			}
+		}
+		else if (tokenizer_.equals(tok, "typedef")) {
+			typedef_ = true;
+			typedefDepth_ = braces_.size();
+			typedefGroups_ = 0;
+		}
+
+		return;
+	}
+
+	// Identifiers in a function header (parameters, initialiser lists)
+	// belong to the function.
+	if (pendingKind_ == Function) {
+		bool call = isPunct(i + 1, '(') && parenDepth_ == 0;
+		record(tok, pendingScope_,
+		       call ? SymbolIndex::Call : SymbolIndex::Reference);
+		return;
+	}
+
+	// Members accessed through objects are never defined here.
+	bool member = isPunct(i - 1, '.')
+	              || (i > 0 && toks_[i - 1].type_ == Token::Punct
+	                  && toks_[i - 1].len_ == 2 && toks_[i - 1].ch_ == '-');
+
+	if (isPunct(i + 1, '(')) {
+		if (inFunction() || member) {
+			record(tok, functionScope(), SymbolIndex::Call);
+			return;
+		}
+
+		if (typedef_ && braces_.size() == typedefDepth_) {
+			// typedef int func_t(int);
+			if (parenDepth_ == 0 && typedefGroups_ == 0) {
+				record(tok, scope(), SymbolIndex::Definition,
+				       Core::Tag::Typedef);
+			}
+			else {
+				record(tok, scope(), SymbolIndex::Reference);
+			}
+			return;
+		}
+
+		// Look past the parameter list for a function body.
+		// Another call-like construct before the body (other than in a
+		// constructor's initialiser list) means that this was a macro
+		// invocation preceding the definition of a different function.
+		int j = skipParens(i + 1);
+		bool initList = false;
+		for (int limit = j + 64; j < toks_.size() && j < limit; j++) {
+			const Token& next = toks_[j];
+			if (next.type_ != Token::Punct)
+				continue;
+
+			if (next.ch_ == ':' && next.len_ == 1) {
+				initList = true;
+				continue;
+			}
+
+			if (next.ch_ == '(') {
+				if (!initList && toks_[j - 1].type_ == Token::Identifier
+				    && !isKeyword(toks_[j - 1])) {
+					break;
+				}
+
+				j = skipParens(j) - 1;
+				continue;
+			}
+
+			if (next.ch_ == '{' || next.ch_ == ';' || next.ch_ == '='
+			    || next.ch_ == ',' || next.ch_ == '}') {
+				break;
+			}
+		}
+
+		if (parenDepth_ == 0 && isPunct(j, '{')) {
+			record(tok, scope(), SymbolIndex::Definition,
+			       Core::Tag::Function);
+			pendingKind_ = Function;
+			pendingScope_ = symbol(tok);
+		}
+		else {
+			record(tok, scope(), SymbolIndex::Reference);
+		}
+
+		return;
+	}
+
+	if (member) {
+		record(tok, functionScope(), SymbolIndex::Reference);
+		return;
+	}
+
+	bool endsDecl = isPunct(i + 1, ';') || isPunct(i + 1, ',')
+	                || isPunct(i + 1, '[') || isPunct(i + 1, '=');
+
+	// Type definitions: the declared name is the one not nested in a
+	// parameter list.
+	if (typedef_ && braces_.size() == typedefDepth_) {
+		if (typedefGroups_ == 0
+		    && (endsDecl || (isPunct(i + 1, ')') && parenDepth_ == 1))) {
+			record(tok, scope(), SymbolIndex::Definition,
+			       Core::Tag::Typedef);
+		}
+		else {
+			record(tok, scope(), SymbolIndex::Reference);
+		}
+		return;
+	}
+
+	// Enumerators.
+	if (!braces_.isEmpty() && braces_.last().kind_ == Enum
+	    && parenDepth_ == 0
+	    && (isPunct(i - 1, '{') || isPunct(i - 1, ','))
+	    && (isPunct(i + 1, ',') || isPunct(i + 1, '=')
+	        || isPunct(i + 1, '}'))) {
+		record(tok, scope(), SymbolIndex::Definition, Core::Tag::Enumerator);
+		return;
+	}
+
+	// Variables and structure members, declared outside functions.
+	if (!inFunction() && parenDepth_ == 0
+	    && (endsDecl || (isPunct(i + 1, ':') && !braces_.isEmpty()
+	                     && braces_.last().kind_ == Class))
+	    && i > 0
+	    && ((toks_[i - 1].type_ == Token::Identifier
+	         && !tokenizer_.equals(toks_[i - 1], "return"))
+	        || isPunct(i - 1, '*') || isPunct(i - 1, '&')
+	        || isPunct(i - 1, '>') || isPunct(i - 1, '}'))) {
+		bool inClass = !braces_.isEmpty() && braces_.last().kind_ == Class;
+		record(tok, scope(), SymbolIndex::Definition,
+		       inClass ? Core::Tag::Member : Core::Tag::Variable);
+		return;
+	}
+
+	record(tok, functionScope(), SymbolIndex::Reference);
+}
+
+/**
+ * Finds the end of a parenthesised group.
+ * @param  i  The position of the opening parenthesis
+ * @return The position following the matching closing parenthesis
+ */
+int FileParser::skipParens(int i) const
+{
+	int depth = 0;
+	for (; i < toks_.size(); i++) {
+		if (toks_[i].type_ != Token::Punct)
+			continue;
+
+		if (toks_[i].ch_ == '(') {
+			depth++;
+		}
+		else if (toks_[i].ch_ == ')') {
+			if (--depth == 0)
+				return i + 1;
+		}
+		else if (toks_[i].ch_ == '{' || toks_[i].ch_ == '}'
+		         || toks_[i].ch_ == ';') {
+			// Unbalanced parentheses: do not look beyond the statement.
+			return i;
+		}
+	}
+
+	return i;
+}
+
+/**
+ * @param  tok  An identifier token
+ * @return true if the identifier is a C/C++ keyword
+ */
+bool FileParser::isKeyword(const Token& tok) const
+{
+	static const QSet<QByteArray> set = keywordSet();
+	return set.contains(tokenizer_.rawText(tok));
+}
+
+/**
+ * @param  i  A position in the token list
+ * @param  c  A character
+ * @return true if the token at the given position is a single-character
+ *         punctuation token for the given character
+ */
+bool FileParser::isPunct(int i, char c) const
+{
+	return i >= 0 && i < toks_.size() && toks_[i].is(c);
+}
+
+/**
+ * @return true if the parser is inside a function body
+ */
+bool FileParser::inFunction() const
+{
+	for (int i = braces_.size() - 1; i >= 0; i--) {
+		if (braces_[i].kind_ == Function)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * @return The innermost enclosing function or structure, NoSymbol for the
+ *         global scope
+ */
+quint32 FileParser::scope() const
+{
+	for (int i = braces_.size() - 1; i >= 0; i--) {
+		if (braces_[i].scope_ != SymbolIndex::NoSymbol)
+			return braces_[i].scope_;
+	}
+
+	return SymbolIndex::NoSymbol;
+}
+
+/**
+ * @return The innermost enclosing function, NoSymbol if outside a function
+ */
+quint32 FileParser::functionScope() const
+{
+	for (int i = braces_.size() - 1; i >= 0; i--) {
+		if (braces_[i].kind_ == Function)
+			return braces_[i].scope_;
+	}
+
+	return SymbolIndex::NoSymbol;
+}
+
+/**
+ * Class constructor.
+ * @param  path       The directory holding the cscope.files file
+ * @param  indexPath  The index file to write
+ * @param  parent     Parent object
+ */
+Indexer::Indexer(const QString& path, const QString& indexPath,
+                 QObject* parent)
+	: QThread(parent), path_(path), indexPath_(indexPath), succeeded_(false),
+	  stop_(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+Indexer::~Indexer()
+{
+	stop();
+	wait();
+}
+
+/**
+ * Thread function.
+ * Parses each file listed in cscope.files, and writes the resulting index.
+ */
+void Indexer::run()
+{
+	QDir dir(path_);
+
+	// Read the list of files.
+	QStringList fileList;
+	QFile listFile(dir.filePath("cscope.files"));
+	if (listFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		QTextStream strm(&listFile);
+		while (!strm.atEnd()) {
+			QString line = strm.readLine().trimmed();
+			if (!line.isEmpty())
+				fileList << line;
+		}
+	}
+
+	uint total = fileList.size();
+	for (uint i = 0; i < total; i++) {
+		if (stop_)
+			return;
+
+		if ((i & 0x3f) == 0)
+			emit progress(i, total);
+
+		// Files that cannot be read are kept in the file table (so that text
+		// searches still consider them), but contribute no symbols.
+		quint32 file = index_.addFile(fileList[i]);
+		QFile source(dir.absoluteFilePath(fileList[i]));
+		if (!source.open(QIODevice::ReadOnly)) {
+			qDebug() << "Cannot read" << fileList[i];
+			continue;
+		}
+
+		QByteArray src = source.readAll();
+		FileParser(index_, file, src).parse();
+	}
+
+	emit progress(total, total);
+
+	index_.finalize();
+	succeeded_ = index_.save(indexPath_);
+}
+
+} // namespace Native
+
+} // namespace KScope
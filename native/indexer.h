@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __NATIVE_INDEXER_H__
+#define __NATIVE_INDEXER_H__
+
+#include <QThread>
+#include <QAtomicInt>
+#include <core/engine.h>
+#include "symbolindex.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * Builds a symbol index for the files listed in a cscope.files file.
+ * Files are read and tokenised in a separate thread. Once the thread
+ * terminates successfully, the new index is available through index(), and
+ * has been written to the index file.
+ * @author Elad Lahav
+ */
+class Indexer : public QThread, public Core::Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	Indexer(const QString&, const QString&, QObject* parent = 0);
+	~Indexer();
+
+	/**
+	 * Cancels the build.
+	 */
+	virtual void stop() { stop_ = 1; }
+
+	/**
+	 * @return true if the build was cancelled, false otherwise
+	 */
+	bool isCancelled() const { return stop_ != 0; }
+
+	/**
+	 * @return true if the index was built and saved, false otherwise
+	 */
+	bool succeeded() const { return succeeded_; }
+
+	/**
+	 * @return The new index (only valid once the thread has finished)
+	 */
+	const SymbolIndex& index() const { return index_; }
+
+signals:
+	void progress(uint cur, uint total);
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The directory holding the cscope.files file.
+	 */
+	QString path_;
+
+	/**
+	 * The path of the index file to write.
+	 */
+	QString indexPath_;
+
+	/**
+	 * The index being built.
+	 */
+	SymbolIndex index_;
+
+	/**
+	 * Whether the index was built and saved.
+	 */
+	bool succeeded_;
+
+	/**
+	 * Set to stop the build.
+	 */
+	QAtomicInt stop_;
+};
+
+} // namespace Native
+
+} // namespace KScope
+
+#endif // __NATIVE_INDEXER_H__
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __NATIVE_MANAGEDPROJECT_H__
+#define __NATIVE_MANAGEDPROJECT_H__
+
+#include <core/project.h>
+#include <core/projectconfig.h>
+#include <cscope/managedproject.h>
+#include <cscope/files.h>
+#include "index.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * A managed project indexed by the native engine.
+ * The project uses the same configuration file and cscope.files code base as
+ * a managed Cscope project, so that an existing project can be opened with
+ * either engine.
+ * @author Elad Lahav
+ */
+class ManagedProject : public Core::Project<Index, Cscope::Files>
+{
+public:
+	ManagedProject(const QString& projPath = QString());
+	virtual ~ManagedProject();
+
+	void create(const Params&);
+	void updateConfig(const Params&);
+};
+
+} // namespace Native
+
+namespace Core
+{
+
+/**
+ * Native projects share their parameters with Cscope managed projects.
+ * Cscope build options are kept in the engine string, so that they are not
+ * lost when the project is opened with the Cscope engine again.
+ */
+template<>
+struct ProjectConfig<Native::ManagedProject>
+	: public ProjectConfig<Cscope::ManagedProject>
+{
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __NATIVE_MANAGEDPROJECT_H__
@@ -0,0 +1,31 @@
+include(../config)
+TEMPLATE = lib
+TARGET = kscope_native
+DEPENDPATH += ". ../core ../cscope"
+CONFIG += dll
+
+# Input
+HEADERS += tokenizer.h \
+    symbolindex.h \
+    indexer.h \
+    textsearch.h \
+    index.h \
+    indexconfigwidget.h \
+    managedproject.h
+FORMS += indexconfigwidget.ui
+SOURCES += tokenizer.cpp \
+    symbolindex.cpp \
+    indexer.cpp \
+    textsearch.cpp \
+    index.cpp \
+    indexconfigwidget.cpp \
+    managedproject.cpp
+INCLUDEPATH += .. \
+    .
+LIBS += -L../core \
+    -lkscope_core \
+    -L../cscope \
+    -lkscope_cscope
+target.path = $${INSTALL_PATH}/lib64
+INSTALLS += target
+QT += widgets xml
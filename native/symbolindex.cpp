@@ -0,0 +1,270 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include "symbolindex.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+const quint32 SymbolIndex::NoSymbol;
+
+/**
+ * Identifies index files.
+ */
+static const quint32 IndexMagic = 0x4b534958;
+
+/**
+ * Incremented whenever the index file format changes.
+ */
+static const quint32 IndexVersion = 1;
+
+/**
+ * Class constructor.
+ */
+SymbolIndex::SymbolIndex()
+{
+	symbolStart_ << 0;
+}
+
+/**
+ * Class destructor.
+ */
+SymbolIndex::~SymbolIndex()
+{
+}
+
+/**
+ * Removes all data from the index.
+ */
+void SymbolIndex::clear()
+{
+	files_.clear();
+	names_.clear();
+	nameMap_.clear();
+	records_.clear();
+	symbolStart_.clear();
+	symbolStart_ << 0;
+	callMap_.clear();
+	fileDefMap_.clear();
+	includes_.clear();
+}
+
+/**
+ * Adds a file to the file table.
+ * @param  path  The file path
+ * @return The position of the file in the table
+ */
+quint32 SymbolIndex::addFile(const QString& path)
+{
+	files_ << path;
+	return files_.size() - 1;
+}
+
+/**
+ * Finds a symbol in the name table, adding it if necessary.
+ * @param  name  The symbol name
+ * @return The position of the symbol in the table
+ */
+quint32 SymbolIndex::addSymbol(const QByteArray& name)
+{
+	QHash<QByteArray, quint32>::ConstIterator itr = nameMap_.find(name);
+	if (itr != nameMap_.end())
+		return itr.value();
+
+	quint32 symbol = names_.size();
+	names_ << name;
+	nameMap_.insert(name, symbol);
+	return symbol;
+}
+
+/**
+ * Adds an occurrence of a symbol.
+ * @param  symbol   The position of the symbol in the name table
+ * @param  file     The position of the file in the file table
+ * @param  line     The line number
+ * @param  scope    The position of the enclosing scope in the name table
+ * @param  kind     The kind of occurrence
+ * @param  tagType  The type of a defined symbol
+ */
+void SymbolIndex::addRecord(quint32 symbol, quint32 file, quint32 line,
+                            quint32 scope, Kind kind, Core::Tag::Type tagType)
+{
+	Record rec;
+	rec.symbol_ = symbol;
+	rec.file_ = file;
+	rec.line_ = line;
+	rec.scope_ = scope;
+	rec.kind_ = kind;
+	rec.tagType_ = tagType;
+	records_.append(rec);
+}
+
+/**
+ * Sorts the records by symbol, and builds the lookup tables.
+ * Must be called after all records were added, and before the index is
+ * queried or saved.
+ * The sort is a stable counting sort, so that the records of each symbol
+ * remain ordered by file and line.
+ */
+void SymbolIndex::finalize()
+{
+	quint32 symbols = names_.size();
+
+	// Count the records for each symbol, and turn the counts into starting
+	// positions.
+	symbolStart_.fill(0, symbols + 1);
+	for (int i = 0; i < records_.size(); i++)
+		symbolStart_[records_[i].symbol_ + 1]++;
+
+	for (quint32 s = 0; s < symbols; s++)
+		symbolStart_[s + 1] += symbolStart_[s];
+
+	// Place the records.
+	QVector<quint32> next(symbolStart_);
+	QVector<Record> sorted(records_.size());
+	for (int i = 0; i < records_.size(); i++)
+		sorted[next[records_[i].symbol_]++] = records_[i];
+
+	records_ = sorted;
+	buildSecondary();
+}
+
+/**
+ * Reads the index from a file.
+ * @param  path  The index file
+ * @return true if successful, false otherwise
+ */
+bool SymbolIndex::load(const QString& path)
+{
+	clear();
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_4_5);
+
+	// Check the header.
+	quint32 magic, version;
+	strm >> magic >> version;
+	if (magic != IndexMagic || version != IndexVersion)
+		return false;
+
+	// Read the tables.
+	quint32 count;
+	strm >> files_ >> names_ >> symbolStart_ >> count;
+	if (strm.status() != QDataStream::Ok
+	    || symbolStart_.size() != names_.size() + 1
+	    || symbolStart_.last() != count) {
+		clear();
+		return false;
+	}
+
+	// Read the records.
+	records_.resize(count);
+	for (quint32 i = 0; i < count; i++) {
+		Record& rec = records_[i];
+		strm >> rec.symbol_ >> rec.file_ >> rec.line_ >> rec.scope_
+		     >> rec.kind_ >> rec.tagType_;
+	}
+
+	if (strm.status() != QDataStream::Ok) {
+		clear();
+		return false;
+	}
+
+	// Re-create the name map.
+	nameMap_.reserve(names_.size());
+	for (int i = 0; i < names_.size(); i++)
+		nameMap_.insert(names_[i], i);
+
+	buildSecondary();
+	return true;
+}
+
+/**
+ * Writes the index to a file.
+ * The file is replaced atomically, so that the existing index remains valid
+ * if writing fails.
+ * @param  path  The index file
+ * @return true if successful, false otherwise
+ */
+bool SymbolIndex::save(const QString& path) const
+{
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_4_5);
+	strm << IndexMagic << IndexVersion << files_ << names_ << symbolStart_
+	     << (quint32)records_.size();
+
+	QVector<Record>::ConstIterator itr;
+	for (itr = records_.begin(); itr != records_.end(); ++itr) {
+		strm << itr->symbol_ << itr->file_ << itr->line_ << itr->scope_
+		     << itr->kind_ << itr->tagType_;
+	}
+
+	return file.commit();
+}
+
+/**
+ * Creates the call, file definition and include tables from the sorted list
+ * of records.
+ */
+void SymbolIndex::buildSecondary()
+{
+	callMap_.clear();
+	fileDefMap_.clear();
+	includes_.clear();
+
+	for (int i = 0; i < records_.size(); i++) {
+		const Record& rec = records_[i];
+		switch (rec.kind_) {
+		case Call:
+			if (rec.scope_ != NoSymbol)
+				callMap_[rec.scope_].append(i);
+			break;
+
+		case Definition:
+			fileDefMap_[rec.file_].append(i);
+			break;
+
+		case Include:
+			includes_.append(i);
+			break;
+
+		default:
+			;
+		}
+	}
+}
+
+} // namespace Native
+
+} // namespace KScope
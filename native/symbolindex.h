@@ -0,0 +1,236 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __NATIVE_SYMBOLINDEX_H__
+#define __NATIVE_SYMBOLINDEX_H__
+
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+#include <core/globals.h>
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * A compact, in-memory symbol index for a set of source files.
+ * Symbol names and file paths are stored once, and referred to by their
+ * position in the respective tables. Each occurrence of a symbol is described
+ * by a fixed-size record. Records are sorted by symbol, so that all
+ * occurrences of a symbol form a consecutive range.
+ * Secondary indices (calls made by each function, definitions in each file
+ * and #include directives) are not stored, but rather re-created when the
+ * index is loaded.
+ * @author Elad Lahav
+ */
+class SymbolIndex
+{
+public:
+	/**
+	 * Kinds of symbol occurrences.
+	 */
+	enum Kind
+	{
+		/** The symbol is defined. */
+		Definition,
+		/** The symbol is referenced. */
+		Reference,
+		/** The symbol is called as a function (also a reference). */
+		Call,
+		/** The symbol is a file name in an #include directive. */
+		Include
+	};
+
+	/**
+	 * An occurrence of a symbol.
+	 */
+	struct Record
+	{
+		/**
+		 * Position of the symbol in the name table.
+		 */
+		quint32 symbol_;
+
+		/**
+		 * Position of the file in the file table.
+		 */
+		quint32 file_;
+
+		/**
+		 * Line number.
+		 */
+		quint32 line_;
+
+		/**
+		 * Position of the enclosing function or structure in the name table,
+		 * NoSymbol for the global scope.
+		 */
+		quint32 scope_;
+
+		/**
+		 * A value of Kind.
+		 */
+		quint8 kind_;
+
+		/**
+		 * A value of Core::Tag::Type (definitions only).
+		 */
+		quint8 tagType_;
+	};
+
+	/**
+	 * Marks an invalid name table position.
+	 */
+	static const quint32 NoSymbol = 0xffffffff;
+
+	SymbolIndex();
+	~SymbolIndex();
+
+	void clear();
+	quint32 addFile(const QString&);
+	quint32 addSymbol(const QByteArray&);
+	void addRecord(quint32, quint32, quint32, quint32, Kind,
+	               Core::Tag::Type tagType = Core::Tag::UnknownTag);
+	void finalize();
+
+	bool load(const QString&);
+	bool save(const QString&) const;
+
+	/**
+	 * @return true if the index holds no files
+	 */
+	bool isEmpty() const { return files_.isEmpty(); }
+
+	/**
+	 * @return The list of indexed files
+	 */
+	const QStringList& files() const { return files_; }
+
+	/**
+	 * @return The number of symbols in the name table
+	 */
+	quint32 symbolCount() const { return names_.size(); }
+
+	/**
+	 * @param  symbol  A name table position
+	 * @return The symbol's name
+	 */
+	const QByteArray& name(quint32 symbol) const { return names_[symbol]; }
+
+	/**
+	 * @param  name  A symbol name
+	 * @return The position of the symbol in the name table, NoSymbol if not
+	 *         found
+	 */
+	quint32 lookup(const QByteArray& name) const {
+		return nameMap_.value(name, NoSymbol);
+	}
+
+	/**
+	 * @param  rec  A record index
+	 * @return The record at the given index
+	 */
+	const Record& record(quint32 rec) const { return records_[rec]; }
+
+	/**
+	 * Returns the range of records for a symbol.
+	 * @param  symbol  A name table position
+	 * @param  begin   Holds the index of the first record, on return
+	 * @param  end     Holds the index past the last record, on return
+	 */
+	void symbolRecords(quint32 symbol, quint32& begin, quint32& end) const {
+		begin = symbolStart_[symbol];
+		end = symbolStart_[symbol + 1];
+	}
+
+	/**
+	 * @param  scope  A name table position of a function
+	 * @return Indices of Call records made from within that function
+	 */
+	QVector<quint32> callsFrom(quint32 scope) const {
+		return callMap_.value(scope);
+	}
+
+	/**
+	 * @param  file  A file table position
+	 * @return Indices of Definition records in that file
+	 */
+	QVector<quint32> definitionsIn(quint32 file) const {
+		return fileDefMap_.value(file);
+	}
+
+	/**
+	 * @return Indices of all Include records
+	 */
+	const QVector<quint32>& includes() const { return includes_; }
+
+private:
+	/**
+	 * The file table.
+	 */
+	QStringList files_;
+
+	/**
+	 * The name table.
+	 */
+	QList<QByteArray> names_;
+
+	/**
+	 * Maps names to their positions in the name table.
+	 */
+	QHash<QByteArray, quint32> nameMap_;
+
+	/**
+	 * Symbol occurrences, sorted by symbol once finalize() is called.
+	 */
+	QVector<Record> records_;
+
+	/**
+	 * For each symbol, the index of its first record in records_.
+	 * Holds an extra entry for the end of the last range.
+	 */
+	QVector<quint32> symbolStart_;
+
+	/**
+	 * Maps functions to the calls they make.
+	 */
+	QHash<quint32, QVector<quint32> > callMap_;
+
+	/**
+	 * Maps files to the symbols they define.
+	 */
+	QHash<quint32, QVector<quint32> > fileDefMap_;
+
+	/**
+	 * All #include directives.
+	 */
+	QVector<quint32> includes_;
+
+	void buildSecondary();
+};
+
+} // namespace Native
+
+} // namespace KScope
+
+#endif // __NATIVE_SYMBOLINDEX_H__
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include "textsearch.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * Class constructor.
+ * @param  conn    The connection to report results to
+ * @param  path    The directory relative to which file paths are resolved
+ * @param  files   The files to search
+ * @param  query   The query parameters
+ * @param  parent  Parent object
+ */
+TextSearch::TextSearch(Core::Engine::Connection* conn, const QString& path,
+                       const QStringList& files, const Core::Query& query,
+                       QObject* parent)
+	: QThread(parent), conn_(conn), path_(path), files_(files), query_(query),
+	  stop_(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+TextSearch::~TextSearch()
+{
+	stop_ = 1;
+	wait();
+}
+
+/**
+ * Cancels the search.
+ * The connection is detached and notified immediately, as its owner may be
+ * destroyed before the thread terminates.
+ */
+void TextSearch::stop()
+{
+	stop_ = 1;
+
+	if (conn_) {
+		Core::Engine::Connection* conn = conn_;
+		conn_ = NULL;
+		conn->setCtrlObject(NULL);
+		conn->onAborted();
+	}
+}
+
+/**
+ * Thread function.
+ * Reads each file, and records the lines matching the query pattern.
+ */
+void TextSearch::run()
+{
+	QDir dir(path_);
+	QRegExp re(query_.pattern_,
+	           (query_.flags_ & Core::Query::IgnoreCase)
+	           ? Qt::CaseInsensitive : Qt::CaseSensitive,
+	           (query_.flags_ & Core::Query::RegExp)
+	           ? QRegExp::RegExp2 : QRegExp::FixedString);
+
+	uint total = files_.size();
+	for (uint i = 0; i < total; i++) {
+		if (stop_)
+			return;
+
+		if ((i & 0x3f) == 0)
+			emit progress(i, total);
+
+		QFile file(dir.absoluteFilePath(files_[i]));
+		if (!file.open(QIODevice::ReadOnly))
+			continue;
+
+		QList<QByteArray> lines = file.readAll().split('\n');
+		for (int l = 0; l < lines.size(); l++) {
+			QString text = QString::fromLocal8Bit(lines[l]);
+			if (re.indexIn(text) == -1)
+				continue;
+
+			Core::Location loc(files_[i], l + 1);
+			loc.text_ = text.trimmed();
+			locList_.append(loc);
+		}
+	}
+
+	emit progress(total, total);
+}
+
+} // namespace Native
+
+} // namespace KScope
@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __NATIVE_TEXTSEARCH_H__
+#define __NATIVE_TEXTSEARCH_H__
+
+#include <QThread>
+#include <QStringList>
+#include <QAtomicInt>
+#include <core/engine.h>
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * Searches the contents of a list of files for a pattern.
+ * Free-text queries cannot be answered from the symbol index, so files are
+ * scanned in a separate thread.
+ * @author Elad Lahav
+ */
+class TextSearch : public QThread, public Core::Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	TextSearch(Core::Engine::Connection*, const QString&, const QStringList&,
+	           const Core::Query&, QObject* parent = 0);
+	~TextSearch();
+
+	virtual void stop();
+
+	/**
+	 * @return true if the search was cancelled, false otherwise
+	 */
+	bool isCancelled() const { return stop_ != 0; }
+
+	/**
+	 * @return The connection for this search, NULL if the search was
+	 *         cancelled
+	 */
+	Core::Engine::Connection* connection() const { return conn_; }
+
+	/**
+	 * @return The matching lines (only valid once the thread has finished)
+	 */
+	const Core::LocationList& results() const { return locList_; }
+
+signals:
+	void progress(uint cur, uint total);
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The connection to report results to.
+	 */
+	Core::Engine::Connection* conn_;
+
+	/**
+	 * The directory relative to which file paths are resolved.
+	 */
+	QString path_;
+
+	/**
+	 * The files to search.
+	 */
+	QStringList files_;
+
+	/**
+	 * The query parameters.
+	 */
+	Core::Query query_;
+
+	/**
+	 * Matching lines.
+	 */
+	Core::LocationList locList_;
+
+	/**
+	 * Set to stop the search.
+	 */
+	QAtomicInt stop_;
+};
+
+} // namespace Native
+
+} // namespace KScope
+
+#endif // __NATIVE_TEXTSEARCH_H__
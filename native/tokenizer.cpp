@@ -0,0 +1,271 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <cstring>
+#include "tokenizer.h"
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * @param  c  A character
+ * @return true if the character can start an identifier
+ */
+static inline bool isIdentStart(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+	       || c == '$' || (uchar)c >= 0x80;
+}
+
+/**
+ * @param  c  A character
+ * @return true if the character can appear in an identifier
+ */
+static inline bool isIdentChar(char c)
+{
+	return isIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+/**
+ * @param  str  The beginning of an identifier
+ * @param  len  The length of the identifier
+ * @return true if the identifier is an encoding prefix for a string or
+ *         character literal (L, u, U, u8, R, etc.)
+ */
+static inline bool isLiteralPrefix(const char* str, int len)
+{
+	if (len > 3)
+		return false;
+
+	for (int i = 0; i < len; i++) {
+		if (strchr("LuUR8", str[i]) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Class constructor.
+ * @param  src  The source code to split (must outlive the object)
+ */
+Tokenizer::Tokenizer(const QByteArray& src)
+	: src_(src.constData()), size_(src.size()), pos_(0), line_(1), bol_(true)
+{
+}
+
+/**
+ * Extracts the next token from the source.
+ * @param  tok  Holds the token information, on return
+ * @return true if a token was found, false at the end of the input
+ */
+bool Tokenizer::next(Token& tok)
+{
+	skipSpace();
+
+	tok.pos_ = pos_;
+	tok.line_ = line_;
+	tok.bol_ = bol_;
+	bol_ = false;
+
+	if (pos_ >= size_) {
+		tok.type_ = Token::End;
+		tok.len_ = 0;
+		tok.ch_ = 0;
+		return false;
+	}
+
+	char c = src_[pos_];
+	tok.ch_ = c;
+
+	if (isIdentStart(c)) {
+		while (pos_ < size_ && isIdentChar(src_[pos_]))
+			pos_++;
+
+		// Handle wide and raw string prefixes as part of the literal.
+		if (pos_ < size_ && (src_[pos_] == '"' || src_[pos_] == '\'')
+		    && isLiteralPrefix(src_ + tok.pos_, pos_ - tok.pos_)) {
+			char q = src_[pos_];
+			tok.type_ = (q == '"') ? Token::String : Token::Char;
+			skipLiteral(q);
+		}
+		else {
+			tok.type_ = Token::Identifier;
+		}
+	}
+	else if (c >= '0' && c <= '9') {
+		// Consume digits, letters, dots and signed exponents.
+		tok.type_ = Token::Number;
+		pos_++;
+		while (pos_ < size_) {
+			char d = src_[pos_];
+			if (isIdentChar(d) || d == '.') {
+				pos_++;
+			}
+			else if ((d == '+' || d == '-')
+			         && (src_[pos_ - 1] == 'e' || src_[pos_ - 1] == 'E'
+			             || src_[pos_ - 1] == 'p' || src_[pos_ - 1] == 'P')) {
+				pos_++;
+			}
+			else {
+				break;
+			}
+		}
+	}
+	else if (c == '"' || c == '\'') {
+		tok.type_ = (c == '"') ? Token::String : Token::Char;
+		skipLiteral(c);
+	}
+	else {
+		tok.type_ = Token::Punct;
+		pos_++;
+
+		// Keep scope and member-pointer operators as single tokens, as they
+		// affect the interpretation of the surrounding identifiers.
+		if (pos_ < size_
+		    && ((c == ':' && src_[pos_] == ':')
+		        || (c == '-' && src_[pos_] == '>'))) {
+			pos_++;
+		}
+	}
+
+	tok.len_ = pos_ - tok.pos_;
+	return true;
+}
+
+/**
+ * Consumes the remainder of the current logical line.
+ * Used for preprocessor directives whose arguments are not C tokens (e.g.,
+ * the file name in an #include directive).
+ * @return The text, with leading and trailing whitespace removed
+ */
+QByteArray Tokenizer::restOfLine()
+{
+	int start = pos_;
+	while (pos_ < size_) {
+		if (src_[pos_] == '\n') {
+			if (pos_ > start && src_[pos_ - 1] == '\\') {
+				line_++;
+				pos_++;
+				continue;
+			}
+
+			break;
+		}
+
+		// Stop at the beginning of a comment.
+		if (src_[pos_] == '/' && pos_ + 1 < size_
+		    && (src_[pos_ + 1] == '/' || src_[pos_ + 1] == '*')) {
+			break;
+		}
+
+		pos_++;
+	}
+
+	return QByteArray(src_ + start, pos_ - start).trimmed();
+}
+
+/**
+ * Skips whitespace and comments, updating the line counter.
+ */
+void Tokenizer::skipSpace()
+{
+	while (pos_ < size_) {
+		char c = src_[pos_];
+
+		if (c == '\n') {
+			line_++;
+			pos_++;
+			bol_ = true;
+		}
+		else if (c == ' ' || c == '\t' || c == '\r' || c == '\f'
+		         || c == '\v') {
+			pos_++;
+		}
+		else if (c == '\\' && pos_ + 1 < size_ && src_[pos_ + 1] == '\n') {
+			// Line continuation: does not start a new logical line.
+			line_++;
+			pos_ += 2;
+		}
+		else if (c == '/' && pos_ + 1 < size_ && src_[pos_ + 1] == '/') {
+			// Line comment: skip to the end of the line, but leave the
+			// newline character to be handled above.
+			pos_ += 2;
+			while (pos_ < size_ && src_[pos_] != '\n')
+				pos_++;
+		}
+		else if (c == '/' && pos_ + 1 < size_ && src_[pos_ + 1] == '*') {
+			// Block comment.
+			pos_ += 2;
+			while (pos_ < size_
+			       && !(src_[pos_] == '*' && pos_ + 1 < size_
+			            && src_[pos_ + 1] == '/')) {
+				if (src_[pos_] == '\n')
+					line_++;
+				pos_++;
+			}
+			pos_ += 2;
+		}
+		else {
+			break;
+		}
+	}
+
+	if (pos_ > size_)
+		pos_ = size_;
+}
+
+/**
+ * Skips a string or character literal.
+ * Unterminated literals end at the end of the line.
+ * @param  quote  The quote character that terminates the literal
+ */
+void Tokenizer::skipLiteral(char quote)
+{
+	// Skip the opening quote.
+	pos_++;
+
+	while (pos_ < size_) {
+		char c = src_[pos_];
+		if (c == quote) {
+			pos_++;
+			return;
+		}
+
+		if (c == '\\' && pos_ + 1 < size_) {
+			if (src_[pos_ + 1] == '\n')
+				line_++;
+			pos_ += 2;
+			continue;
+		}
+
+		if (c == '\n')
+			return;
+
+		pos_++;
+	}
+}
+
+} // namespace Native
+
+} // namespace KScope
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __NATIVE_TOKENIZER_H__
+#define __NATIVE_TOKENIZER_H__
+
+#include <QByteArray>
+
+namespace KScope
+{
+
+namespace Native
+{
+
+/**
+ * A lexical token in C/C++ source code.
+ * Tokens refer to the source buffer, rather than hold a copy of their text.
+ */
+struct Token
+{
+	enum Type
+	{
+		/** End of input. */
+		End,
+		/** An identifier or a keyword. */
+		Identifier,
+		/** A numeric literal. */
+		Number,
+		/** A string literal. */
+		String,
+		/** A character literal. */
+		Char,
+		/** Any other character (or a "::" or "->" pair). */
+		Punct
+	};
+
+	/**
+	 * The token type.
+	 */
+	Type type_;
+
+	/**
+	 * Offset of the first character in the source buffer.
+	 */
+	int pos_;
+
+	/**
+	 * The number of characters in the token.
+	 */
+	int len_;
+
+	/**
+	 * The line on which the token starts (1-based).
+	 */
+	uint line_;
+
+	/**
+	 * Whether this is the first token on a logical line (i.e., a line that
+	 * does not continue a previous one with a backslash).
+	 */
+	bool bol_;
+
+	/**
+	 * @param  c  A character
+	 * @return true if this is a single-character punctuation token for the
+	 *         given character, false otherwise
+	 */
+	bool is(char c) const { return type_ == Punct && len_ == 1 && ch_ == c; }
+
+	/**
+	 * The first character of the token.
+	 */
+	char ch_;
+};
+
+/**
+ * Splits C/C++ source code into tokens.
+ * Comments and whitespace are skipped. Preprocessor directives are not
+ * interpreted, but the bol_ flag on each token allows callers to identify
+ * them.
+ * @author Elad Lahav
+ */
+class Tokenizer
+{
+public:
+	Tokenizer(const QByteArray&);
+
+	bool next(Token&);
+
+	/**
+	 * @param  tok  A token returned by next()
+	 * @return The text of the token
+	 */
+	QByteArray text(const Token& tok) const {
+		return QByteArray(src_ + tok.pos_, tok.len_);
+	}
+
+	/**
+	 * Returns the text of a token without copying it.
+	 * The result is only valid as long as the source buffer is.
+	 * @param  tok  A token returned by next()
+	 * @return The text of the token
+	 */
+	QByteArray rawText(const Token& tok) const {
+		return QByteArray::fromRawData(src_ + tok.pos_, tok.len_);
+	}
+
+	/**
+	 * @param  tok  A token returned by next()
+	 * @param  str  A NULL-terminated string
+	 * @return true if the token text equals the string, false otherwise
+	 */
+	bool equals(const Token& tok, const char* str) const {
+		return qstrncmp(src_ + tok.pos_, str, tok.len_) == 0
+		       && str[tok.len_] == 0;
+	}
+
+	QByteArray restOfLine();
+
+private:
+	/**
+	 * The source buffer.
+	 */
+	const char* src_;
+
+	/**
+	 * The size of the source buffer.
+	 */
+	int size_;
+
+	/**
+	 * The current position in the buffer.
+	 */
+	int pos_;
+
+	/**
+	 * The current line number.
+	 */
+	uint line_;
+
+	/**
+	 * Whether no token was returned yet on the current logical line.
+	 */
+	bool bol_;
+
+	void skipSpace();
+	void skipLiteral(char);
+};
+
+} // namespace Native
+
+} // namespace KScope
+
+#endif // __NATIVE_TOKENIZER_H__